@@ -0,0 +1,106 @@
+#ifndef CGROUP_DATA_H
+#define CGROUP_DATA_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/** Mount point of the unified (v2) cgroup hierarchy */
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+/** Number of scans kept for throttling/pressure ranking (2 s each) */
+#define CGROUP_STALL_WINDOW 30
+
+/* Counter deltas of one scan, kept in a ring per cgroup */
+typedef struct {
+    guint64 elapsed_usec;
+    guint64 nr_throttled;
+    guint64 throttled_usec;
+    guint64 cpu_some_usec;      // cpu.pressure "some" total
+    guint64 mem_some_usec;      // memory.pressure "some" total
+    guint64 mem_full_usec;
+    guint64 mem_high;           // memory.events
+    guint64 mem_max;
+    guint64 oom_kill;
+} CgroupStallSample;
+
+typedef struct {
+    gchar *path;        // relative to CGROUP_ROOT, "" for the root cgroup
+    gchar *name;        // last path component ("/" for the root)
+    gint depth;
+
+    // Raw counters from the last scan
+    guint64 usage_usec;         // cpu.stat
+    guint64 user_usec;
+    guint64 system_usec;
+    guint64 memory_current;     // memory.current, bytes
+    guint64 memory_anon;        // memory.stat
+    guint64 memory_file;
+    guint64 io_rbytes;          // io.stat, summed over devices
+    guint64 io_wbytes;
+    guint64 pids_current;       // pids.current
+    guint64 nr_throttled;       // cpu.stat, only with a cpu.max quota
+    guint64 throttled_usec;
+    guint64 cpu_some_total;     // cpu.pressure, usec
+    guint64 mem_some_total;     // memory.pressure, usec
+    guint64 mem_full_total;
+    guint64 events_high;        // memory.events
+    guint64 events_max;
+    guint64 events_oom_kill;
+    gboolean has_memory;        // controller files present
+    gboolean has_io;
+    gboolean has_pids;
+    gboolean has_pressure;
+
+    // Rates since the previous scan
+    gdouble cpu_percent;        // share of all CPUs, 0-100
+    gdouble io_read_kbps;
+    gdouble io_write_kbps;
+
+    gdouble cpu_history[MAX_POINTS];
+    gdouble mem_history[MAX_POINTS];   // MB
+    gint history_index;
+
+    // Sliding window of stall counters and its running sums
+    CgroupStallSample stall_window[CGROUP_STALL_WINDOW];
+    CgroupStallSample stall_sum;
+    gint stall_index;
+
+    guint last_seen;
+} CgroupInfo;
+
+void cgroup_data_init(void);
+void cgroup_data_cleanup(void);
+void cgroup_data_update(void);
+
+// Cgroups from the last scan in depth-first order (parents before children)
+gint cgroup_get_count(void);
+const CgroupInfo* cgroup_get_info(gint index);
+const CgroupInfo* cgroup_lookup(const gchar *path);
+
+typedef struct {
+    const CgroupInfo *cgroup;
+    gdouble throttled_percent;  // time throttled over the window
+    gdouble cpu_pressure;       // share of the window with some task waiting for CPU
+    gdouble mem_pressure;       // same for memory (some)
+    guint64 throttles;          // throttled periods in the window
+    guint64 mem_high;           // memory.events in the window
+    guint64 mem_max;
+    guint64 oom_kills;
+    gdouble score;
+} CgroupStallRank;
+
+/**
+ * cgroup_get_worst_stalls:
+ * @out: (out caller-allocates): array of at least @max entries
+ * @max: maximum number of entries to return
+ *
+ * Ranks non-root cgroups by how much they were throttled or stalled on
+ * CPU/memory over the last %CGROUP_STALL_WINDOW scans, worst first.
+ * Cgroups without any throttling, pressure or memory events are skipped.
+ *
+ * Returns: number of entries written to @out
+ */
+gint cgroup_get_worst_stalls(CgroupStallRank *out, gint max);
+
+#endif // CGROUP_DATA_H
@@ -5,11 +5,18 @@
  *  Global configuration constants
  * ------------------------------------------------------------------*/
 
-/** Number of data points kept for each history graph */
+/** Number of data points kept for each history graph. Can be raised at
+ *  build time (-DMAX_POINTS=3600); graphs with more points than pixel
+ *  columns are decimated per column when drawn */
+#ifndef MAX_POINTS
 #define MAX_POINTS 60
+#endif
 
 /** Maximum number of CPU cores the monitor will track */
-#define MAX_CPU_CORES 64
+#define MAX_CPU_CORES 256
+
+/** Maximum number of NUMA nodes (or packages) grouped in the per-core view */
+#define MAX_NUMA_NODES 16
 
 /** Maximum number of disks exposed simultaneously */
 #define MAX_DISKS 8
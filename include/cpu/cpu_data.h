@@ -29,11 +29,73 @@ const gchar* get_cpu_address_sizes(void);
 gdouble get_current_cpu_usage(void);
 const gdouble* get_cpu_usage_history(void);
 gint get_cpu_usage_history_index(void);
+// Number of updates so far, shared by every per-CPU history
+guint64 get_cpu_sample_count(void);
 
 // Getter functions for per-CPU usage
 gdouble get_cpu_usage_by_core(gint core_id);
 const gdouble* get_cpu_usage_history_by_core(gint core_id);
+
+/* Time split by state, in % of the last interval. User excludes guest time,
+ * which /proc/stat also counts under user/nice; idle is what is left over. */
+typedef enum {
+    CPU_STATE_USER,      // user + nice
+    CPU_STATE_SYSTEM,
+    CPU_STATE_IOWAIT,
+    CPU_STATE_IRQ,
+    CPU_STATE_SOFTIRQ,
+    CPU_STATE_STEAL,
+    CPU_STATE_GUEST,     // guest + guest_nice
+    CPU_N_STATES
+} CpuState;
+
+const gchar* get_cpu_state_name(CpuState state);
+// @core_id -1 selects the whole-system line
+gdouble get_cpu_state_percent(gint core_id, CpuState state);
+const gdouble* get_cpu_state_history(gint core_id, CpuState state);
+
+// Average busy % per topology group (see cpu_topology.h)
+gdouble get_cpu_group_usage(gint group);
+const gdouble* get_cpu_group_usage_history(gint group);
+
+/* System-wide scheduler counters from /proc/stat and /proc/loadavg; the
+ * first three are per-second rates, the rest current values */
+typedef enum {
+    CPU_SCHED_CTXT,         // context switches
+    CPU_SCHED_INTR,         // interrupts, all sources
+    CPU_SCHED_FORKS,        // "processes": forks and clones
+    CPU_SCHED_RUNNING,      // procs_running
+    CPU_SCHED_BLOCKED,      // procs_blocked, tasks waiting on I/O (D state)
+    CPU_SCHED_LOAD1,        // 1-minute load average
+    CPU_N_SCHED_COUNTERS
+} CpuSchedCounter;
+
+const gchar* get_cpu_sched_counter_name(CpuSchedCounter counter);
+gdouble get_cpu_sched_counter(CpuSchedCounter counter);
+const gdouble* get_cpu_sched_counter_history(CpuSchedCounter counter);  // raw values, not 0-100
+void get_cpu_load_average(gdouble *load1, gdouble *load5, gdouble *load15);
+
 gboolean get_show_per_cpu_graphs(void);
 void set_show_per_cpu_graphs(gboolean show);
 
+// Run-queue wait per CPU from /proc/schedstat
+gboolean get_cpu_runqueue_available(void);
+gdouble get_cpu_runqueue_wait_by_core(gint core_id);            // ms waited per second
+const gdouble* get_cpu_runqueue_history_by_core(gint core_id);  // % of wall time, 0-100
+
+/* Per-core process attribution, fed by the process scanner from the last-run
+ * CPU (stat field 39) of each process */
+#define CPU_CORE_TOP_PROCESSES 5
+
+typedef struct {
+    guint pid;
+    gchar name[32];
+    gdouble core_percent;   // share of that one core
+} CpuCoreProcess;
+
+void cpu_core_attribution_begin(void);
+void cpu_core_attribution_add(gint core_id, guint pid, const gchar *name, gdouble core_percent);
+void cpu_core_attribution_end(void);
+gint get_cpu_core_top_processes(gint core_id, const CpuCoreProcess **out);
+
 #endif // CPU_DATA_H
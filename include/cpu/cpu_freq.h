@@ -0,0 +1,43 @@
+#ifndef CPU_FREQ_H
+#define CPU_FREQ_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/* Per-core frequency from /sys/devices/system/cpu/cpu<N>/cpufreq and
+ * thermal_throttle. scaling_cur_freq and the throttle counters are kept open
+ * and re-read with pread every tick; governor and EPP change rarely and are
+ * re-read every CPU_FREQ_POLICY_TICKS ticks.
+ *
+ * Without cpufreq (most VMs) the "cpu MHz" lines of /proc/cpuinfo are used,
+ * also only every CPU_FREQ_POLICY_TICKS ticks. */
+
+#define CPU_FREQ_POLICY_TICKS 5
+
+void cpu_freq_init(gint num_cpus);
+void cpu_freq_update(void);
+void cpu_freq_cleanup(void);
+
+gboolean cpu_freq_has_cpufreq(void);
+gdouble cpu_freq_get_average_mhz(void);
+gdouble cpu_freq_get_mhz(gint cpu);
+gdouble cpu_freq_get_max_mhz(gint cpu);
+
+// Frequency history in % of the core's maximum, one point per update
+const gdouble* cpu_freq_get_history(gint cpu);
+gint cpu_freq_get_history_index(void);
+guint64 cpu_freq_get_sample_count(void);
+
+// NULL when the driver does not expose it; @cpu -1 gives the common value or "mixed"
+const gchar* cpu_freq_get_governor(gint cpu);
+const gchar* cpu_freq_get_epp(gint cpu);
+
+// thermal_throttle counters (x86); FALSE when absent
+gboolean cpu_freq_get_throttle_counts(gint cpu, guint64 *core_count, guint64 *package_count);
+// TRUE if the core or its package throttled during the last interval
+gboolean cpu_freq_is_throttling(gint cpu);
+// Core throttle events on all CPUs since startup
+guint64 cpu_freq_get_throttle_events(void);
+
+#endif // CPU_FREQ_H
@@ -0,0 +1,27 @@
+#ifndef CPU_IDLE_H
+#define CPU_IDLE_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/* Idle-state (C-state) residency per core from
+ * /sys/devices/system/cpu/cpu<N>/cpuidle/state<M>/{time,usage}. Up to 256
+ * counter files, within the shared fd budget (utils/fd_budget.h), are kept
+ * open and re-read with pread; the rest are opened on every read. */
+
+#define CPU_IDLE_MAX_STATES 10
+
+void cpu_idle_init(gint num_cpus);
+void cpu_idle_update(void);
+void cpu_idle_cleanup(void);
+
+gboolean cpu_idle_available(void);
+// States of the deepest-equipped CPU, shallowest first
+gint cpu_idle_get_state_count(void);
+const gchar* cpu_idle_get_state_name(gint state);
+
+gdouble cpu_idle_get_residency(gint cpu, gint state);    // % of the last interval spent in @state
+gdouble cpu_idle_get_usage_rate(gint cpu, gint state);   // entries per second
+
+#endif // CPU_IDLE_H
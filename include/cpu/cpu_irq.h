@@ -0,0 +1,51 @@
+#ifndef CPU_IRQ_H
+#define CPU_IRQ_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/* Per-CPU interrupt and softirq rates from /proc/interrupts and
+ * /proc/softirqs. Both files are kept open and re-read with pread into a
+ * reused buffer; each line is parsed in place in one pass. */
+
+typedef enum {
+    CPU_IRQ_HARD,
+    CPU_IRQ_SOFT
+} CpuIrqKind;
+
+typedef struct {
+    gchar name[16];                 // "24", "NMI", "LOC", "NET_RX"
+    gchar desc[64];                 // chip, hwirq and action, e.g. "PCI-MSI 524288-edge eth0-TxRx-0"
+    CpuIrqKind kind;
+    gdouble rate[MAX_CPU_CORES];    // per second, indexed by CPU id
+    gdouble total_rate;
+    gint busiest_cpu;
+    guint64 prev[MAX_CPU_CORES];
+    gboolean have_prev;
+    guint seen_tick;                // last update that listed the source
+} CpuIrqSource;
+
+void cpu_irq_init(void);
+void cpu_irq_update(void);
+void cpu_irq_cleanup(void);
+
+gboolean cpu_irq_available(void);
+
+/**
+ * cpu_irq_get_top:
+ * @kind: CPU_IRQ_HARD, CPU_IRQ_SOFT, or -1 for both
+ * @out: (out caller-allocates): Array of at least @max pointers
+ * @max: Number of sources wanted
+ *
+ * Fills @out with the sources of @kind with the highest total rate, busiest
+ * first. Idle sources are left out.
+ *
+ * Returns: number of entries written
+ */
+gint cpu_irq_get_top(gint kind, const CpuIrqSource **out, gint max);
+
+// Highest single per-CPU rate over all sources, for scaling the heatmap
+gdouble cpu_irq_get_max_rate(void);
+
+#endif // CPU_IRQ_H
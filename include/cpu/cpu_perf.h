@@ -0,0 +1,56 @@
+#ifndef CPU_PERF_H
+#define CPU_PERF_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/* Optional per-CPU counters from perf_event_open(2). Each CPU gets one
+ * counter group read in a single read() with PERF_FORMAT_GROUP. Hardware
+ * events are tried first; without a PMU (most VMs) the software events
+ * task-clock, context-switches and page-faults are used instead.
+ *
+ * System-wide counting needs CAP_PERFMON or kernel.perf_event_paranoid <= 0. */
+
+/** 100% on the IPC graphs */
+#define CPU_PERF_IPC_SCALE 4.0
+
+#define CPU_PERF_ERROR (cpu_perf_error_quark())
+GQuark cpu_perf_error_quark(void);
+
+typedef enum {
+    CPU_PERF_ERROR_PERMISSION,
+    CPU_PERF_ERROR_UNSUPPORTED
+} CpuPerfError;
+
+typedef enum {
+    CPU_PERF_OFF,
+    CPU_PERF_HARDWARE,
+    CPU_PERF_SOFTWARE
+} CpuPerfMode;
+
+typedef struct {
+    // Hardware mode
+    gdouble ipc;                // instructions per cycle
+    gdouble llc_mpki;           // last-level cache misses per 1000 instructions
+    gdouble branch_mpki;        // branch misses per 1000 instructions
+    gdouble cycles_ghz;         // unhalted cycles per second
+    // Software mode
+    gdouble busy_percent;       // task-clock share of the interval
+    gdouble ctx_switches;       // per second
+    gdouble page_faults;        // per second
+    gboolean multiplexed;       // the group did not run the whole interval
+} CpuPerfSample;
+
+gboolean cpu_perf_enable(gint num_cpus, GError **error);
+void cpu_perf_disable(void);
+void cpu_perf_update(void);
+
+CpuPerfMode cpu_perf_get_mode(void);
+const CpuPerfSample* cpu_perf_get_sample(gint cpu);
+// IPC (hardware, scaled by CPU_PERF_IPC_SCALE) or busy % (software), 0-100
+const gdouble* cpu_perf_get_history(gint cpu);
+gint cpu_perf_get_history_index(void);
+guint64 cpu_perf_get_sample_count(void);
+
+#endif // CPU_PERF_H
@@ -0,0 +1,36 @@
+#ifndef CPU_RAPL_H
+#define CPU_RAPL_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/* Package, core, uncore and DRAM power from the RAPL powercap zones
+ * (<root>/intel-rapl:<pkg>[:<sub>]/energy_uj; AMD uses the same names).
+ * energy_uj stays open and is re-read with pread; a counter that went
+ * backwards wrapped at max_energy_range_uj. */
+
+/** Default powercap root; KHOS_POWERCAP_ROOT overrides it to run against fixture files */
+#define CPU_RAPL_ROOT "/sys/class/powercap"
+
+#define CPU_RAPL_MAX_DOMAINS 16
+
+// @root: NULL for CPU_RAPL_ROOT
+void cpu_rapl_init(const gchar *root);
+void cpu_rapl_update(void);
+// @now_us: monotonic time of the read; cpu_rapl_update() passes g_get_monotonic_time()
+void cpu_rapl_update_at(gint64 now_us);
+void cpu_rapl_cleanup(void);
+
+gint cpu_rapl_get_domain_count(void);
+// "package-0", or "package-0/core" for a subzone
+const gchar* cpu_rapl_get_domain_name(gint domain);
+// Top-level zone (package, psys); subzones are already counted in their package
+gboolean cpu_rapl_is_package(gint domain);
+gdouble cpu_rapl_get_watts(gint domain);
+const gdouble* cpu_rapl_get_history(gint domain);     // watts
+gint cpu_rapl_get_history_index(void);
+// Zones exist but energy_uj is root-only (the default since the 2020 RAPL side-channel fixes)
+gboolean cpu_rapl_permission_denied(void);
+
+#endif // CPU_RAPL_H
@@ -0,0 +1,36 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/* CPU topology from /sys/devices/system/cpu/cpu<N>/topology and
+ * /sys/devices/system/node, read once at startup.
+ *
+ * CPUs are grouped by NUMA node when there is more than one, otherwise by
+ * package, so a dual-socket host always gets one group per socket. */
+
+typedef struct {
+    gint cpu;       // logical CPU id
+    gint package;   // physical_package_id
+    gint core;      // core_id, unique within its package
+    gint node;      // NUMA node id, 0 without NUMA
+    gint group;     // dense group index, 0 .. cpu_topology_get_group_count() - 1
+} CpuTopoEntry;
+
+void cpu_topology_init(gint num_cpus);
+
+// Logical CPUs ordered by group, package and core, so SMT siblings are adjacent
+const CpuTopoEntry* cpu_topology_get_ordered(gint *count);
+const CpuTopoEntry* cpu_topology_get_cpu(gint cpu);
+
+gint cpu_topology_get_packages(void);
+gint cpu_topology_get_physical_cores(void);
+gint cpu_topology_get_nodes(void);
+gint cpu_topology_get_threads_per_core(void);
+
+gint cpu_topology_get_group_count(void);
+void cpu_topology_get_group_label(gint group, gchar *buf, gsize buf_size);
+
+#endif // CPU_TOPOLOGY_H
@@ -21,6 +21,7 @@ typedef struct {
     gdouble vram_history[GPU_MAX_POINTS];
     gint history_index;
     gint gpu_id;  // ID to identify this GPU
+    gchar pci_slot[32];  // e.g. "0000:03:00.0", matches drm-pdev in fdinfo; empty if unknown
 } GPUInfo;
 
 void gpu_data_init(void);
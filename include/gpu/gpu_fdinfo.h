@@ -0,0 +1,59 @@
+#ifndef GPU_FDINFO_H
+#define GPU_FDINFO_H
+
+#include <glib.h>
+
+/* Per-process GPU usage from the DRM fdinfo interface
+ * (Documentation/gpu/drm-usage-stats.rst). Every DRM file descriptor exposes
+ * drm-engine-*, drm-memory-* and a drm-client-id in /proc/<pid>/fdinfo/<fd>;
+ * clients shared between fds or processes are only counted once. */
+
+#define DRM_MAX_ENGINES 8
+
+typedef struct {
+    gchar name[24];
+    guint64 busy_ns;        // drm-engine-<name>
+    guint64 cycles;         // drm-cycles-<name>
+    guint64 total_cycles;   // drm-total-cycles-<name>
+    guint capacity;         // drm-engine-capacity-<name>, 1 if absent
+} DrmEngineSample;
+
+typedef struct {
+    gchar driver[32];
+    gchar pdev[32];
+    guint64 client_id;
+    gboolean has_client_id;
+    DrmEngineSample engines[DRM_MAX_ENGINES];
+    guint n_engines;
+    guint64 vram_bytes;     // resident (or legacy drm-memory-) vram/local regions
+    guint64 system_bytes;   // gtt/system/stolen regions
+} DrmFdinfo;
+
+typedef struct {
+    guint pid;
+    gchar comm[64];
+    gchar pdev[32];             // empty for the per-process total
+    gdouble busy_percent;       // busiest engine, 0-100
+    gchar busy_engine[24];
+    guint64 vram_bytes;
+    guint64 system_bytes;
+} GpuProcessUsage;
+
+// Parse the text of one fdinfo file. Returns FALSE if it is not a DRM fd.
+gboolean gpu_fdinfo_parse(const gchar *text, DrmFdinfo *out);
+
+// Point the collector at another procfs tree (fixtures); NULL restores /proc
+void gpu_fdinfo_set_proc_root(const gchar *root);
+
+// Rescan; calls closer than half a second apart reuse the previous result
+void gpu_fdinfo_update(void);
+void gpu_fdinfo_update_at(gint64 now_us);
+void gpu_fdinfo_cleanup(void);
+
+// Totals across all GPUs for one process, or NULL if it has no DRM clients
+const GpuProcessUsage* gpu_fdinfo_get_process(guint pid);
+
+// Heaviest consumers of one GPU (by busy %, then VRAM); NULL/empty pdev = any GPU
+guint gpu_fdinfo_get_top(const gchar *pdev, const GpuProcessUsage **out, guint max_out);
+
+#endif // GPU_FDINFO_H
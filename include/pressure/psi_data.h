@@ -0,0 +1,83 @@
+#ifndef PSI_DATA_H
+#define PSI_DATA_H
+
+#include <glib.h>
+
+#include "config.h"
+
+/** Directory of the system-wide Pressure Stall Information files */
+#define PSI_ROOT "/proc/pressure"
+
+/** Default trigger: wake when tasks stall for 100 ms within a 2 s window.
+ *  Unprivileged triggers need a window that is a multiple of 2 s. */
+#define PSI_TRIGGER_STALL_US 100000
+#define PSI_TRIGGER_WINDOW_US 2000000
+
+#define PSI_ERROR (psi_error_quark())
+GQuark psi_error_quark(void);
+
+typedef enum {
+    PSI_ERROR_UNSUPPORTED,     // kernel built without PSI or psi=0
+    PSI_ERROR_PERMISSION,      // trigger needs CAP_SYS_RESOURCE on this kernel
+    PSI_ERROR_FAILED
+} PsiError;
+
+typedef enum {
+    PSI_CPU,
+    PSI_MEMORY,
+    PSI_IO,
+    PSI_N_RESOURCES
+} PsiResource;
+
+/* One "some" or "full" line */
+typedef struct {
+    gdouble avg10;
+    gdouble avg60;
+    gdouble avg300;
+    guint64 total;      // cumulative stall time, usec
+} PsiLine;
+
+typedef struct {
+    gboolean available;
+    gboolean has_full;          // cpu "full" is only meaningful for cgroups and reads 0 system-wide
+    PsiLine some;
+    PsiLine full;
+    gdouble some_percent;       // share of the last interval stalled, from the total delta
+    gdouble full_percent;
+    guint64 trigger_events;     // trigger wakeups since they were enabled
+} PsiStats;
+
+/* Called from the main loop when a trigger fires, after the stats were refreshed */
+typedef void (*PsiTriggerFunc)(PsiResource resource, gpointer user_data);
+
+void psi_data_init(void);
+void psi_data_cleanup(void);
+void psi_data_update(void);
+
+gboolean psi_is_available(void);
+const gchar* psi_get_resource_name(PsiResource resource);
+const PsiStats* psi_get_stats(PsiResource resource);
+
+// Stall percentage history (0-100), one point per update
+const gdouble* psi_get_some_history(PsiResource resource);
+const gdouble* psi_get_full_history(PsiResource resource);
+gint psi_get_history_index(void);
+
+/**
+ * psi_triggers_enable:
+ * @stall_us: Stall time that fires the trigger
+ * @window_us: Tracking window
+ * @func: Called when any resource crosses the threshold
+ *
+ * Writes a "some" trigger to every PSI file and polls it with G_IO_PRI, so a
+ * stall refreshes the stats immediately instead of at the next tick.
+ * Resources whose trigger cannot be registered are skipped.
+ *
+ * Returns: TRUE if at least one trigger is armed
+ */
+gboolean psi_triggers_enable(guint64 stall_us, guint64 window_us,
+                             PsiTriggerFunc func, gpointer user_data, GError **error);
+void psi_triggers_disable(void);
+gboolean psi_triggers_enabled(void);
+
+#endif // PSI_DATA_H
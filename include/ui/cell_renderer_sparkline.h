@@ -0,0 +1,23 @@
+#ifndef CELL_RENDERER_SPARKLINE_H
+#define CELL_RENDERER_SPARKLINE_H
+
+#include <gtk/gtk.h>
+#include "utils/proc_history.h"
+
+/*
+ * KhosCellRendererSparkline: draws a ProcHistoryRing inline in a tree view
+ * row, CPU as a filled line and memory as a thin overlay, each scaled to
+ * the ring's own peak. The ring is set from a cell data func right before
+ * rendering, so the model only needs to carry the PID.
+ */
+#define KHOS_TYPE_CELL_RENDERER_SPARKLINE (khos_cell_renderer_sparkline_get_type())
+G_DECLARE_FINAL_TYPE(KhosCellRendererSparkline, khos_cell_renderer_sparkline,
+                     KHOS, CELL_RENDERER_SPARKLINE, GtkCellRenderer)
+
+GtkCellRenderer* khos_cell_renderer_sparkline_new(void);
+
+/* @ring may be NULL, in which case the cell is left empty */
+void khos_cell_renderer_sparkline_set_ring(KhosCellRendererSparkline *self,
+                                           const ProcHistoryRing *ring);
+
+#endif // CELL_RENDERER_SPARKLINE_H
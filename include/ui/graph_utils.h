@@ -9,11 +9,12 @@
  * @widget: The widget to get the style context from
  * @bg: (out): Background color to fill
  * @fg: (out): Foreground/text color to fill  
- * @accent: (out): Accent color to fill
+ * @accent: (out) (nullable): Accent color to fill
  * @accent_fallback: CSS color string used as fallback for accent if theme lookup fails
  *
  * Retrieves theme colors from the given widget. Falls back to sensible
- * defaults if theme lookup fails.
+ * defaults if theme lookup fails. The colors are cached on @widget until
+ * its next style-updated, so this is cheap to call on every draw.
  */
 void graph_get_theme_colors(GtkWidget *widget,
                             GdkRGBA *bg,
@@ -32,6 +33,70 @@ void graph_get_theme_colors(GtkWidget *widget,
  */
 void graph_draw_background(cairo_t *cr, int width, int height, GdkRGBA *bg_color);
 
+/**
+ * graph_draw_background_layer:
+ * @cr: Cairo context
+ * @widget: The drawing widget
+ *
+ * Paints the theme background and grid of @widget from a layer rendered
+ * once per size and theme, instead of filling and stroking every frame.
+ */
+void graph_draw_background_layer(cairo_t *cr, GtkWidget *widget);
+
+/**
+ * GraphPlotFunc:
+ * @cr: Cairo context of the offscreen plot
+ * @width: Plot width; sample i is at i / (num_points - 1) * @width
+ * @height: Plot height
+ * @user_data: Data passed to graph_draw_scrolling()
+ *
+ * Draws the data of a graph (no background) over the whole width, e.g.
+ * with graph_draw_fill() and graph_draw_line().
+ */
+typedef void (*GraphPlotFunc)(cairo_t *cr, int width, int height, gpointer user_data);
+
+/**
+ * graph_draw_scrolling:
+ * @cr: Cairo context
+ * @widget: The drawing widget; it owns the plot surface
+ * @sample_count: Number of samples pushed into the histories so far; only
+ *   its increase since the last call matters
+ * @num_points: Total number of points in the histories
+ * @scale_key: Whatever the plot depends on besides the samples, such as an
+ *   autoscaled maximum; a different value forces a full redraw
+ * @plot: Draws the data
+ * @user_data: Passed to @plot
+ *
+ * Composites the plotted data of @widget over what @cr already holds
+ * (normally graph_draw_background_layer()). The plot is kept offscreen;
+ * when @sample_count advances it is shifted left by that many samples and
+ * @plot only has to rasterize a strip at the right edge. A resize, a theme
+ * change, a new @scale_key, the widget being mapped again or a gap of
+ * nearly a whole window since the last draw redraws all of it.
+ */
+void graph_draw_scrolling(cairo_t *cr, GtkWidget *widget,
+                          guint64 sample_count, gint num_points, gdouble scale_key,
+                          GraphPlotFunc plot, gpointer user_data);
+
+/**
+ * graph_invalidate_scrolling:
+ * @widget: The drawing widget
+ *
+ * Forces the next graph_draw_scrolling() on @widget to redraw everything,
+ * e.g. after switching the device whose history is plotted.
+ */
+void graph_invalidate_scrolling(GtkWidget *widget);
+
+/**
+ * graph_touch_scrolling:
+ * @widget: The drawing widget
+ *
+ * The newest sample changed in place without the history index moving,
+ * e.g. a decimated column that is still collecting samples. The next
+ * graph_draw_scrolling() re-plots the strip at the right edge anyway.
+ */
+void graph_touch_scrolling(GtkWidget *widget);
+
 /**
  * graph_draw_grid:
  * @cr: Cairo context
@@ -53,7 +118,9 @@ void graph_draw_grid(cairo_t *cr, int width, int height, GdkRGBA *fg_color);
  * @num_points: Total number of points in history
  * @accent_color: Color used for the fill
  *
- * Draws a gradient filled area under the graph curve.
+ * Draws a gradient filled area under the graph curve. Gradients are
+ * reused across calls with the same height and color. A history longer
+ * than @width is reduced to each pixel column's max.
  */
 void graph_draw_fill(cairo_t *cr, int width, int height,
                      const gdouble *history, gint history_idx,
@@ -70,12 +137,33 @@ void graph_draw_fill(cairo_t *cr, int width, int height,
  * @accent_color: Color used for the line
  * @line_width: Width of the stroke line
  *
- * Draws the graph line over the filled area.
+ * Draws the graph line over the filled area. A history longer than @width
+ * is reduced to each pixel column's min and max, so spikes stay visible
+ * and the path length is bounded by @width.
  */
 void graph_draw_line(cairo_t *cr, int width, int height,
                      const gdouble *history, gint history_idx,
                      gint num_points, GdkRGBA *accent_color, gdouble line_width);
 
+/**
+ * graph_draw_stacked:
+ * @cr: Cairo context
+ * @width: Widget width
+ * @height: Widget height
+ * @series: Array of @n_series histories (0-100 range), bottom band first
+ * @colors: One fill color per series
+ * @n_series: Number of series
+ * @history_idx: Current circular index into the histories
+ * @num_points: Total number of points in each history
+ *
+ * Draws the series as stacked areas; the running sum is clamped to 100.
+ * NULL entries in @series are skipped. A history longer than @width is
+ * reduced to each pixel column's mean.
+ */
+void graph_draw_stacked(cairo_t *cr, int width, int height,
+                        const gdouble *const *series, const GdkRGBA *colors, gint n_series,
+                        gint history_idx, gint num_points);
+
 /**
  * graph_draw:
  * @cr: Cairo context
@@ -104,24 +192,116 @@ void graph_draw(cairo_t *cr, int width, int height,
  * @num_cores: Number of CPU cores to draw
  * @get_history: Function to retrieve history for a given core index
  * @get_history_idx: Function to retrieve current history index
+ * @get_sample_count: Function to retrieve the number of samples taken so
+ *   far; the heatmap uses it to tell a step from a full wrap
  * @get_label: Function to generate the label text for each core
  * @bg_color: Background color
  * @fg_color: Foreground/text color
  * @accent_color: Accent color for graphs
  *
  * Draws a grid of per-core CPU usage graphs. This is a specialized
- * helper for the CPU tab's per-core mode.
+ * helper for the CPU tab's per-core mode: CPUs are laid out in topology
+ * order, grouped by NUMA node (or package) with SMT siblings side by side.
+ * Falls back to graph_draw_per_core_heatmap() when
+ * graph_per_core_use_heatmap() says so.
  */
 typedef const gdouble* (*GraphGetHistoryFunc)(gint index);
 typedef gint (*GraphGetHistoryIndexFunc)(void);
+typedef guint64 (*GraphGetSampleCountFunc)(void);
 typedef void (*GraphGetLabelFunc)(gint index, gchar *buf, gsize buf_size);
 
 void graph_draw_per_core_graphs(cairo_t *cr, GtkWidget *widget,
                                 gint num_cores,
                                 GraphGetHistoryFunc get_history,
                                 GraphGetHistoryIndexFunc get_history_idx,
+                                GraphGetSampleCountFunc get_sample_count,
                                 GraphGetLabelFunc get_label,
                                 GdkRGBA *bg_color, GdkRGBA *fg_color, GdkRGBA *accent_color,
                                 gint num_points);
 
+/**
+ * graph_per_core_index_at:
+ * @widget: The drawing widget
+ * @num_cores: Number of CPU cores drawn
+ * @x: X coordinate relative to @widget
+ * @y: Y coordinate relative to @widget
+ *
+ * Maps a point to the core whose mini graph (or heatmap row) contains it,
+ * using the same layout as graph_draw_per_core_graphs().
+ *
+ * Returns: core index, or -1 if the point is outside every graph
+ */
+gint graph_per_core_index_at(GtkWidget *widget, gint num_cores, gdouble x, gdouble y);
+
+/**
+ * graph_per_core_cell:
+ * @widget: The drawing widget
+ * @num_cores: Number of CPU cores drawn
+ * @index: Logical CPU
+ * @cell: (out): Area of that CPU's mini graph, or its heatmap row
+ *
+ * Returns: TRUE if @index has a non-empty cell
+ */
+gboolean graph_per_core_cell(GtkWidget *widget, gint num_cores, gint index, GdkRectangle *cell);
+
+/**
+ * graph_draw_per_core_headers:
+ * @cr: Cairo context
+ * @widget: The drawing widget
+ * @num_cores: Number of CPU cores drawn
+ * @get_group_label: (nullable): Label for each group; NULL uses "Node N"/"Package N"
+ * @fg_color: Foreground/text color
+ *
+ * Draws the group header strips of the per-core layout. Nothing is drawn
+ * when all CPUs are in one group.
+ */
+void graph_draw_per_core_headers(cairo_t *cr, GtkWidget *widget, gint num_cores,
+                                 GraphGetLabelFunc get_group_label, GdkRGBA *fg_color);
+
+/**
+ * graph_per_core_set_heatmap:
+ * @widget: The drawing widget
+ * @heatmap: TRUE to always draw the per-core view of @widget as a heatmap
+ *
+ * Without this the heatmap is only used once the mini graphs would be
+ * shorter than a readable minimum.
+ */
+void graph_per_core_set_heatmap(GtkWidget *widget, gboolean heatmap);
+
+/**
+ * graph_per_core_use_heatmap:
+ * @widget: The drawing widget
+ * @num_cores: Number of CPU cores drawn
+ *
+ * Returns: TRUE if the per-core helpers lay @widget out as a heatmap. The
+ * cell, hit-test and header helpers follow the same decision.
+ */
+gboolean graph_per_core_use_heatmap(GtkWidget *widget, gint num_cores);
+
+/**
+ * graph_draw_per_core_heatmap:
+ * @cr: Cairo context
+ * @widget: The drawing widget; it owns the heatmap surface
+ * @num_cores: Number of CPU cores to draw
+ * @get_history: Function to retrieve history for a given core index
+ * @get_history_idx: Function to retrieve current history index
+ * @get_sample_count: Function to retrieve the number of samples taken so far
+ * @bg_color: Background color (0%)
+ * @fg_color: Foreground/text color
+ * @accent_color: Accent color (100%)
+ * @num_points: Total number of points in each history
+ *
+ * Draws one row per CPU and one pixel column per sample from an image
+ * surface kept on @widget. Each new sample scrolls the surface by one
+ * column and paints only that column, so a frame costs O(cores) plus a
+ * single scaled blit.
+ */
+void graph_draw_per_core_heatmap(cairo_t *cr, GtkWidget *widget,
+                                 gint num_cores,
+                                 GraphGetHistoryFunc get_history,
+                                 GraphGetHistoryIndexFunc get_history_idx,
+                                 GraphGetSampleCountFunc get_sample_count,
+                                 GdkRGBA *bg_color, GdkRGBA *fg_color, GdkRGBA *accent_color,
+                                 gint num_points);
+
 #endif // GRAPH_UTILS_H
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef KHOS_GRAPH_H
+#define KHOS_GRAPH_H
+
+#include <gtk/gtk.h>
+#include "ui/graph_utils.h"
+
+/*
+ * KhosGraph: history graph widget shared by the tabs. It plots N series
+ * that point at the modules' ring arrays (get_cpu_usage_history(),
+ * get_rx_history(), ...) on a fixed or autoscaled axis.
+ *
+ * khos_graph_push() is called once per refresh with the ring's new index.
+ * It feeds the new samples into monotonic deques that keep the window
+ * min/max, so autoscaling never rescans the history, and queues a redraw.
+ * Drawing goes through graph_draw_background_layer() and
+ * graph_draw_scrolling(), which shift the cached plot and rasterize only
+ * the strip with the new samples. While a decimated column is still
+ * filling, only that column (plus an optional legend band) is invalidated.
+ */
+#define KHOS_TYPE_GRAPH (khos_graph_get_type())
+G_DECLARE_FINAL_TYPE(KhosGraph, khos_graph, KHOS, GRAPH, GtkDrawingArea)
+
+typedef enum {
+    KHOS_GRAPH_LINE,        // line only
+    KHOS_GRAPH_GRADIENT,    // gradient fill under the line, as graph_draw_fill()
+    KHOS_GRAPH_AREA         // flat translucent fill under the line
+} KhosGraphStyle;
+
+typedef void (*KhosGraphOverlayFunc)(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer user_data);
+
+GtkWidget* khos_graph_new(gint num_points);
+
+/* @color NULL follows the theme accent. Returns the series index. */
+gint khos_graph_add_series(KhosGraph *self, const GdkRGBA *color, KhosGraphStyle style, gdouble line_width);
+/* @history: ring of num_points values, not copied; NULL hides the series */
+void khos_graph_set_series_history(KhosGraph *self, gint series, const gdouble *history);
+
+/* Multiplies every value before plotting, e.g. KB/s to Mbps */
+void khos_graph_set_value_scale(KhosGraph *self, gdouble factor);
+void khos_graph_set_fixed_range(KhosGraph *self, gdouble max);
+/* Axis max = window max * @headroom, at least @floor, rounded up to 1/2/5 steps */
+void khos_graph_set_autoscale(KhosGraph *self, gdouble floor, gdouble headroom);
+gdouble khos_graph_get_axis_max(KhosGraph *self);
+/* Smallest and largest scaled value over the window, all series */
+void khos_graph_get_range(KhosGraph *self, gdouble *min, gdouble *max);
+
+/* Drawn into the plot under the series, e.g. stacked CPU states */
+void khos_graph_set_underlay_func(KhosGraph *self, GraphPlotFunc plot, gpointer user_data);
+/*
+ * Drawn over the plot every frame, e.g. a legend. @dynamic_height is the
+ * height of a band at the top that is redrawn on every push because its
+ * text changes; 0 for a static overlay.
+ */
+void khos_graph_set_overlay_func(KhosGraph *self, KhosGraphOverlayFunc func, gpointer user_data,
+                                 gint dynamic_height);
+
+/* New samples were written up to (not including) @history_idx */
+void khos_graph_push(KhosGraph *self, gint history_idx);
+/* The histories were swapped for others; rebuild the window and redraw */
+void khos_graph_reset(KhosGraph *self);
+
+#endif // KHOS_GRAPH_H
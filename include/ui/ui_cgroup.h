@@ -0,0 +1,8 @@
+#ifndef UI_CGROUP_H
+#define UI_CGROUP_H
+
+#include <gtk/gtk.h>
+
+GtkWidget* create_cgroup_tab(void);
+
+#endif // UI_CGROUP_H
@@ -0,0 +1,8 @@
+#ifndef UI_PRESSURE_H
+#define UI_PRESSURE_H
+
+#include <gtk/gtk.h>
+
+GtkWidget* create_pressure_tab(void);
+
+#endif // UI_PRESSURE_H
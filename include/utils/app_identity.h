@@ -0,0 +1,41 @@
+#ifndef APP_IDENTITY_H
+#define APP_IDENTITY_H
+
+#include <glib.h>
+
+/* What the Apps tab groups a process under. Identities are interned: every
+ * process of the same application shares one AppIdentity, so grouping can
+ * compare pointers or hash the id. */
+typedef struct {
+    gchar *id;          // grouping key: desktop id, unit name or "comm:<comm>[@<scope or unit>]"
+    gchar *name;        // display name (.desktop Name=, unit or comm)
+    gchar *icon;        // icon name for get_icon_for_app()
+    gboolean from_unit; // resolved from an app-*.scope / .service cgroup
+} AppIdentity;
+
+/**
+ * app_identity_for_pid:
+ * @pid: process id
+ * @starttime: start time from /proc/<pid>/stat (field 22), detects pid reuse
+ * @comm: process name, used within the process's scope or unit when the cgroup names no application
+ * @is_system_service: (out) (optional): set if the process lives in system.slice
+ *
+ * Resolves the application a process belongs to from its cgroup v2 path and
+ * the matching .desktop file. The result is cached for the lifetime of the
+ * process, so steady-state cost is one hash lookup.
+ */
+const AppIdentity* app_identity_for_pid(guint pid, guint64 starttime, const gchar *comm,
+                                        gboolean *is_system_service);
+
+/* cgroup v2 path of a process relative to the hierarchy root, as cached by
+ * app_identity_for_pid(); NULL if the process has not been resolved */
+const gchar* app_identity_get_cgroup(guint pid);
+
+// Call around each process scan; pids not looked up in between are forgotten,
+// and identities no remaining process maps to are freed
+void app_identity_begin_cycle(void);
+void app_identity_end_cycle(void);
+
+void app_identity_cleanup(void);
+
+#endif // APP_IDENTITY_H
@@ -0,0 +1,27 @@
+#ifndef FD_BUDGET_H
+#define FD_BUDGET_H
+
+#include <glib.h>
+
+/* Budget for fds the collectors keep open between updates (sysfs counters,
+ * perf event groups). Those caches grow with the CPU count, and on a
+ * 256-thread machine they alone would pass the usual soft RLIMIT_NOFILE of
+ * 1024. The budget is half the soft limit, leaving the rest to GTK, /proc
+ * scans and dialogs; files that do not fit are opened on every read. */
+
+/** Stands in for an fd that did not fit: the file exists, open it per read */
+#define FD_BUDGET_PER_READ (-2)
+
+// Counts @count fds as kept open; FALSE, and nothing counted, if they do not fit
+gboolean fd_budget_reserve(gint count);
+void fd_budget_release(gint count);
+
+// Opens @path read-only within the budget: an fd, FD_BUDGET_PER_READ, or -1 if it cannot be read
+int fd_budget_open(const gchar *path);
+// Closes an fd from fd_budget_open() and returns it to the budget; ignores the placeholders
+void fd_budget_close(int fd);
+
+// Reads a decimal counter through @fd, or from @path when @fd is FD_BUDGET_PER_READ
+gboolean fd_budget_read_u64(int fd, const gchar *path, guint64 *value);
+
+#endif // FD_BUDGET_H
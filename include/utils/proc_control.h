@@ -0,0 +1,46 @@
+#ifndef PROC_CONTROL_H
+#define PROC_CONTROL_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+/* Resource-control actions for the Apps tab. Every function takes a batch of
+ * pids (GArray of guint) so a whole app group is handled in one call, applies
+ * as much as it can and reports the first failure through @error. */
+
+#define PROC_CONTROL_ERROR (proc_control_error_quark())
+GQuark proc_control_error_quark(void);
+
+typedef enum {
+    PROC_CONTROL_ERROR_FAILED,
+    PROC_CONTROL_ERROR_PERMISSION,
+    PROC_CONTROL_ERROR_UNSUPPORTED
+} ProcControlError;
+
+typedef enum {
+    PROC_CONTROL_IOPRIO_REALTIME = 1,
+    PROC_CONTROL_IOPRIO_BEST_EFFORT = 2,
+    PROC_CONTROL_IOPRIO_IDLE = 3
+} ProcControlIoClass;
+
+// Per-thread settings, applied to every thread of each process
+gboolean proc_control_renice(GArray *pids, gint nice_value, GError **error);
+gboolean proc_control_ionice(GArray *pids, ProcControlIoClass io_class, gint level, GError **error);
+gboolean proc_control_set_affinity(GArray *pids, const guint8 *cpus, gint n_cpus, GError **error);
+
+/* cgroup actions. Processes that already own a unit (app-*.scope, a
+ * .service, or a scope created here) are controlled through it; the rest are
+ * first moved into a transient scope of the user's systemd instance so that
+ * freezing or capping them does not hit their whole login session. Thawing
+ * or removing a cap never creates a scope, and freezing refuses a selection
+ * that contains this monitor or its unit. Starting a scope is a systemd job,
+ * so the actions complete asynchronously; get the result with
+ * proc_control_cgroup_finish() from @callback. */
+void proc_control_freeze_async(GArray *pids, gboolean frozen, GAsyncReadyCallback callback, gpointer user_data);
+void proc_control_set_cpu_max_async(GArray *pids, gint percent_of_cpu,               // 0 removes the cap
+                                    GAsyncReadyCallback callback, gpointer user_data);
+void proc_control_set_memory_high_async(GArray *pids, guint64 bytes,                 // 0 removes the cap
+                                        GAsyncReadyCallback callback, gpointer user_data);
+gboolean proc_control_cgroup_finish(GAsyncResult *result, GError **error);
+
+#endif // PROC_CONTROL_H
@@ -0,0 +1,36 @@
+#ifndef PROC_HISTORY_H
+#define PROC_HISTORY_H
+
+#include <glib.h>
+
+/** Number of samples kept per process sparkline */
+#define PROC_HISTORY_POINTS 30
+
+/** Processes ranked by CPU that always get a ring, even when scrolled out of view */
+#define PROC_HISTORY_TOP_N 32
+
+/* A small ring of recent per-process samples. Rings live in a shared pool and
+ * are handed out only to processes that are visible or in the top N, then
+ * recycled when the process exits or stops being interesting. */
+typedef struct {
+    guint pid;
+    gfloat cpu[PROC_HISTORY_POINTS];   // CPU % of the whole system
+    gfloat mem[PROC_HISTORY_POINTS];   // RSS in MB
+    guint8 head;                       // next slot to write
+    guint8 count;                      // valid samples (<= PROC_HISTORY_POINTS)
+    guint idle_ticks;                  // ticks since the process was last wanted
+    gboolean seen_this_cycle;
+} ProcHistoryRing;
+
+ProcHistoryRing* proc_history_lookup(guint pid);
+ProcHistoryRing* proc_history_acquire(guint pid);
+void proc_history_push(ProcHistoryRing *ring, gfloat cpu, gfloat mem_mb);
+
+// Call before/after each scan; rings not seen or idle for a full window go back to the pool
+void proc_history_begin_cycle(void);
+void proc_history_end_cycle(void);
+
+guint proc_history_active_count(void);
+void proc_history_cleanup(void);
+
+#endif // PROC_HISTORY_H
@@ -0,0 +1,29 @@
+#ifndef USER_STATS_H
+#define USER_STATS_H
+
+#include <glib.h>
+#include "utils/proc_history.h"
+
+/* Per-user totals for the Apps "By user" view. The process scan feeds every
+ * process into user_stats_add() between begin/end cycle, so the totals cost
+ * one hash lookup per process and need no extra /proc reads. */
+typedef struct {
+    guint uid;
+    gchar *name;              // login name, or the uid when it has no passwd entry
+    gdouble cpu;              // CPU % of the whole system
+    gulong mem_kb;            // summed RSS
+    gdouble io_kbps;          // summed disk I/O, only when the scan measured it
+    guint nprocs;
+    ProcHistoryRing history;  // CPU % and RSS MB per scan, drawn by the sparkline renderer
+    gboolean seen_this_cycle;
+} UserStats;
+
+void user_stats_begin_cycle(void);
+void user_stats_add(guint uid, gdouble cpu, gulong mem_kb, gdouble io_kbps);
+// Pushes one history sample per user and forgets users without processes
+void user_stats_end_cycle(void);
+
+const UserStats* user_stats_get(guint uid);
+void user_stats_cleanup(void);
+
+#endif // USER_STATS_H
@@ -0,0 +1,288 @@
+#include "cgroup/cgroup_data.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+static GHashTable *cgroups_by_path = NULL;  // path -> CgroupInfo* (owned)
+static GPtrArray *cgroup_order = NULL;      // CgroupInfo* in depth-first order
+static guint scan_tick = 0;
+static gint64 prev_scan_us = 0;
+static gint cpu_count = 1;
+
+static void free_cgroup_info(gpointer data) {
+    CgroupInfo *cg = (CgroupInfo*)data;
+    g_free(cg->path);
+    g_free(cg->name);
+    g_free(cg);
+}
+
+// Read a small cgroup file relative to an open cgroup directory
+static gboolean read_cgroup_file(int dir_fd, const char *name, char *buf, gsize size) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return FALSE;
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0) return FALSE;
+    buf[n] = '\0';
+    return TRUE;
+}
+
+// Pick values out of "key value" lines (cpu.stat, memory.stat)
+static void parse_flat_keyed(const char *buf, const char *const *keys, guint64 *const *values, gint n_keys) {
+    const char *line = buf;
+    while (line && *line) {
+        const char *space = strchr(line, ' ');
+        const char *eol = strchr(line, '\n');
+        if (space && (!eol || space < eol)) {
+            gsize key_len = space - line;
+            for (gint i = 0; i < n_keys; i++) {
+                if (strlen(keys[i]) == key_len && strncmp(line, keys[i], key_len) == 0) {
+                    *values[i] = g_ascii_strtoull(space + 1, NULL, 10);
+                    break;
+                }
+            }
+        }
+        line = eol ? eol + 1 : NULL;
+    }
+}
+
+// Totals of a PSI file: "some avg10=0.00 avg60=0.00 avg300=0.00 total=N\nfull ..."
+static gboolean read_pressure_totals(int dir_fd, const char *name, guint64 *some, guint64 *full) {
+    char buf[256];
+    if (!read_cgroup_file(dir_fd, name, buf, sizeof(buf))) return FALSE;
+    const char *full_line = strstr(buf, "full ");
+    const char *p = strstr(buf, "total=");
+    if (p && some && (!full_line || p < full_line)) *some = g_ascii_strtoull(p + 6, NULL, 10);
+    p = full_line ? strstr(full_line, "total=") : NULL;
+    if (p && full) *full = g_ascii_strtoull(p + 6, NULL, 10);
+    return TRUE;
+}
+
+static void read_cgroup_counters(int dir_fd, CgroupInfo *cg) {
+    char buf[4096];
+
+    if (read_cgroup_file(dir_fd, "cpu.stat", buf, sizeof(buf))) {
+        static const char *const keys[] = { "usage_usec", "user_usec", "system_usec",
+                                            "nr_throttled", "throttled_usec" };
+        guint64 *const values[] = { &cg->usage_usec, &cg->user_usec, &cg->system_usec,
+                                    &cg->nr_throttled, &cg->throttled_usec };
+        parse_flat_keyed(buf, keys, values, G_N_ELEMENTS(keys));
+    }
+
+    cg->has_memory = read_cgroup_file(dir_fd, "memory.current", buf, sizeof(buf));
+    if (cg->has_memory) {
+        cg->memory_current = g_ascii_strtoull(buf, NULL, 10);
+        if (read_cgroup_file(dir_fd, "memory.stat", buf, sizeof(buf))) {
+            static const char *const keys[] = { "anon", "file" };
+            guint64 *const values[] = { &cg->memory_anon, &cg->memory_file };
+            parse_flat_keyed(buf, keys, values, G_N_ELEMENTS(keys));
+        }
+        if (read_cgroup_file(dir_fd, "memory.events", buf, sizeof(buf))) {
+            static const char *const keys[] = { "high", "max", "oom_kill" };
+            guint64 *const values[] = { &cg->events_high, &cg->events_max, &cg->events_oom_kill };
+            parse_flat_keyed(buf, keys, values, G_N_ELEMENTS(keys));
+        }
+    }
+
+    cg->has_pressure = read_pressure_totals(dir_fd, "cpu.pressure", &cg->cpu_some_total, NULL);
+    if (read_pressure_totals(dir_fd, "memory.pressure", &cg->mem_some_total, &cg->mem_full_total))
+        cg->has_pressure = TRUE;
+
+    // io.stat: "<maj>:<min> rbytes=N wbytes=N rios=N ..." per device
+    cg->has_io = read_cgroup_file(dir_fd, "io.stat", buf, sizeof(buf));
+    if (cg->has_io) {
+        guint64 rbytes = 0, wbytes = 0;
+        for (const char *p = strstr(buf, "rbytes="); p; p = strstr(p + 7, "rbytes=")) {
+            rbytes += g_ascii_strtoull(p + 7, NULL, 10);
+        }
+        for (const char *p = strstr(buf, "wbytes="); p; p = strstr(p + 7, "wbytes=")) {
+            wbytes += g_ascii_strtoull(p + 7, NULL, 10);
+        }
+        cg->io_rbytes = rbytes;
+        cg->io_wbytes = wbytes;
+    }
+
+    cg->has_pids = read_cgroup_file(dir_fd, "pids.current", buf, sizeof(buf));
+    if (cg->has_pids) cg->pids_current = g_ascii_strtoull(buf, NULL, 10);
+}
+
+static inline guint64 counter_delta(guint64 now, guint64 prev) {
+    return now >= prev ? now - prev : 0;
+}
+
+// Replace the oldest window slot with this scan's deltas, keeping the sums current
+static void push_stall_sample(CgroupInfo *cg, const CgroupStallSample *s) {
+    CgroupStallSample *old = &cg->stall_window[cg->stall_index];
+    CgroupStallSample *sum = &cg->stall_sum;
+    sum->elapsed_usec += s->elapsed_usec - old->elapsed_usec;
+    sum->nr_throttled += s->nr_throttled - old->nr_throttled;
+    sum->throttled_usec += s->throttled_usec - old->throttled_usec;
+    sum->cpu_some_usec += s->cpu_some_usec - old->cpu_some_usec;
+    sum->mem_some_usec += s->mem_some_usec - old->mem_some_usec;
+    sum->mem_full_usec += s->mem_full_usec - old->mem_full_usec;
+    sum->mem_high += s->mem_high - old->mem_high;
+    sum->mem_max += s->mem_max - old->mem_max;
+    sum->oom_kill += s->oom_kill - old->oom_kill;
+    *old = *s;
+    cg->stall_index = (cg->stall_index + 1) % CGROUP_STALL_WINDOW;
+}
+
+static void scan_cgroup(int dir_fd, const gchar *path, const gchar *name, gint depth, gdouble elapsed_us) {
+    CgroupInfo *cg = g_hash_table_lookup(cgroups_by_path, path);
+    gboolean fresh = (cg == NULL);
+    if (fresh) {
+        cg = g_new0(CgroupInfo, 1);
+        cg->path = g_strdup(path);
+        cg->name = g_strdup(name);
+        g_hash_table_insert(cgroups_by_path, cg->path, cg);
+    }
+    cg->depth = depth;
+
+    guint64 prev_usage = cg->usage_usec, prev_r = cg->io_rbytes, prev_w = cg->io_wbytes;
+    CgroupStallSample prev = {
+        .nr_throttled = cg->nr_throttled, .throttled_usec = cg->throttled_usec,
+        .cpu_some_usec = cg->cpu_some_total, .mem_some_usec = cg->mem_some_total,
+        .mem_full_usec = cg->mem_full_total, .mem_high = cg->events_high,
+        .mem_max = cg->events_max, .oom_kill = cg->events_oom_kill,
+    };
+    read_cgroup_counters(dir_fd, cg);
+
+    cg->cpu_percent = 0.0;
+    cg->io_read_kbps = cg->io_write_kbps = 0.0;
+    if (!fresh && elapsed_us > 0) {
+        if (cg->usage_usec >= prev_usage)
+            cg->cpu_percent = MIN(100.0, 100.0 * (cg->usage_usec - prev_usage) / (elapsed_us * cpu_count));
+        gdouble elapsed_s = elapsed_us / G_USEC_PER_SEC;
+        if (cg->io_rbytes >= prev_r) cg->io_read_kbps = (cg->io_rbytes - prev_r) / 1024.0 / elapsed_s;
+        if (cg->io_wbytes >= prev_w) cg->io_write_kbps = (cg->io_wbytes - prev_w) / 1024.0 / elapsed_s;
+
+        CgroupStallSample sample = {
+            .elapsed_usec = (guint64)elapsed_us,
+            .nr_throttled = counter_delta(cg->nr_throttled, prev.nr_throttled),
+            .throttled_usec = counter_delta(cg->throttled_usec, prev.throttled_usec),
+            .cpu_some_usec = counter_delta(cg->cpu_some_total, prev.cpu_some_usec),
+            .mem_some_usec = counter_delta(cg->mem_some_total, prev.mem_some_usec),
+            .mem_full_usec = counter_delta(cg->mem_full_total, prev.mem_full_usec),
+            .mem_high = counter_delta(cg->events_high, prev.mem_high),
+            .mem_max = counter_delta(cg->events_max, prev.mem_max),
+            .oom_kill = counter_delta(cg->events_oom_kill, prev.oom_kill),
+        };
+        push_stall_sample(cg, &sample);
+    }
+
+    cg->cpu_history[cg->history_index] = cg->cpu_percent;
+    cg->mem_history[cg->history_index] = cg->memory_current / (1024.0 * 1024.0);
+    cg->history_index = (cg->history_index + 1) % MAX_POINTS;
+    cg->last_seen = scan_tick;
+    g_ptr_array_add(cgroup_order, cg);
+
+    int list_fd = dup(dir_fd);
+    if (list_fd < 0) return;
+    DIR *dir = fdopendir(list_fd);
+    if (!dir) {
+        close(list_fd);
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+        if (entry->d_name[0] == '.') continue;
+        int child_fd = openat(dir_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (child_fd < 0) continue;
+        gchar *child_path = path[0] ? g_strdup_printf("%s/%s", path, entry->d_name) : g_strdup(entry->d_name);
+        scan_cgroup(child_fd, child_path, entry->d_name, depth + 1, elapsed_us);
+        g_free(child_path);
+        close(child_fd);
+    }
+    closedir(dir);
+}
+
+void cgroup_data_init(void) {
+    if (cgroups_by_path) return;
+    cgroups_by_path = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_cgroup_info);
+    cgroup_order = g_ptr_array_new();
+    cpu_count = MAX(1, (gint)sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+void cgroup_data_cleanup(void) {
+    if (!cgroups_by_path) return;
+    g_ptr_array_free(cgroup_order, TRUE);
+    g_hash_table_destroy(cgroups_by_path);
+    cgroup_order = NULL;
+    cgroups_by_path = NULL;
+    prev_scan_us = 0;
+}
+
+void cgroup_data_update(void) {
+    if (!cgroups_by_path) cgroup_data_init();
+
+    int root_fd = open(CGROUP_ROOT, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) return;
+
+    gint64 now = g_get_monotonic_time();
+    gdouble elapsed_us = prev_scan_us > 0 ? (gdouble)(now - prev_scan_us) : 0.0;
+    prev_scan_us = now;
+    scan_tick++;
+
+    g_ptr_array_set_size(cgroup_order, 0);
+    scan_cgroup(root_fd, "", "/", 0, elapsed_us);
+    close(root_fd);
+
+    // Drop cgroups that were removed since the previous scan
+    GHashTableIter it; gpointer key, value;
+    g_hash_table_iter_init(&it, cgroups_by_path);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        if (((CgroupInfo*)value)->last_seen != scan_tick) g_hash_table_iter_remove(&it);
+    }
+}
+
+gint cgroup_get_count(void) { return cgroup_order ? (gint)cgroup_order->len : 0; }
+
+const CgroupInfo* cgroup_get_info(gint index) {
+    if (!cgroup_order || index < 0 || index >= (gint)cgroup_order->len) return NULL;
+    return g_ptr_array_index(cgroup_order, index);
+}
+
+const CgroupInfo* cgroup_lookup(const gchar *path) {
+    return (cgroups_by_path && path) ? g_hash_table_lookup(cgroups_by_path, path) : NULL;
+}
+
+static gint compare_stall_rank(gconstpointer a, gconstpointer b) {
+    gdouble sa = ((const CgroupStallRank*)a)->score, sb = ((const CgroupStallRank*)b)->score;
+    return (sa < sb) - (sa > sb);
+}
+
+gint cgroup_get_worst_stalls(CgroupStallRank *out, gint max) {
+    if (!cgroup_order || max <= 0) return 0;
+
+    GArray *ranks = g_array_new(FALSE, FALSE, sizeof(CgroupStallRank));
+    for (guint i = 0; i < cgroup_order->len; i++) {
+        const CgroupInfo *cg = g_ptr_array_index(cgroup_order, i);
+        const CgroupStallSample *sum = &cg->stall_sum;
+        if (cg->depth == 0 || sum->elapsed_usec == 0) continue;
+
+        CgroupStallRank r = { .cgroup = cg };
+        gdouble window = (gdouble)sum->elapsed_usec;
+        r.throttled_percent = 100.0 * sum->throttled_usec / window;
+        r.cpu_pressure = 100.0 * sum->cpu_some_usec / window;
+        r.mem_pressure = 100.0 * sum->mem_some_usec / window;
+        r.throttles = sum->nr_throttled;
+        r.mem_high = sum->mem_high;
+        r.mem_max = sum->mem_max;
+        r.oom_kills = sum->oom_kill;
+        // Stall percentages add up; hitting memory.max or the OOM killer
+        // outweighs any amount of reclaim pressure
+        r.score = r.throttled_percent + r.cpu_pressure + r.mem_pressure
+                + (r.mem_high > 0 ? 1.0 : 0.0) + 10.0 * r.mem_max + 100.0 * r.oom_kills;
+        if (r.score > 0.0) g_array_append_val(ranks, r);
+    }
+
+    g_array_sort(ranks, compare_stall_rank);
+    gint n = MIN(max, (gint)ranks->len);
+    memcpy(out, ranks->data, n * sizeof(CgroupStallRank));
+    g_array_free(ranks, TRUE);
+    return n;
+}
@@ -1,4 +1,10 @@
 #include "cpu/cpu_data.h"
+#include "cpu/cpu_topology.h"
+#include "cpu/cpu_freq.h"
+#include "cpu/cpu_irq.h"
+#include "cpu/cpu_idle.h"
+#include "cpu/cpu_perf.h"
+#include "cpu/cpu_rapl.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,17 +15,44 @@
 static gdouble cpu_usage_history[MAX_POINTS] = {0.0};
 static gdouble per_cpu_usage_history[MAX_CPU_CORES][MAX_POINTS] = {{0.0}};
 static gdouble current_per_cpu_usage[MAX_CPU_CORES] = {0.0};
-static gulong prev_cpu_stats[MAX_CPU_CORES][4] = {{0}}; // user, nice, system, idle
 static gint cpu_usage_index = 0;
+static guint64 cpu_sample_count = 0;   // updates so far; never wraps, unlike cpu_usage_index
 static gdouble current_cpu_usage = 0.0;
-static gulong prev_cpu_total = 0;
-static gulong prev_cpu_idle = 0;
+
+// Per-state breakdown; slot 0 is the "cpu" total line, slot N+1 is cpuN
+#define CPU_STAT_FIELDS 10
+#define CPU_SLOTS (MAX_CPU_CORES + 1)
+static guint64 prev_cpu_counters[CPU_SLOTS][CPU_STAT_FIELDS] = {{0}};
+static gdouble current_state_percent[CPU_SLOTS][CPU_N_STATES] = {{0.0}};
+static gdouble state_history[CPU_SLOTS][CPU_N_STATES][MAX_POINTS] = {{{0.0}}};
 static gboolean show_per_cpu_graphs = FALSE;
 
+// Average busy % per topology group (NUMA node, or package without NUMA)
+static gdouble current_group_usage[MAX_NUMA_NODES] = {0.0};
+static gdouble group_usage_history[MAX_NUMA_NODES][MAX_POINTS] = {{0.0}};
+
+// System-wide counters from the tail of /proc/stat and /proc/loadavg
+static guint64 prev_sched_totals[CPU_N_SCHED_COUNTERS] = {0};
+static gint64 prev_sched_us = 0;
+static gdouble current_sched[CPU_N_SCHED_COUNTERS] = {0.0};
+static gdouble sched_history[CPU_N_SCHED_COUNTERS][MAX_POINTS] = {{0.0}};
+static gdouble load_average[3] = {0.0};
+
+// Run-queue wait from /proc/schedstat (CONFIG_SCHEDSTATS)
+static gboolean schedstat_available = FALSE;
+static guint64 prev_run_delay_ns[MAX_CPU_CORES] = {0};
+static gint64 prev_schedstat_us = 0;
+static gdouble current_rq_wait_ms[MAX_CPU_CORES] = {0.0};
+static gdouble rq_wait_history[MAX_CPU_CORES][MAX_POINTS] = {{0.0}};
+
+// Top processes per core; written into the staging half during a scan
+static CpuCoreProcess core_top[2][MAX_CPU_CORES][CPU_CORE_TOP_PROCESSES];
+static gint core_top_count[2][MAX_CPU_CORES];
+static gint core_top_published = 0;
+
 static gchar *cpu_model = NULL;
 static gint cpu_cores = 0;
 static gint cpu_threads = 0;
-static gdouble cpu_freq_mhz = 0.0;
 static gchar *cpu_cache_info = NULL;
 static gchar *cpu_architecture = NULL;
 static gchar *cpu_stepping = NULL;
@@ -50,47 +83,11 @@ static void parse_cpuinfo() {
     }
     fclose(fp);
 
-    fp = fopen("/proc/cpuinfo", "r");
-    if (fp) {
-        GHashTable *physical_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-        while (fgets(line, sizeof(line), fp)) {
-            if (strncmp(line, "physical id", 11) == 0) {
-                char *colon = strchr(line, ':');
-                if (colon) {
-                    colon++;
-                    while (isspace(*colon)) colon++;
-                    size_t len = strlen(colon);
-                    if (len > 0 && colon[len-1] == '\n') colon[len-1] = '\0';
-                    g_hash_table_replace(physical_ids, g_strdup(colon), GINT_TO_POINTER(1));
-                }
-            }
-        }
-        cpu_cores = g_hash_table_size(physical_ids);
-        g_hash_table_destroy(physical_ids);
-        fclose(fp);
-    }
-    if (cpu_cores <= 0) cpu_cores = 1;
-
     cpu_threads = sysconf(_SC_NPROCESSORS_ONLN);
-}
 
-static void get_cpu_freq() {
-    FILE *fp = fopen("/proc/cpuinfo", "r");
-    if (!fp) return;
-    char line[256];
-    gdouble total_freq = 0.0;
-    int count = 0;
-    while (fgets(line, sizeof(line), fp)) {
-        if (strncmp(line, "cpu MHz", 7) == 0) {
-            char *colon = strchr(line, ':');
-            if (colon) {
-                total_freq += atof(colon + 1);
-                count++;
-            }
-        }
-    }
-    fclose(fp);
-    if (count > 0) cpu_freq_mhz = total_freq / count;
+    // "physical id" in cpuinfo numbers sockets, not cores; count (package, core_id) pairs instead
+    cpu_topology_init(cpu_threads);
+    cpu_cores = cpu_topology_get_physical_cores();
 }
 
 static void get_cache_info() {
@@ -120,7 +117,8 @@ static void get_architecture() {
 
 void cpu_data_init(void) {
     parse_cpuinfo();
-    get_cpu_freq();
+    cpu_freq_init(cpu_threads);
+    cpu_rapl_init(g_getenv("KHOS_POWERCAP_ROOT"));
     get_cache_info();
     get_architecture();
     cpu_data_update();
@@ -144,98 +142,192 @@ void cpu_data_cleanup(void) {
     g_free(cpu_bogomips); 
     g_print("Freeing cpu_address_sizes\n");
     g_free(cpu_address_sizes);
+    cpu_freq_cleanup();
+    cpu_irq_cleanup();
+    cpu_idle_cleanup();
+    cpu_perf_disable();
+    cpu_rapl_cleanup();
     g_print("CPU data cleanup finished\n");
 }
 
-void cpu_data_update(void) {
-    FILE *fp = fopen("/proc/stat", "r");
+/* "cpu<N> yld_count legacy sched_count sched_goidle ttwu_count ttwu_local
+ *  rq_cpu_time run_delay pcount" – run_delay is the time tasks on this CPU
+ *  spent runnable but waiting, in ns */
+static void update_runqueue_wait(void) {
+    FILE *fp = fopen("/proc/schedstat", "r");
     if (!fp) return;
-    
-    char line[256];
-    gulong user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
-    
-    if (fgets(line, sizeof(line), fp) && strncmp(line, "cpu ", 4) == 0) {
-        sscanf(line, "cpu  %lu %lu %lu %lu %lu %lu %lu %lu",
-               &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    schedstat_available = TRUE;
+
+    gint64 now = g_get_monotonic_time();
+    gdouble elapsed_ms = prev_schedstat_us > 0 ? (now - prev_schedstat_us) / 1000.0 : 0.0;
+    prev_schedstat_us = now;
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "cpu", 3) != 0 || !isdigit((unsigned char)line[3])) continue;
+        int cpu = atoi(line + 3);
+        guint64 run_delay = 0;
+        if (cpu < 0 || cpu >= MAX_CPU_CORES) continue;
+        if (sscanf(line, "%*s %*u %*u %*u %*u %*u %*u %*u %" G_GUINT64_FORMAT, &run_delay) != 1) continue;
+
+        if (elapsed_ms > 0 && prev_run_delay_ns[cpu] > 0 && run_delay >= prev_run_delay_ns[cpu]) {
+            gdouble wait_ms = (run_delay - prev_run_delay_ns[cpu]) / 1e6;
+            current_rq_wait_ms[cpu] = wait_ms * 1000.0 / elapsed_ms;   // ms waited per second
+        }
+        prev_run_delay_ns[cpu] = run_delay;
+        // Share of wall time with a task waiting; several waiters can push it past 100
+        rq_wait_history[cpu][cpu_usage_index] = MIN(100.0, current_rq_wait_ms[cpu] / 10.0);
     }
-    
-    gulong total = user + nice + system + idle + iowait + irq + softirq + steal;
-    gulong idle_total = idle + iowait;
-    
-    if (prev_cpu_total > 0 && total > prev_cpu_total) {
-        gulong total_diff = total - prev_cpu_total;
-        gulong idle_diff = idle_total - prev_cpu_idle;
-        current_cpu_usage = 100.0 * (total_diff - idle_diff) / total_diff;
-        cpu_usage_history[cpu_usage_index] = current_cpu_usage > 0 ? current_cpu_usage : 0;
+    fclose(fp);
+}
+
+/* One /proc/stat line ("cpu" or "cpuN") against the previous sample of the
+ * same slot. Fields: user nice system idle iowait irq softirq steal guest
+ * guest_nice; guest time is already counted in user/nice. */
+static void update_cpu_slot(gint slot, const char *fields) {
+    guint64 now[CPU_STAT_FIELDS] = {0};
+    if (sscanf(fields, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+                       " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
+               &now[0], &now[1], &now[2], &now[3], &now[4], &now[5], &now[6], &now[7], &now[8], &now[9]) < 4) return;
+
+    guint64 *prev = prev_cpu_counters[slot];
+    gboolean have_prev = prev[3] > 0;
+    guint64 d[CPU_STAT_FIELDS];
+    guint64 total = 0;
+    for (gint f = 0; f < CPU_STAT_FIELDS; f++) {
+        // A CPU going offline and back resets its counters
+        if (now[f] < prev[f]) have_prev = FALSE;
+        d[f] = now[f] - prev[f];
+        if (f < 8) total += d[f];
     }
-    
-    prev_cpu_total = total;
-    prev_cpu_idle = idle_total;
-    
-    for (int i = 0; i < cpu_threads && i < MAX_CPU_CORES; i++) {
-        char cpu_line[32];
-        snprintf(cpu_line, sizeof(cpu_line), "cpu%d ", i);
-        
-        // Reset file position
-        rewind(fp);
-        
-        // Find the specific CPU line
-        while (fgets(line, sizeof(line), fp)) {
-            if (strncmp(line, cpu_line, strlen(cpu_line)) == 0) {
-                gulong cpu_user = 0, cpu_nice = 0, cpu_system = 0, cpu_idle = 0, cpu_iowait = 0, cpu_irq = 0, cpu_softirq = 0, cpu_steal = 0;
-                sscanf(line, "%*s %lu %lu %lu %lu %lu %lu %lu %lu", 
-                       &cpu_user, &cpu_nice, &cpu_system, &cpu_idle, 
-                       &cpu_iowait, &cpu_irq, &cpu_softirq, &cpu_steal);
-                
-                gulong cpu_total = cpu_user + cpu_nice + cpu_system + cpu_idle + cpu_iowait + cpu_irq + cpu_softirq + cpu_steal;
-                gulong cpu_idle_total = cpu_idle + cpu_iowait;
-                
-                gulong prev_total = prev_cpu_stats[i][0] + prev_cpu_stats[i][1] + prev_cpu_stats[i][2] + prev_cpu_stats[i][3];
-                gulong prev_idle = prev_cpu_stats[i][3];
-                
-                if (prev_total > 0 && cpu_total > prev_total) {
-                    gulong total_diff = cpu_total - prev_total;
-                    gulong idle_diff = cpu_idle_total - prev_idle;
-                    current_per_cpu_usage[i] = 100.0 * (total_diff - idle_diff) / total_diff;
-                    per_cpu_usage_history[i][cpu_usage_index] = current_per_cpu_usage[i] > 0 ? current_per_cpu_usage[i] : 0;
-                }
-                
-                // Store current values for next update
-                prev_cpu_stats[i][0] = cpu_user + cpu_nice;
-                prev_cpu_stats[i][1] = cpu_system;
-                prev_cpu_stats[i][2] = cpu_irq + cpu_softirq + cpu_steal;
-                prev_cpu_stats[i][3] = cpu_idle_total;
-                
-                break;
-            }
+    memcpy(prev, now, sizeof(now));
+    if (!have_prev || total == 0) return;
+
+    guint64 guest = d[8] + d[9];
+    guint64 user = d[0] + d[1];
+    user = user > guest ? user - guest : 0;
+
+    gdouble *pct = current_state_percent[slot];
+    pct[CPU_STATE_USER] = 100.0 * user / total;
+    pct[CPU_STATE_SYSTEM] = 100.0 * d[2] / total;
+    pct[CPU_STATE_IOWAIT] = 100.0 * d[4] / total;
+    pct[CPU_STATE_IRQ] = 100.0 * d[5] / total;
+    pct[CPU_STATE_SOFTIRQ] = 100.0 * d[6] / total;
+    pct[CPU_STATE_STEAL] = 100.0 * d[7] / total;
+    pct[CPU_STATE_GUEST] = 100.0 * guest / total;
+    for (gint s = 0; s < CPU_N_STATES; s++) {
+        state_history[slot][s][cpu_usage_index] = pct[s];
+    }
+
+    // Busy excludes idle and iowait, as before
+    gdouble busy = 100.0 * (total - d[3] - d[4]) / total;
+    if (slot == 0) {
+        current_cpu_usage = busy;
+        cpu_usage_history[cpu_usage_index] = busy;
+    } else {
+        current_per_cpu_usage[slot - 1] = busy;
+        per_cpu_usage_history[slot - 1][cpu_usage_index] = busy;
+    }
+}
+
+static void update_group_usage(void) {
+    gdouble sum[MAX_NUMA_NODES] = {0.0};
+    gint count[MAX_NUMA_NODES] = {0};
+    for (gint cpu = 0; cpu < cpu_threads && cpu < MAX_CPU_CORES; cpu++) {
+        const CpuTopoEntry *topo = cpu_topology_get_cpu(cpu);
+        gint group = topo ? topo->group : 0;
+        sum[group] += current_per_cpu_usage[cpu];
+        count[group]++;
+    }
+    for (gint g = 0; g < cpu_topology_get_group_count(); g++) {
+        current_group_usage[g] = count[g] > 0 ? sum[g] / count[g] : 0.0;
+        group_usage_history[g][cpu_usage_index] = current_group_usage[g];
+    }
+}
+
+static void update_load_average(void) {
+    FILE *fp = fopen("/proc/loadavg", "r");
+    if (!fp) return;
+    char buf[128];
+    if (fgets(buf, sizeof(buf), fp)) {
+        char *p = buf;
+        for (gint i = 0; i < 3; i++) load_average[i] = g_ascii_strtod(p, &p);
+    }
+    fclose(fp);
+    current_sched[CPU_SCHED_LOAD1] = load_average[0];
+}
+
+/* Counters are cumulative (ctxt, intr, processes) and turned into rates, or
+ * instantaneous (procs_running, procs_blocked, load) and kept as they are */
+static void finish_sched_counters(const guint64 *totals, const gboolean *seen) {
+    gint64 now = g_get_monotonic_time();
+    gdouble elapsed_s = prev_sched_us > 0 ? (now - prev_sched_us) / (gdouble)G_USEC_PER_SEC : 0.0;
+    prev_sched_us = now;
+    for (gint c = 0; c < CPU_N_SCHED_COUNTERS; c++) {
+        if (!seen[c]) continue;
+        if (c <= CPU_SCHED_FORKS) {
+            current_sched[c] = (elapsed_s > 0 && totals[c] >= prev_sched_totals[c])
+                ? (totals[c] - prev_sched_totals[c]) / elapsed_s : 0.0;
+            prev_sched_totals[c] = totals[c];
+        } else {
+            current_sched[c] = totals[c];
         }
     }
-    
-    cpu_usage_index = (cpu_usage_index + 1) % MAX_POINTS;
-    
-    fp = fopen("/proc/cpuinfo", "r");
-    if (fp) {
-        char line[256];
-        gdouble total_freq = 0.0;
-        int count = 0;
-        while (fgets(line, sizeof(line), fp)) {
-            if (strncmp(line, "cpu MHz", 7) == 0) {
-                char *colon = strchr(line, ':');
-                if (colon) {
-                    total_freq += atof(colon + 1);
-                    count++;
+    update_load_average();
+    for (gint c = 0; c < CPU_N_SCHED_COUNTERS; c++) {
+        sched_history[c][cpu_usage_index] = current_sched[c];
+    }
+}
+
+void cpu_data_update(void) {
+    update_runqueue_wait();
+
+    FILE *fp = fopen("/proc/stat", "r");
+    if (!fp) return;
+
+    // Single pass: the aggregate line, one line per CPU, then the system-wide counters
+    static const struct { const char *key; gsize len; CpuSchedCounter counter; } sched_keys[] = {
+        { "ctxt ", 5, CPU_SCHED_CTXT },
+        { "intr ", 5, CPU_SCHED_INTR },
+        { "processes ", 10, CPU_SCHED_FORKS },
+        { "procs_running ", 14, CPU_SCHED_RUNNING },
+        { "procs_blocked ", 14, CPU_SCHED_BLOCKED },
+    };
+    guint64 sched_totals[CPU_N_SCHED_COUNTERS] = {0};
+    gboolean sched_seen[CPU_N_SCHED_COUNTERS] = {0};
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "cpu", 3) != 0) {
+            // "intr" is longer than the buffer; its remainder comes back as digit-only chunks
+            for (gsize k = 0; k < G_N_ELEMENTS(sched_keys); k++) {
+                if (strncmp(line, sched_keys[k].key, sched_keys[k].len) == 0) {
+                    sched_totals[sched_keys[k].counter] = g_ascii_strtoull(line + sched_keys[k].len, NULL, 10);
+                    sched_seen[sched_keys[k].counter] = TRUE;
+                    break;
                 }
             }
+        } else if (line[3] == ' ') {
+            update_cpu_slot(0, line + 4);
+        } else if (isdigit((unsigned char)line[3])) {
+            char *end = NULL;
+            long cpu = strtol(line + 3, &end, 10);
+            if (cpu >= 0 && cpu < MAX_CPU_CORES) update_cpu_slot((gint)cpu + 1, end);
         }
-        fclose(fp);
-        if (count > 0) cpu_freq_mhz = total_freq / count;
     }
+    fclose(fp);
+    update_group_usage();
+    finish_sched_counters(sched_totals, sched_seen);
+
+    cpu_usage_index = (cpu_usage_index + 1) % MAX_POINTS;
+    cpu_sample_count++;
+    cpu_freq_update();
+    cpu_rapl_update();
 }
 
 const gchar* get_cpu_model(void) { return cpu_model ? cpu_model : "N/A"; }
 gint get_cpu_cores(void) { return cpu_cores; }
 gint get_cpu_threads(void) { return cpu_threads; }
-gdouble get_cpu_freq_mhz(void) { return cpu_freq_mhz; }
+gdouble get_cpu_freq_mhz(void) { return cpu_freq_get_average_mhz(); }
 const gchar* get_cpu_cache_info(void) { return cpu_cache_info ? cpu_cache_info : "N/A"; }
 const gchar* get_cpu_architecture(void) { return cpu_architecture ? cpu_architecture : "N/A"; }
 const gchar* get_cpu_stepping(void) { return cpu_stepping ? cpu_stepping : "N/A"; }
@@ -246,6 +338,7 @@ const gchar* get_cpu_address_sizes(void) { return cpu_address_sizes ? cpu_addres
 gdouble get_current_cpu_usage(void) { return current_cpu_usage; }
 const gdouble* get_cpu_usage_history(void) { return cpu_usage_history; }
 gint get_cpu_usage_history_index(void) { return cpu_usage_index; }
+guint64 get_cpu_sample_count(void) { return cpu_sample_count; }
 
 gdouble get_cpu_usage_by_core(gint core_id) { 
     if (core_id >= 0 && core_id < cpu_threads && core_id < MAX_CPU_CORES) {
@@ -261,6 +354,60 @@ const gdouble* get_cpu_usage_history_by_core(gint core_id) {
     return NULL;
 }
 
+const gchar* get_cpu_state_name(CpuState state) {
+    static const gchar *const names[CPU_N_STATES] = {
+        "user", "system", "iowait", "irq", "softirq", "steal", "guest"
+    };
+    return (state >= 0 && state < CPU_N_STATES) ? names[state] : "";
+}
+
+static gint cpu_state_slot(gint core_id) {
+    if (core_id < 0) return 0;
+    if (core_id < cpu_threads && core_id < MAX_CPU_CORES) return core_id + 1;
+    return -1;
+}
+
+gdouble get_cpu_state_percent(gint core_id, CpuState state) {
+    gint slot = cpu_state_slot(core_id);
+    if (slot < 0 || state < 0 || state >= CPU_N_STATES) return 0.0;
+    return current_state_percent[slot][state];
+}
+
+const gdouble* get_cpu_state_history(gint core_id, CpuState state) {
+    gint slot = cpu_state_slot(core_id);
+    if (slot < 0 || state < 0 || state >= CPU_N_STATES) return NULL;
+    return state_history[slot][state];
+}
+
+gdouble get_cpu_group_usage(gint group) {
+    return (group >= 0 && group < cpu_topology_get_group_count()) ? current_group_usage[group] : 0.0;
+}
+
+const gdouble* get_cpu_group_usage_history(gint group) {
+    return (group >= 0 && group < cpu_topology_get_group_count()) ? group_usage_history[group] : NULL;
+}
+
+const gchar* get_cpu_sched_counter_name(CpuSchedCounter counter) {
+    static const gchar *const names[CPU_N_SCHED_COUNTERS] = {
+        "Context switches/s", "Interrupts/s", "Forks/s", "Running", "Blocked (D)", "Load (1 min)"
+    };
+    return (counter >= 0 && counter < CPU_N_SCHED_COUNTERS) ? names[counter] : "";
+}
+
+gdouble get_cpu_sched_counter(CpuSchedCounter counter) {
+    return (counter >= 0 && counter < CPU_N_SCHED_COUNTERS) ? current_sched[counter] : 0.0;
+}
+
+const gdouble* get_cpu_sched_counter_history(CpuSchedCounter counter) {
+    return (counter >= 0 && counter < CPU_N_SCHED_COUNTERS) ? sched_history[counter] : NULL;
+}
+
+void get_cpu_load_average(gdouble *load1, gdouble *load5, gdouble *load15) {
+    if (load1) *load1 = load_average[0];
+    if (load5) *load5 = load_average[1];
+    if (load15) *load15 = load_average[2];
+}
+
 gboolean get_show_per_cpu_graphs(void) {
     return show_per_cpu_graphs;
 }
@@ -268,3 +415,52 @@ gboolean get_show_per_cpu_graphs(void) {
 void set_show_per_cpu_graphs(gboolean show) {
     show_per_cpu_graphs = show;
 }
+
+gboolean get_cpu_runqueue_available(void) {
+    return schedstat_available;
+}
+
+gdouble get_cpu_runqueue_wait_by_core(gint core_id) {
+    if (core_id >= 0 && core_id < cpu_threads && core_id < MAX_CPU_CORES) {
+        return current_rq_wait_ms[core_id];
+    }
+    return 0.0;
+}
+
+const gdouble* get_cpu_runqueue_history_by_core(gint core_id) {
+    if (core_id >= 0 && core_id < cpu_threads && core_id < MAX_CPU_CORES) {
+        return rq_wait_history[core_id];
+    }
+    return NULL;
+}
+
+void cpu_core_attribution_begin(void) {
+    memset(core_top_count[!core_top_published], 0, sizeof(core_top_count[0]));
+}
+
+void cpu_core_attribution_add(gint core_id, guint pid, const gchar *name, gdouble core_percent) {
+    if (core_id < 0 || core_id >= MAX_CPU_CORES || core_percent <= 0.0) return;
+    CpuCoreProcess *top = core_top[!core_top_published][core_id];
+    gint *count = &core_top_count[!core_top_published][core_id];
+
+    // Insertion into a short sorted list; the lightest entry falls off the end
+    gint pos = *count;
+    while (pos > 0 && top[pos - 1].core_percent < core_percent) pos--;
+    if (pos >= CPU_CORE_TOP_PROCESSES) return;
+    gint last = MIN(*count, CPU_CORE_TOP_PROCESSES - 1);
+    memmove(&top[pos + 1], &top[pos], (last - pos) * sizeof(CpuCoreProcess));
+    top[pos].pid = pid;
+    top[pos].core_percent = core_percent;
+    g_strlcpy(top[pos].name, name ? name : "", sizeof(top[pos].name));
+    if (*count < CPU_CORE_TOP_PROCESSES) (*count)++;
+}
+
+void cpu_core_attribution_end(void) {
+    core_top_published = !core_top_published;
+}
+
+gint get_cpu_core_top_processes(gint core_id, const CpuCoreProcess **out) {
+    if (core_id < 0 || core_id >= MAX_CPU_CORES) return 0;
+    if (out) *out = core_top[core_top_published][core_id];
+    return core_top_count[core_top_published][core_id];
+}
@@ -0,0 +1,237 @@
+#include "cpu/cpu_freq.h"
+#include "utils/fd_budget.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define CPU_SYSFS "/sys/devices/system/cpu"
+
+#define CUR_FREQ_FILE "cpufreq/scaling_cur_freq"
+#define CORE_THROTTLE_FILE "thermal_throttle/core_throttle_count"
+#define PACKAGE_THROTTLE_FILE "thermal_throttle/package_throttle_count"
+
+typedef struct {
+    // From fd_budget_open(): FD_BUDGET_PER_READ once the budget is used up
+    int cur_freq_fd;            // cpufreq/scaling_cur_freq, kHz
+    int core_throttle_fd;       // thermal_throttle/core_throttle_count
+    int package_throttle_fd;    // thermal_throttle/package_throttle_count
+    gdouble mhz;
+    gdouble max_mhz;            // cpuinfo_max_freq, or the highest value seen
+    guint64 core_throttle;
+    guint64 package_throttle;
+    guint64 core_throttle_start;
+    gboolean throttling;
+    gchar governor[32];
+    gchar epp[32];
+} CpuFreqCore;
+
+static CpuFreqCore cores[MAX_CPU_CORES];
+static gint core_count = 0;
+static gboolean has_cpufreq = FALSE;
+static gdouble freq_history[MAX_CPU_CORES][MAX_POINTS] = {{0.0}};
+static gint history_index = 0;
+static guint64 sample_count = 0;
+static gint tick = 0;
+
+static int open_cpu_file(gint cpu, const gchar *name) {
+    char path[128];
+    snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/%s", cpu, name);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static int keep_cpu_file(gint cpu, const gchar *name) {
+    char path[128];
+    snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/%s", cpu, name);
+    return fd_budget_open(path);
+}
+
+static gboolean read_cpu_u64(gint cpu, int fd, const gchar *name, guint64 *value) {
+    if (fd >= 0) return fd_budget_read_u64(fd, NULL, value);
+    if (fd != FD_BUDGET_PER_READ) return FALSE;
+    char path[128];
+    snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/%s", cpu, name);
+    return fd_budget_read_u64(fd, path, value);
+}
+
+// One-shot read of a short sysfs string, without the trailing newline
+static gboolean read_cpu_string(gint cpu, const gchar *name, gchar *buf, gsize buf_size) {
+    int fd = open_cpu_file(cpu, name);
+    if (fd < 0) return FALSE;
+    ssize_t n = read(fd, buf, buf_size - 1);
+    close(fd);
+    if (n <= 0) return FALSE;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return TRUE;
+}
+
+static void read_policies(void) {
+    for (gint cpu = 0; cpu < core_count; cpu++) {
+        if (!read_cpu_string(cpu, "cpufreq/scaling_governor", cores[cpu].governor, sizeof(cores[cpu].governor)))
+            cores[cpu].governor[0] = '\0';
+        if (!read_cpu_string(cpu, "cpufreq/energy_performance_preference", cores[cpu].epp, sizeof(cores[cpu].epp)))
+            cores[cpu].epp[0] = '\0';
+    }
+}
+
+// Fallback for machines without cpufreq: "processor : N" ... "cpu MHz : F"
+static void read_cpuinfo_mhz(void) {
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (!fp) return;
+    char line[256];
+    gint cpu = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        char *colon = strchr(line, ':');
+        if (!colon) continue;
+        if (strncmp(line, "processor", 9) == 0) {
+            cpu = atoi(colon + 1);
+        } else if (strncmp(line, "cpu MHz", 7) == 0 && cpu >= 0 && cpu < core_count) {
+            cores[cpu].mhz = g_ascii_strtod(colon + 1, NULL);
+        }
+    }
+    fclose(fp);
+}
+
+void cpu_freq_init(gint num_cpus) {
+    core_count = CLAMP(num_cpus, 1, MAX_CPU_CORES);
+    has_cpufreq = FALSE;
+    for (gint cpu = 0; cpu < core_count; cpu++) {
+        CpuFreqCore *c = &cores[cpu];
+        memset(c, 0, sizeof(*c));
+        c->cur_freq_fd = keep_cpu_file(cpu, CUR_FREQ_FILE);
+        c->core_throttle_fd = keep_cpu_file(cpu, CORE_THROTTLE_FILE);
+        c->package_throttle_fd = keep_cpu_file(cpu, PACKAGE_THROTTLE_FILE);
+        if (c->cur_freq_fd != -1) has_cpufreq = TRUE;
+
+        char buf[32];
+        if (read_cpu_string(cpu, "cpufreq/cpuinfo_max_freq", buf, sizeof(buf))) {
+            c->max_mhz = g_ascii_strtoull(buf, NULL, 10) / 1000.0;
+        }
+        read_cpu_u64(cpu, c->core_throttle_fd, CORE_THROTTLE_FILE, &c->core_throttle_start);
+        c->core_throttle = c->core_throttle_start;
+        read_cpu_u64(cpu, c->package_throttle_fd, PACKAGE_THROTTLE_FILE, &c->package_throttle);
+    }
+    if (!has_cpufreq) {
+        g_print("cpufreq not available, falling back to /proc/cpuinfo for CPU frequency\n");
+    }
+    tick = 0;
+    cpu_freq_update();
+}
+
+void cpu_freq_update(void) {
+    gboolean slow_tick = (tick++ % CPU_FREQ_POLICY_TICKS) == 0;
+    if (slow_tick) {
+        if (has_cpufreq) read_policies();
+        else read_cpuinfo_mhz();
+    }
+
+    for (gint cpu = 0; cpu < core_count; cpu++) {
+        CpuFreqCore *c = &cores[cpu];
+        guint64 khz;
+        if (read_cpu_u64(cpu, c->cur_freq_fd, CUR_FREQ_FILE, &khz)) c->mhz = khz / 1000.0;
+        if (c->mhz > c->max_mhz) c->max_mhz = c->mhz;
+
+        guint64 core_throttle = c->core_throttle, package_throttle = c->package_throttle;
+        read_cpu_u64(cpu, c->core_throttle_fd, CORE_THROTTLE_FILE, &core_throttle);
+        read_cpu_u64(cpu, c->package_throttle_fd, PACKAGE_THROTTLE_FILE, &package_throttle);
+        c->throttling = core_throttle > c->core_throttle || package_throttle > c->package_throttle;
+        c->core_throttle = core_throttle;
+        c->package_throttle = package_throttle;
+
+        freq_history[cpu][history_index] = c->max_mhz > 0 ? MIN(100.0, 100.0 * c->mhz / c->max_mhz) : 0.0;
+    }
+    history_index = (history_index + 1) % MAX_POINTS;
+    sample_count++;
+}
+
+void cpu_freq_cleanup(void) {
+    for (gint cpu = 0; cpu < core_count; cpu++) {
+        int *fds[] = { &cores[cpu].cur_freq_fd, &cores[cpu].core_throttle_fd, &cores[cpu].package_throttle_fd };
+        for (gsize i = 0; i < G_N_ELEMENTS(fds); i++) {
+            fd_budget_close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+    core_count = 0;
+}
+
+gboolean cpu_freq_has_cpufreq(void) {
+    return has_cpufreq;
+}
+
+gdouble cpu_freq_get_average_mhz(void) {
+    gdouble sum = 0.0;
+    gint count = 0;
+    for (gint cpu = 0; cpu < core_count; cpu++) {
+        if (cores[cpu].mhz <= 0) continue;
+        sum += cores[cpu].mhz;
+        count++;
+    }
+    return count > 0 ? sum / count : 0.0;
+}
+
+gdouble cpu_freq_get_mhz(gint cpu) {
+    return (cpu >= 0 && cpu < core_count) ? cores[cpu].mhz : 0.0;
+}
+
+gdouble cpu_freq_get_max_mhz(gint cpu) {
+    return (cpu >= 0 && cpu < core_count) ? cores[cpu].max_mhz : 0.0;
+}
+
+const gdouble* cpu_freq_get_history(gint cpu) {
+    return (cpu >= 0 && cpu < core_count) ? freq_history[cpu] : NULL;
+}
+
+gint cpu_freq_get_history_index(void) {
+    return history_index;
+}
+
+guint64 cpu_freq_get_sample_count(void) {
+    return sample_count;
+}
+
+// Per-core value, or for @cpu -1 the value shared by every core ("mixed" otherwise)
+static const gchar* policy_value(gint cpu, gsize offset) {
+    if (cpu >= 0) {
+        if (cpu >= core_count) return NULL;
+        const gchar *value = (const gchar *)&cores[cpu] + offset;
+        return value[0] ? value : NULL;
+    }
+    const gchar *first = NULL;
+    for (gint i = 0; i < core_count; i++) {
+        const gchar *value = (const gchar *)&cores[i] + offset;
+        if (!value[0]) continue;
+        if (!first) first = value;
+        else if (strcmp(first, value) != 0) return "mixed";
+    }
+    return first;
+}
+
+const gchar* cpu_freq_get_governor(gint cpu) {
+    return policy_value(cpu, G_STRUCT_OFFSET(CpuFreqCore, governor));
+}
+
+const gchar* cpu_freq_get_epp(gint cpu) {
+    return policy_value(cpu, G_STRUCT_OFFSET(CpuFreqCore, epp));
+}
+
+gboolean cpu_freq_get_throttle_counts(gint cpu, guint64 *core_count_out, guint64 *package_count_out) {
+    if (cpu < 0 || cpu >= core_count || cores[cpu].core_throttle_fd == -1) return FALSE;
+    if (core_count_out) *core_count_out = cores[cpu].core_throttle;
+    if (package_count_out) *package_count_out = cores[cpu].package_throttle;
+    return TRUE;
+}
+
+gboolean cpu_freq_is_throttling(gint cpu) {
+    return cpu >= 0 && cpu < core_count && cores[cpu].throttling;
+}
+
+guint64 cpu_freq_get_throttle_events(void) {
+    guint64 events = 0;
+    for (gint cpu = 0; cpu < core_count; cpu++) {
+        events += cores[cpu].core_throttle - cores[cpu].core_throttle_start;
+    }
+    return events;
+}
@@ -0,0 +1,140 @@
+#include "cpu/cpu_idle.h"
+#include "utils/fd_budget.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CPUIDLE_PATH "/sys/devices/system/cpu/cpu%d/cpuidle/state%d/%s"
+/* Cap on kept fds (2 per state). cpu_freq takes its share of the shared fd
+ * budget at startup, before the first cpuidle update; the cap keeps part of
+ * what is left for the perf groups, which are opened later on demand. */
+#define CPU_IDLE_MAX_KEPT_FDS 256
+
+typedef struct {
+    int time_fd;        // FD_BUDGET_PER_READ: reopen on every read
+    int usage_fd;
+    guint64 prev_time;  // usec
+    guint64 prev_usage;
+    gdouble residency;
+    gdouble usage_rate;
+} IdleState;
+
+static IdleState states[MAX_CPU_CORES][CPU_IDLE_MAX_STATES];
+static gint state_counts[MAX_CPU_CORES];
+static gchar state_names[CPU_IDLE_MAX_STATES][16];
+static gint cpu_count = 0;
+static gint max_states = 0;
+static gboolean initialized = FALSE;
+static gint64 last_update_us = 0;
+static gint kept_fds = 0;
+
+static gboolean read_u64_at(int fd, gint cpu, gint state, const gchar *file, guint64 *value) {
+    if (fd >= 0) return fd_budget_read_u64(fd, NULL, value);
+    char path[128];
+    snprintf(path, sizeof(path), CPUIDLE_PATH, cpu, state, file);
+    return fd_budget_read_u64(fd, path, value);
+}
+
+// Keeps @path open while this module's share and the shared budget allow, else reads it per update
+static int keep_state_file(const gchar *path) {
+    if (kept_fds >= CPU_IDLE_MAX_KEPT_FDS) return FD_BUDGET_PER_READ;
+    int fd = fd_budget_open(path);
+    if (fd >= 0) kept_fds++;
+    return fd == -1 ? FD_BUDGET_PER_READ : fd;
+}
+
+void cpu_idle_init(gint num_cpus) {
+    cpu_count = CLAMP(num_cpus, 1, MAX_CPU_CORES);
+    max_states = 0;
+    for (gint cpu = 0; cpu < cpu_count; cpu++) {
+        state_counts[cpu] = 0;
+        for (gint s = 0; s < CPU_IDLE_MAX_STATES; s++) {
+            char path[128];
+            snprintf(path, sizeof(path), CPUIDLE_PATH, cpu, s, "time");
+            if (access(path, R_OK) != 0) break;
+
+            IdleState *st = &states[cpu][s];
+            memset(st, 0, sizeof(*st));
+            st->time_fd = keep_state_file(path);
+            snprintf(path, sizeof(path), CPUIDLE_PATH, cpu, s, "usage");
+            st->usage_fd = keep_state_file(path);
+            read_u64_at(st->time_fd, cpu, s, "time", &st->prev_time);
+            read_u64_at(st->usage_fd, cpu, s, "usage", &st->prev_usage);
+            state_counts[cpu] = s + 1;
+
+            if (s >= max_states) {
+                snprintf(path, sizeof(path), CPUIDLE_PATH, cpu, s, "name");
+                FILE *fp = fopen(path, "r");
+                snprintf(state_names[s], sizeof(state_names[s]), "state%d", s);
+                if (fp) {
+                    if (fgets(state_names[s], sizeof(state_names[s]), fp)) {
+                        state_names[s][strcspn(state_names[s], "\n")] = '\0';
+                    }
+                    fclose(fp);
+                }
+                max_states = s + 1;
+            }
+        }
+    }
+    if (max_states == 0) g_print("cpuidle not available, idle-state residency disabled\n");
+    last_update_us = g_get_monotonic_time();
+    initialized = TRUE;
+}
+
+void cpu_idle_update(void) {
+    if (!initialized) cpu_idle_init(sysconf(_SC_NPROCESSORS_ONLN));
+    gint64 now = g_get_monotonic_time();
+    gint64 elapsed = now - last_update_us;
+    last_update_us = now;
+
+    for (gint cpu = 0; cpu < cpu_count; cpu++) {
+        for (gint s = 0; s < state_counts[cpu]; s++) {
+            IdleState *st = &states[cpu][s];
+            guint64 time_us = st->prev_time, usage = st->prev_usage;
+            read_u64_at(st->time_fd, cpu, s, "time", &time_us);
+            read_u64_at(st->usage_fd, cpu, s, "usage", &usage);
+            if (elapsed > 0) {
+                st->residency = time_us >= st->prev_time
+                    ? CLAMP(100.0 * (time_us - st->prev_time) / elapsed, 0.0, 100.0) : 0.0;
+                st->usage_rate = usage >= st->prev_usage
+                    ? (usage - st->prev_usage) * (gdouble)G_USEC_PER_SEC / elapsed : 0.0;
+            }
+            st->prev_time = time_us;
+            st->prev_usage = usage;
+        }
+    }
+}
+
+void cpu_idle_cleanup(void) {
+    for (gint cpu = 0; cpu < cpu_count; cpu++) {
+        for (gint s = 0; s < state_counts[cpu]; s++) {
+            fd_budget_close(states[cpu][s].time_fd);
+            fd_budget_close(states[cpu][s].usage_fd);
+        }
+        state_counts[cpu] = 0;
+    }
+    kept_fds = 0;
+    initialized = FALSE;
+}
+
+gboolean cpu_idle_available(void) {
+    return max_states > 0;
+}
+
+gint cpu_idle_get_state_count(void) {
+    return max_states;
+}
+
+const gchar* cpu_idle_get_state_name(gint state) {
+    return (state >= 0 && state < max_states) ? state_names[state] : "";
+}
+
+gdouble cpu_idle_get_residency(gint cpu, gint state) {
+    if (cpu < 0 || cpu >= cpu_count || state < 0 || state >= state_counts[cpu]) return 0.0;
+    return states[cpu][state].residency;
+}
+
+gdouble cpu_idle_get_usage_rate(gint cpu, gint state) {
+    if (cpu < 0 || cpu >= cpu_count || state < 0 || state >= state_counts[cpu]) return 0.0;
+    return states[cpu][state].usage_rate;
+}
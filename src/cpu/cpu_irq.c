@@ -0,0 +1,260 @@
+#include "cpu/cpu_irq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Counters older than this are stale (the page was not visible); re-baseline */
+#define CPU_IRQ_MAX_INTERVAL_US (10 * G_USEC_PER_SEC)
+/* Sources missing from this many passes (unregistered IRQs) are dropped */
+#define CPU_IRQ_FORGET_PASSES 30
+
+typedef struct {
+    const gchar *path;
+    CpuIrqKind kind;
+    int fd;
+} IrqFile;
+
+static IrqFile irq_files[] = {
+    { "/proc/interrupts", CPU_IRQ_HARD, -1 },
+    { "/proc/softirqs", CPU_IRQ_SOFT, -1 },
+};
+
+static GArray *sources = NULL;          // CpuIrqSource
+static GHashTable *source_index = NULL; // "kind:name" -> index + 1
+static gchar *read_buf = NULL;
+static gsize read_buf_size = 0;
+static gint64 last_update_us = 0;
+static guint update_tick = 0;
+static gdouble max_rate = 0.0;
+
+// Whole file into read_buf; the buffer grows to fit and is reused
+static gssize read_whole(int fd) {
+    if (!read_buf) {
+        read_buf_size = 64 * 1024;
+        read_buf = g_malloc(read_buf_size);
+    }
+    gsize len = 0;
+    for (;;) {
+        ssize_t n = pread(fd, read_buf + len, read_buf_size - len - 1, len);
+        if (n < 0) return -1;
+        if (n == 0) break;
+        len += n;
+        if (len + 1 >= read_buf_size) {
+            read_buf_size *= 2;
+            read_buf = g_realloc(read_buf, read_buf_size);
+        }
+    }
+    read_buf[len] = '\0';
+    return len;
+}
+
+static void format_source_key(char *key, gsize size, CpuIrqKind kind, const char *name, gsize name_len) {
+    snprintf(key, size, "%d:%.*s", kind, (int)name_len, name);
+}
+
+static CpuIrqSource* lookup_source(CpuIrqKind kind, const char *name, gsize name_len) {
+    char key[24];
+    name_len = MIN(name_len, sizeof(((CpuIrqSource *)0)->name) - 1);
+    format_source_key(key, sizeof(key), kind, name, name_len);
+    gint index = GPOINTER_TO_INT(g_hash_table_lookup(source_index, key)) - 1;
+    if (index < 0) {
+        CpuIrqSource src = {0};
+        memcpy(src.name, name, name_len);
+        src.kind = kind;
+        g_array_append_val(sources, src);
+        index = sources->len - 1;
+        g_hash_table_insert(source_index, g_strdup(key), GINT_TO_POINTER(index + 1));
+    }
+    return &g_array_index(sources, CpuIrqSource, index);
+}
+
+// Copy the description with runs of spaces collapsed
+static void copy_desc(gchar *dst, gsize dst_size, const char *src, const char *end) {
+    gsize n = 0;
+    gboolean space = FALSE;
+    for (; src < end && n + 1 < dst_size; src++) {
+        if (*src == ' ' || *src == '\t') {
+            space = n > 0;
+            continue;
+        }
+        if (space && n + 2 < dst_size) dst[n++] = ' ';
+        space = FALSE;
+        dst[n++] = *src;
+    }
+    dst[n] = '\0';
+}
+
+static void parse_irq_file(IrqFile *file, gdouble elapsed_s) {
+    if (file->fd < 0 || read_whole(file->fd) <= 0) return;
+
+    // Header: "CPU0 CPU1 ..." lists only online CPUs, so map columns to ids
+    gint col_cpu[MAX_CPU_CORES];
+    gint ncols = 0;
+    char *p = read_buf;
+    char *eol = strchr(p, '\n');
+    if (!eol) return;
+    *eol = '\0';   // keep strstr on the header line
+    while (ncols < MAX_CPU_CORES) {
+        char *cpu = strstr(p, "CPU");
+        if (!cpu) break;
+        col_cpu[ncols++] = atoi(cpu + 3);
+        p = cpu + 3;
+    }
+    *eol = '\n';
+    if (ncols == 0) return;
+
+    for (p = eol + 1; *p; p = eol + 1) {
+        eol = strchr(p, '\n');
+        if (!eol) eol = p + strlen(p);
+
+        while (*p == ' ') p++;
+        char *colon = memchr(p, ':', eol - p);
+        if (!colon) {
+            if (!*eol) break;
+            continue;
+        }
+        const char *name = p;
+        gsize name_len = colon - p;
+        // ERR/MIS carry a single total; with one CPU that looks like a per-CPU column
+        if (file->kind == CPU_IRQ_HARD && name_len == 3 &&
+            (strncmp(name, "ERR", 3) == 0 || strncmp(name, "MIS", 3) == 0)) {
+            if (!*eol) break;
+            continue;
+        }
+
+        // Counters, one per CPU column
+        guint64 counts[MAX_CPU_CORES];
+        gint n = 0;
+        p = colon + 1;
+        while (n < ncols) {
+            while (*p == ' ') p++;
+            if (*p < '0' || *p > '9') break;
+            guint64 v = 0;
+            while (*p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+            counts[n++] = v;
+        }
+
+        if (n == ncols) {
+            CpuIrqSource *src = lookup_source(file->kind, name, name_len);
+            if (file->kind == CPU_IRQ_HARD) copy_desc(src->desc, sizeof(src->desc), p, eol);
+            src->seen_tick = update_tick;
+            src->total_rate = 0.0;
+            // CPUs that went offline drop out of the columns
+            memset(src->rate, 0, sizeof(src->rate));
+            gdouble busiest = -1.0;
+            for (gint c = 0; c < ncols; c++) {
+                gint cpu = col_cpu[c];
+                if (cpu < 0 || cpu >= MAX_CPU_CORES) continue;
+                gdouble rate = 0.0;
+                if (src->have_prev && elapsed_s > 0 && counts[c] >= src->prev[cpu]) {
+                    rate = (counts[c] - src->prev[cpu]) / elapsed_s;
+                }
+                src->prev[cpu] = counts[c];
+                src->rate[cpu] = rate;
+                src->total_rate += rate;
+                if (rate > busiest) {
+                    busiest = rate;
+                    src->busiest_cpu = cpu;
+                }
+                max_rate = MAX(max_rate, rate);
+            }
+            src->have_prev = TRUE;
+        }
+        if (!*eol) break;
+    }
+}
+
+void cpu_irq_init(void) {
+    if (!sources) {
+        sources = g_array_new(FALSE, TRUE, sizeof(CpuIrqSource));
+        source_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    }
+    for (gsize i = 0; i < G_N_ELEMENTS(irq_files); i++) {
+        if (irq_files[i].fd < 0) irq_files[i].fd = open(irq_files[i].path, O_RDONLY | O_CLOEXEC);
+        if (irq_files[i].fd < 0) g_printerr("Could not open %s\n", irq_files[i].path);
+    }
+}
+
+void cpu_irq_update(void) {
+    if (!sources) cpu_irq_init();
+
+    gint64 now = g_get_monotonic_time();
+    gint64 elapsed = now - last_update_us;
+    last_update_us = now;
+    // A long gap would average away any burst; only take a new baseline
+    gdouble elapsed_s = (elapsed > 0 && elapsed <= CPU_IRQ_MAX_INTERVAL_US) ? elapsed / (gdouble)G_USEC_PER_SEC : 0.0;
+
+    max_rate = 0.0;
+    update_tick++;
+    for (gsize i = 0; i < G_N_ELEMENTS(irq_files); i++) {
+        parse_irq_file(&irq_files[i], elapsed_s);
+    }
+
+    // A source missing from this pass (unregistered IRQ, unreadable file) has no rate
+    guint kept = 0;
+    for (guint i = 0; i < sources->len; i++) {
+        CpuIrqSource *src = &g_array_index(sources, CpuIrqSource, i);
+        if (src->seen_tick != update_tick) {
+            if (update_tick - src->seen_tick >= CPU_IRQ_FORGET_PASSES) continue;
+            memset(src->rate, 0, sizeof(src->rate));
+            src->total_rate = 0.0;
+            src->have_prev = FALSE;
+        }
+        if (kept != i) g_array_index(sources, CpuIrqSource, kept) = *src;
+        kept++;
+    }
+    if (kept == sources->len) return;
+
+    // Some were dropped: compact and index the survivors again
+    g_array_set_size(sources, kept);
+    g_hash_table_remove_all(source_index);
+    for (guint i = 0; i < sources->len; i++) {
+        const CpuIrqSource *src = &g_array_index(sources, CpuIrqSource, i);
+        char key[24];
+        format_source_key(key, sizeof(key), src->kind, src->name, strlen(src->name));
+        g_hash_table_insert(source_index, g_strdup(key), GINT_TO_POINTER(i + 1));
+    }
+}
+
+void cpu_irq_cleanup(void) {
+    for (gsize i = 0; i < G_N_ELEMENTS(irq_files); i++) {
+        if (irq_files[i].fd >= 0) close(irq_files[i].fd);
+        irq_files[i].fd = -1;
+    }
+    if (sources) g_array_free(sources, TRUE);
+    if (source_index) g_hash_table_destroy(source_index);
+    sources = NULL;
+    source_index = NULL;
+    g_free(read_buf);
+    read_buf = NULL;
+    read_buf_size = 0;
+}
+
+gboolean cpu_irq_available(void) {
+    return irq_files[0].fd >= 0 || irq_files[1].fd >= 0;
+}
+
+gint cpu_irq_get_top(gint kind, const CpuIrqSource **out, gint max) {
+    if (!sources || max <= 0) return 0;
+    gint count = 0;
+    for (guint i = 0; i < sources->len; i++) {
+        const CpuIrqSource *src = &g_array_index(sources, CpuIrqSource, i);
+        if ((kind >= 0 && src->kind != (CpuIrqKind)kind) || src->total_rate <= 0.0) continue;
+
+        // Insertion into a short sorted list, like the per-core top processes
+        gint pos = count;
+        while (pos > 0 && out[pos - 1]->total_rate < src->total_rate) pos--;
+        if (pos >= max) continue;
+        gint last = MIN(count, max - 1);
+        memmove(&out[pos + 1], &out[pos], (last - pos) * sizeof(*out));
+        out[pos] = src;
+        if (count < max) count++;
+    }
+    return count;
+}
+
+gdouble cpu_irq_get_max_rate(void) {
+    return max_rate;
+}
@@ -0,0 +1,195 @@
+#include "cpu/cpu_perf.h"
+#include "utils/fd_budget.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CPU_PERF_MAX_EVENTS 4
+
+G_DEFINE_QUARK(cpu-perf-error-quark, cpu_perf_error)
+
+typedef struct {
+    guint32 type;
+    guint64 config;
+} PerfEventSpec;
+
+// Order matters: the deltas are read back by position
+static const PerfEventSpec hardware_events[] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+static const PerfEventSpec software_events[] = {
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+// Layout of a PERF_FORMAT_GROUP read with both time fields
+typedef struct {
+    guint64 nr;
+    guint64 time_enabled;
+    guint64 time_running;
+    guint64 values[CPU_PERF_MAX_EVENTS];
+} PerfGroupRead;
+
+typedef struct {
+    int fds[CPU_PERF_MAX_EVENTS];   // fds[0] is the group leader
+    PerfGroupRead prev;
+    gboolean have_prev;
+} PerfGroup;
+
+static PerfGroup groups[MAX_CPU_CORES];
+static CpuPerfSample samples[MAX_CPU_CORES];
+static gdouble perf_history[MAX_CPU_CORES][MAX_POINTS] = {{0.0}};
+static gint history_index = 0;
+static guint64 sample_count = 0;
+static gint cpu_count = 0;
+static gint n_events = 0;
+static CpuPerfMode mode = CPU_PERF_OFF;
+
+static int perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd, unsigned long flags) {
+    return syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+static void close_group(PerfGroup *group) {
+    for (gint e = CPU_PERF_MAX_EVENTS - 1; e >= 0; e--) {
+        fd_budget_close(group->fds[e]);
+        group->fds[e] = -1;
+    }
+    group->have_prev = FALSE;
+}
+
+// Returns 0 or the errno of the first event that failed; EMFILE when the fd budget is used up
+static int open_group(PerfGroup *group, gint cpu, const PerfEventSpec *events, gint count) {
+    for (gint e = 0; e < CPU_PERF_MAX_EVENTS; e++) group->fds[e] = -1;
+    if (!fd_budget_reserve(count)) return EMFILE;
+    for (gint e = 0; e < count; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[e].type;
+        attr.config = events[e].config;
+        attr.disabled = (e == 0);   // the leader starts the whole group
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // pid -1 with a cpu counts everything that runs on that CPU
+        group->fds[e] = perf_event_open(&attr, -1, cpu, e == 0 ? -1 : group->fds[0], PERF_FLAG_FD_CLOEXEC);
+        if (group->fds[e] < 0) {
+            int err = errno;
+            fd_budget_release(count - e);   // close_group() returns the ones that opened
+            close_group(group);
+            return err;
+        }
+    }
+    ioctl(group->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return 0;
+}
+
+gboolean cpu_perf_enable(gint num_cpus, GError **error) {
+    cpu_perf_disable();
+    cpu_count = CLAMP(num_cpus, 1, MAX_CPU_CORES);
+
+    // Probe on CPU 0: no PMU means software events, no permission means nothing
+    const PerfEventSpec *events = hardware_events;
+    n_events = G_N_ELEMENTS(hardware_events);
+    int err = open_group(&groups[0], 0, events, n_events);
+    if (err == ENOENT || err == EOPNOTSUPP || err == ENODEV || err == EINVAL) {
+        events = software_events;
+        n_events = G_N_ELEMENTS(software_events);
+        err = open_group(&groups[0], 0, events, n_events);
+    }
+    if (err != 0) {
+        g_set_error(error, CPU_PERF_ERROR,
+                    (err == EACCES || err == EPERM) ? CPU_PERF_ERROR_PERMISSION : CPU_PERF_ERROR_UNSUPPORTED,
+                    "perf_event_open failed: %s", g_strerror(err));
+        cpu_count = 0;
+        return FALSE;
+    }
+    mode = events == hardware_events ? CPU_PERF_HARDWARE : CPU_PERF_SOFTWARE;
+    g_print("perf counters enabled (%s events)\n", mode == CPU_PERF_HARDWARE ? "hardware" : "software");
+
+    gint skipped = 0;
+    for (gint cpu = 1; cpu < cpu_count; cpu++) {
+        // Offline CPUs fail here and simply report nothing
+        if (open_group(&groups[cpu], cpu, events, n_events) == EMFILE) skipped++;
+    }
+    if (skipped > 0) g_print("perf counters: fd budget reached, %d CPUs not counted\n", skipped);
+    memset(samples, 0, sizeof(samples));
+    memset(perf_history, 0, sizeof(perf_history));
+    return TRUE;
+}
+
+void cpu_perf_disable(void) {
+    for (gint cpu = 0; cpu < cpu_count; cpu++) close_group(&groups[cpu]);
+    cpu_count = 0;
+    mode = CPU_PERF_OFF;
+}
+
+static void compute_sample(CpuPerfSample *s, const PerfGroupRead *now, const PerfGroupRead *prev) {
+    guint64 enabled = now->time_enabled - prev->time_enabled;
+    guint64 running = now->time_running - prev->time_running;
+    if (enabled == 0 || running == 0) return;
+    // Groups share the PMU with other users; scale counts up to the full interval
+    gdouble scale = (gdouble)enabled / running;
+    gdouble seconds = enabled / 1e9;
+    guint64 d[CPU_PERF_MAX_EVENTS];
+    for (gint e = 0; e < n_events; e++) d[e] = now->values[e] - prev->values[e];
+
+    memset(s, 0, sizeof(*s));
+    s->multiplexed = running < enabled;
+    if (mode == CPU_PERF_HARDWARE) {
+        s->ipc = d[0] > 0 ? (gdouble)d[1] / d[0] : 0.0;
+        s->llc_mpki = d[1] > 0 ? 1000.0 * d[2] / d[1] : 0.0;
+        s->branch_mpki = d[1] > 0 ? 1000.0 * d[3] / d[1] : 0.0;
+        s->cycles_ghz = d[0] * scale / seconds / 1e9;
+    } else {
+        s->busy_percent = MIN(100.0, 100.0 * d[0] * scale / enabled);
+        s->ctx_switches = d[1] * scale / seconds;
+        s->page_faults = d[2] * scale / seconds;
+    }
+}
+
+void cpu_perf_update(void) {
+    if (mode == CPU_PERF_OFF) return;
+    for (gint cpu = 0; cpu < cpu_count; cpu++) {
+        PerfGroup *group = &groups[cpu];
+        if (group->fds[0] < 0) continue;
+        PerfGroupRead now;
+        // One read returns every counter of the group
+        if (read(group->fds[0], &now, sizeof(now)) < (ssize_t)(3 + n_events) * (ssize_t)sizeof(guint64)) continue;
+        if (group->have_prev) compute_sample(&samples[cpu], &now, &group->prev);
+        group->prev = now;
+        group->have_prev = TRUE;
+        perf_history[cpu][history_index] = mode == CPU_PERF_HARDWARE
+            ? MIN(100.0, 100.0 * samples[cpu].ipc / CPU_PERF_IPC_SCALE)
+            : samples[cpu].busy_percent;
+    }
+    history_index = (history_index + 1) % MAX_POINTS;
+    sample_count++;
+}
+
+CpuPerfMode cpu_perf_get_mode(void) {
+    return mode;
+}
+
+const CpuPerfSample* cpu_perf_get_sample(gint cpu) {
+    if (mode == CPU_PERF_OFF || cpu < 0 || cpu >= cpu_count || groups[cpu].fds[0] < 0) return NULL;
+    return &samples[cpu];
+}
+
+const gdouble* cpu_perf_get_history(gint cpu) {
+    return (cpu >= 0 && cpu < MAX_CPU_CORES) ? perf_history[cpu] : NULL;
+}
+
+gint cpu_perf_get_history_index(void) {
+    return history_index;
+}
+
+guint64 cpu_perf_get_sample_count(void) {
+    return sample_count;
+}
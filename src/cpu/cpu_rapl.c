@@ -0,0 +1,165 @@
+#include "cpu/cpu_rapl.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+
+typedef struct {
+    gchar name[48];
+    gboolean package;
+    int energy_fd;
+    guint64 max_range_uj;
+    guint64 prev_uj;
+    gint64 prev_us;
+    gdouble watts;
+} RaplDomain;
+
+static RaplDomain domains[CPU_RAPL_MAX_DOMAINS];
+static gint domain_count = 0;
+static gdouble power_history[CPU_RAPL_MAX_DOMAINS][MAX_POINTS] = {{0.0}};
+static gint history_index = 0;
+static gboolean permission_denied = FALSE;
+
+static gboolean pread_u64(int fd, guint64 *value) {
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return FALSE;
+    buf[n] = '\0';
+    *value = g_ascii_strtoull(buf, NULL, 10);
+    return TRUE;
+}
+
+static gboolean read_zone_string(const gchar *root, const gchar *zone, const gchar *file, gchar *buf, gsize size) {
+    gchar *path = g_strdup_printf("%s/%s/%s", root, zone, file);
+    FILE *fp = fopen(path, "r");
+    g_free(path);
+    if (!fp) return FALSE;
+    gboolean ok = fgets(buf, size, fp) != NULL;
+    fclose(fp);
+    if (ok) buf[strcspn(buf, "\n")] = '\0';
+    return ok;
+}
+
+static gint compare_zone_names(gconstpointer a, gconstpointer b) {
+    return g_strcmp0(*(const gchar *const *)a, *(const gchar *const *)b);
+}
+
+static void add_domain(const gchar *root, const gchar *zone) {
+    if (domain_count >= CPU_RAPL_MAX_DOMAINS) return;
+    RaplDomain *d = &domains[domain_count];
+    memset(d, 0, sizeof(*d));
+
+    gchar name[32], buf[32];
+    if (!read_zone_string(root, zone, "name", name, sizeof(name))) return;
+    // Subzones ("intel-rapl:0:1") are named after their package
+    const gchar *sub = strchr(strchr(zone, ':') + 1, ':');
+    if (sub) {
+        gchar *parent = g_strndup(zone, sub - zone);
+        gchar parent_name[32];
+        if (!read_zone_string(root, parent, "name", parent_name, sizeof(parent_name))) g_strlcpy(parent_name, parent, sizeof(parent_name));
+        snprintf(d->name, sizeof(d->name), "%s/%s", parent_name, name);
+        g_free(parent);
+    } else {
+        g_strlcpy(d->name, name, sizeof(d->name));
+        d->package = TRUE;
+    }
+    if (read_zone_string(root, zone, "max_energy_range_uj", buf, sizeof(buf))) {
+        d->max_range_uj = g_ascii_strtoull(buf, NULL, 10);
+    }
+
+    gchar *path = g_strdup_printf("%s/%s/energy_uj", root, zone);
+    d->energy_fd = open(path, O_RDONLY | O_CLOEXEC);
+    g_free(path);
+    if (d->energy_fd < 0 || !pread_u64(d->energy_fd, &d->prev_uj)) {
+        if (errno == EACCES || errno == EPERM) permission_denied = TRUE;
+        if (d->energy_fd >= 0) close(d->energy_fd);
+        return;
+    }
+    d->prev_us = g_get_monotonic_time();
+    domain_count++;
+}
+
+void cpu_rapl_init(const gchar *root) {
+    cpu_rapl_cleanup();
+    if (!root) root = CPU_RAPL_ROOT;
+    DIR *dir = opendir(root);
+    if (!dir) return;
+
+    // "intel-rapl:N" and "intel-rapl:N:M"; intel-rapl-mmio zones duplicate the packages
+    GPtrArray *zones = g_ptr_array_new_with_free_func(g_free);
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "intel-rapl:", 11) == 0) g_ptr_array_add(zones, g_strdup(entry->d_name));
+    }
+    closedir(dir);
+    g_ptr_array_sort(zones, compare_zone_names);
+    for (guint i = 0; i < zones->len; i++) add_domain(root, g_ptr_array_index(zones, i));
+    g_ptr_array_free(zones, TRUE);
+
+    if (domain_count == 0 && permission_denied) {
+        g_print("RAPL energy counters are only readable by root\n");
+    }
+}
+
+void cpu_rapl_update(void) {
+    cpu_rapl_update_at(g_get_monotonic_time());
+}
+
+void cpu_rapl_update_at(gint64 now_us) {
+    for (gint i = 0; i < domain_count; i++) {
+        RaplDomain *d = &domains[i];
+        guint64 now_uj;
+        if (!pread_u64(d->energy_fd, &now_uj)) continue;
+
+        guint64 delta_uj;
+        if (now_uj >= d->prev_uj) delta_uj = now_uj - d->prev_uj;
+        else if (d->max_range_uj > d->prev_uj) delta_uj = d->max_range_uj - d->prev_uj + now_uj;   // wrapped
+        else delta_uj = now_uj;   // no usable range; undercounts one interval at most
+        gint64 delta_us = now_us - d->prev_us;
+        // µJ per µs is watts
+        if (delta_us > 0) d->watts = (gdouble)delta_uj / delta_us;
+        d->prev_uj = now_uj;
+        d->prev_us = now_us;
+        power_history[i][history_index] = d->watts;
+    }
+    history_index = (history_index + 1) % MAX_POINTS;
+}
+
+void cpu_rapl_cleanup(void) {
+    for (gint i = 0; i < domain_count; i++) {
+        if (domains[i].energy_fd >= 0) close(domains[i].energy_fd);
+    }
+    domain_count = 0;
+    permission_denied = FALSE;
+    memset(power_history, 0, sizeof(power_history));
+}
+
+gint cpu_rapl_get_domain_count(void) {
+    return domain_count;
+}
+
+const gchar* cpu_rapl_get_domain_name(gint domain) {
+    return (domain >= 0 && domain < domain_count) ? domains[domain].name : "";
+}
+
+gboolean cpu_rapl_is_package(gint domain) {
+    return domain >= 0 && domain < domain_count && domains[domain].package;
+}
+
+gdouble cpu_rapl_get_watts(gint domain) {
+    return (domain >= 0 && domain < domain_count) ? domains[domain].watts : 0.0;
+}
+
+const gdouble* cpu_rapl_get_history(gint domain) {
+    return (domain >= 0 && domain < domain_count) ? power_history[domain] : NULL;
+}
+
+gint cpu_rapl_get_history_index(void) {
+    return history_index;
+}
+
+gboolean cpu_rapl_permission_denied(void) {
+    return permission_denied;
+}
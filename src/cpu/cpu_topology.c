@@ -0,0 +1,148 @@
+#include "cpu/cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+
+static CpuTopoEntry by_cpu[MAX_CPU_CORES];
+static CpuTopoEntry ordered[MAX_CPU_CORES];
+static gint topo_count = 0;
+static gint package_count = 1;
+static gint physical_core_count = 1;
+static gint node_count = 1;
+static gint threads_per_core = 1;
+static gint group_count = 1;
+static gint group_ids[MAX_NUMA_NODES];   // node or package id of each group
+static gboolean groups_are_nodes = FALSE;
+
+static gint read_sysfs_int(const gchar *path, gint fallback) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return fallback;
+    gint value = fallback;
+    if (fscanf(fp, "%d", &value) != 1) value = fallback;
+    fclose(fp);
+    return value;
+}
+
+/* Mark every CPU of a cpulist ("0-3,8-11") as belonging to @node */
+static void apply_node_cpulist(const gchar *list, gint node, gint num_cpus) {
+    const gchar *p = list;
+    while (*p && *p != '\n') {
+        char *end = NULL;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < num_cpus; cpu++) {
+            if (cpu >= 0) by_cpu[cpu].node = node;
+        }
+        if (*p == ',') p++;
+    }
+}
+
+static void read_nodes(gint num_cpus) {
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) return;
+    struct dirent *entry;
+    gint nodes = 0;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) != 0 || !isdigit((unsigned char)entry->d_name[4])) continue;
+        gint node = atoi(entry->d_name + 4);
+        char path[128], list[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+        FILE *fp = fopen(path, "r");
+        if (!fp) continue;
+        if (fgets(list, sizeof(list), fp)) {
+            apply_node_cpulist(list, node, num_cpus);
+            if (list[0] != '\n') nodes++;   // memory-only nodes have no CPUs
+        }
+        fclose(fp);
+    }
+    closedir(dir);
+    node_count = MAX(1, nodes);
+}
+
+static gint compare_topo(gconstpointer a, gconstpointer b) {
+    const CpuTopoEntry *x = a, *y = b;
+    if (x->group != y->group) return x->group - y->group;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+/* Dense index for a node or package id, adding it if there is room */
+static gint group_index(gint id) {
+    for (gint g = 0; g < group_count; g++) {
+        if (group_ids[g] == id) return g;
+    }
+    if (group_count >= MAX_NUMA_NODES) return MAX_NUMA_NODES - 1;
+    group_ids[group_count] = id;
+    return group_count++;
+}
+
+void cpu_topology_init(gint num_cpus) {
+    topo_count = CLAMP(num_cpus, 1, MAX_CPU_CORES);
+    for (gint cpu = 0; cpu < topo_count; cpu++) {
+        char path[128];
+        by_cpu[cpu].cpu = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        by_cpu[cpu].package = MAX(0, read_sysfs_int(path, 0));
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        by_cpu[cpu].core = read_sysfs_int(path, cpu);
+        by_cpu[cpu].node = 0;
+    }
+    read_nodes(topo_count);
+
+    // Packages, physical cores and SMT width from distinct ids
+    GHashTable *packages = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GHashTable *cores = g_hash_table_new(g_int64_hash, g_int64_equal);
+    gint64 *core_keys = g_new(gint64, topo_count);
+    threads_per_core = 1;
+    for (gint cpu = 0; cpu < topo_count; cpu++) {
+        g_hash_table_add(packages, GINT_TO_POINTER(by_cpu[cpu].package));
+        core_keys[cpu] = ((gint64)by_cpu[cpu].package << 32) | (guint32)by_cpu[cpu].core;
+        gint siblings = GPOINTER_TO_INT(g_hash_table_lookup(cores, &core_keys[cpu])) + 1;
+        g_hash_table_insert(cores, &core_keys[cpu], GINT_TO_POINTER(siblings));
+        threads_per_core = MAX(threads_per_core, siblings);
+    }
+    package_count = MAX(1, (gint)g_hash_table_size(packages));
+    physical_core_count = MAX(1, (gint)g_hash_table_size(cores));
+    g_hash_table_destroy(packages);
+    g_hash_table_destroy(cores);
+    g_free(core_keys);
+
+    groups_are_nodes = node_count > 1;
+    group_count = 0;
+    for (gint cpu = 0; cpu < topo_count; cpu++) {
+        by_cpu[cpu].group = group_index(groups_are_nodes ? by_cpu[cpu].node : by_cpu[cpu].package);
+    }
+    group_count = MAX(1, group_count);
+
+    memcpy(ordered, by_cpu, topo_count * sizeof(CpuTopoEntry));
+    qsort(ordered, topo_count, sizeof(CpuTopoEntry), compare_topo);
+}
+
+const CpuTopoEntry* cpu_topology_get_ordered(gint *count) {
+    if (count) *count = topo_count;
+    return ordered;
+}
+
+const CpuTopoEntry* cpu_topology_get_cpu(gint cpu) {
+    return (cpu >= 0 && cpu < topo_count) ? &by_cpu[cpu] : NULL;
+}
+
+gint cpu_topology_get_packages(void) { return package_count; }
+gint cpu_topology_get_physical_cores(void) { return physical_core_count; }
+gint cpu_topology_get_nodes(void) { return node_count; }
+gint cpu_topology_get_threads_per_core(void) { return threads_per_core; }
+gint cpu_topology_get_group_count(void) { return group_count; }
+
+void cpu_topology_get_group_label(gint group, gchar *buf, gsize buf_size) {
+    gint id = (group >= 0 && group < group_count) ? group_ids[group] : group;
+    snprintf(buf, buf_size, "%s %d", groups_are_nodes ? "Node" : "Package", id);
+}
@@ -1,4 +1,5 @@
 #include "gpu/gpu_data.h"
+#include "gpu/gpu_fdinfo.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -295,21 +296,29 @@ void gpu_data_init(void) {
     memset(gpu_infos, 0, sizeof(gpu_infos));
     gpu_count = 0;
     
-    FILE *fp_nvidia = popen("nvidia-smi --query-gpu=index,name,driver_version --format=csv,noheader 2>/dev/null", "r");
+    FILE *fp_nvidia = popen("nvidia-smi --query-gpu=index,name,driver_version,pci.bus_id --format=csv,noheader 2>/dev/null", "r");
     if (fp_nvidia) {
         char line[512];
         while (fgets(line, sizeof(line), fp_nvidia) && gpu_count < MAX_GPUS) {
             int index;
             char name[256];
             char driver[64];
+            char bus_id[32] = {0};
             
-            if (sscanf(line, "%d, %255[^,], %63[^\n]", &index, name, driver) == 3) {
+            if (sscanf(line, "%d, %255[^,], %63[^,], %31[^\n]", &index, name, driver, bus_id) >= 3) {
                 GPUInfo *gpu = &gpu_infos[gpu_count];
                 
                 gpu->gpu_id = index;
                 strncpy(gpu->name, name, sizeof(gpu->name) - 1);
                 strncpy(gpu->vendor, "NVIDIA", sizeof(gpu->vendor) - 1);
                 strncpy(gpu->driver_version, driver, sizeof(gpu->driver_version) - 1);
+                // nvidia-smi reports an 8-digit domain ("00000000:01:00.0"), the kernel uses 4
+                trim_newline(bus_id);
+                size_t bus_len = strlen(bus_id);
+                if (bus_len >= 12) {
+                    strncpy(gpu->pci_slot, bus_id + bus_len - 12, sizeof(gpu->pci_slot) - 1);
+                    for (char *c = gpu->pci_slot; *c; c++) *c = tolower((unsigned char)*c);
+                }
                 
                 for (int i = 0; i < GPU_MAX_POINTS; i++) {
                     gpu->usage_history[i] = 0.0;
@@ -354,6 +363,16 @@ void gpu_data_init(void) {
                     if (strlen(driver) > 0) {
                         GPUInfo *gpu = &gpu_infos[gpu_count];
                         gpu->gpu_id = i;
+
+                        // PCI slot of the card, used to match per-process fdinfo stats
+                        char device_path[256];
+                        char device_link[512] = {0};
+                        snprintf(device_path, sizeof(device_path), "/sys/class/drm/card%d/device", i);
+                        ssize_t dev_len = readlink(device_path, device_link, sizeof(device_link) - 1);
+                        if (dev_len > 0) {
+                            device_link[dev_len] = '\0';
+                            get_basename(device_link, gpu->pci_slot, sizeof(gpu->pci_slot));
+                        }
                         
                         // Try to get model name
                         snprintf(path, sizeof(path), "/sys/class/drm/card%d/device/product", i);
@@ -548,6 +567,7 @@ void gpu_data_init(void) {
 }
 
 void gpu_data_cleanup(void) {
+    gpu_fdinfo_cleanup();
     for (int i = 0; i < MAX_GPUS; i++) {
         memset(&gpu_infos[i], 0, sizeof(GPUInfo));
     }
@@ -661,6 +681,8 @@ static void update_from_intel_gpu_top(GPUInfo *gpu) {
 }
 
 void gpu_data_update(void) {
+    gpu_fdinfo_update();
+
     for (int i = 0; i < gpu_count; i++) {
         GPUInfo *gpu = &gpu_infos[i];
         
@@ -0,0 +1,446 @@
+#include "gpu/gpu_fdinfo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <ctype.h>
+#include <limits.h>
+
+#define FDINFO_MIN_INTERVAL_US 500000
+// A process's fd table is walked again every this many scans (staggered by pid) to find new DRM fds
+#define FDINFO_RESCAN_SCANS 10
+
+// Previous counters for one DRM client, keyed by "<pdev>/<client-id>"
+typedef struct {
+    DrmEngineSample engines[DRM_MAX_ENGINES];
+    guint n_engines;
+    gint64 timestamp_us;
+    guint last_tick;
+} DrmClientState;
+
+/* DRM fds of one process, so a scan reads their fdinfo directly instead of
+ * readlink()ing every fd. Keyed by pid and checked against the start time,
+ * so a reused pid starts over. */
+typedef struct {
+    guint64 starttime;      // field 22 of /proc/<pid>/stat, 0 if unreadable
+    GArray *fds;            // int
+    gchar comm[64];
+    guint last_tick;
+    gboolean stale;         // a cached fd stopped being a DRM client: walk the table again
+} DrmProcessFds;
+
+static gchar *proc_root = NULL;
+static GHashTable *client_states = NULL;   // gchar* -> DrmClientState*
+static GHashTable *process_fds = NULL;     // pid -> DrmProcessFds*
+static GArray *usage_by_gpu = NULL;        // GpuProcessUsage, one per (pid, pdev)
+static GHashTable *usage_by_pid = NULL;    // pid -> GpuProcessUsage* (totals)
+static gint64 last_update_us = 0;
+static guint update_tick = 0;
+
+//-----------------------------------------------------------------------------
+// Parsing
+
+static guint64 parse_size_bytes(const gchar *value) {
+    gchar *end = NULL;
+    guint64 v = g_ascii_strtoull(value, &end, 10);
+    while (end && *end == ' ') end++;
+    if (end && g_str_has_prefix(end, "KiB")) v *= 1024ULL;
+    else if (end && g_str_has_prefix(end, "MiB")) v *= 1024ULL * 1024ULL;
+    else if (end && g_str_has_prefix(end, "GiB")) v *= 1024ULL * 1024ULL * 1024ULL;
+    return v;
+}
+
+static DrmEngineSample* engine_slot(DrmFdinfo *info, const gchar *name, gsize name_len) {
+    for (guint i = 0; i < info->n_engines; i++) {
+        if (strlen(info->engines[i].name) == name_len &&
+            strncmp(info->engines[i].name, name, name_len) == 0) {
+            return &info->engines[i];
+        }
+    }
+    if (info->n_engines >= DRM_MAX_ENGINES || name_len >= sizeof(info->engines[0].name)) return NULL;
+    DrmEngineSample *e = &info->engines[info->n_engines++];
+    memset(e, 0, sizeof(*e));
+    memcpy(e->name, name, name_len);
+    e->capacity = 1;
+    return e;
+}
+
+static gboolean is_vram_region(const gchar *region) {
+    return g_str_has_prefix(region, "vram") || g_str_has_prefix(region, "local");
+}
+
+gboolean gpu_fdinfo_parse(const gchar *text, DrmFdinfo *out) {
+    if (!text || !out) return FALSE;
+    memset(out, 0, sizeof(*out));
+
+    guint64 resident_vram = 0, resident_system = 0, legacy_vram = 0, legacy_system = 0;
+    gboolean have_resident = FALSE;
+
+    const gchar *line = text;
+    while (line && *line) {
+        const gchar *eol = strchr(line, '\n');
+        gsize len = eol ? (gsize)(eol - line) : strlen(line);
+        const gchar *colon = memchr(line, ':', len);
+
+        if (colon && g_str_has_prefix(line, "drm-")) {
+            gsize key_len = colon - line;
+            char value[64];
+            const gchar *v = colon + 1;
+            while (v < line + len && (*v == ' ' || *v == '\t')) v++;
+            gsize vlen = MIN((gsize)(line + len - v), sizeof(value) - 1);
+            memcpy(value, v, vlen);
+            value[vlen] = '\0';
+
+            #define KEY_IS(lit) (key_len == sizeof(lit) - 1 && strncmp(line, lit, key_len) == 0)
+            #define KEY_PREFIX(lit) (key_len > sizeof(lit) - 1 && strncmp(line, lit, sizeof(lit) - 1) == 0)
+            if (KEY_IS("drm-driver")) {
+                g_strlcpy(out->driver, value, sizeof(out->driver));
+            } else if (KEY_IS("drm-pdev")) {
+                g_strlcpy(out->pdev, value, sizeof(out->pdev));
+            } else if (KEY_IS("drm-client-id")) {
+                out->client_id = g_ascii_strtoull(value, NULL, 10);
+                out->has_client_id = TRUE;
+            } else if (KEY_PREFIX("drm-engine-capacity-")) {
+                const gsize p = sizeof("drm-engine-capacity-") - 1;
+                DrmEngineSample *e = engine_slot(out, line + p, key_len - p);
+                if (e) e->capacity = MAX(1, (guint)g_ascii_strtoull(value, NULL, 10));
+            } else if (KEY_PREFIX("drm-engine-")) {
+                const gsize p = sizeof("drm-engine-") - 1;
+                DrmEngineSample *e = engine_slot(out, line + p, key_len - p);
+                if (e) e->busy_ns = g_ascii_strtoull(value, NULL, 10);
+            } else if (KEY_PREFIX("drm-total-cycles-")) {
+                const gsize p = sizeof("drm-total-cycles-") - 1;
+                DrmEngineSample *e = engine_slot(out, line + p, key_len - p);
+                if (e) e->total_cycles = g_ascii_strtoull(value, NULL, 10);
+            } else if (KEY_PREFIX("drm-cycles-")) {
+                const gsize p = sizeof("drm-cycles-") - 1;
+                DrmEngineSample *e = engine_slot(out, line + p, key_len - p);
+                if (e) e->cycles = g_ascii_strtoull(value, NULL, 10);
+            } else if (KEY_PREFIX("drm-resident-") || KEY_PREFIX("drm-memory-")) {
+                gboolean resident = KEY_PREFIX("drm-resident-");
+                const gsize p = resident ? sizeof("drm-resident-") - 1 : sizeof("drm-memory-") - 1;
+                char region[32];
+                gsize rlen = MIN(key_len - p, sizeof(region) - 1);
+                memcpy(region, line + p, rlen);
+                region[rlen] = '\0';
+                guint64 bytes = parse_size_bytes(value);
+                if (resident) {
+                    have_resident = TRUE;
+                    if (is_vram_region(region)) resident_vram += bytes; else resident_system += bytes;
+                } else {
+                    if (is_vram_region(region)) legacy_vram += bytes; else legacy_system += bytes;
+                }
+            }
+            #undef KEY_IS
+            #undef KEY_PREFIX
+        }
+        line = eol ? eol + 1 : NULL;
+    }
+
+    out->vram_bytes = have_resident ? resident_vram : legacy_vram;
+    out->system_bytes = have_resident ? resident_system : legacy_system;
+    return out->driver[0] != '\0' || out->has_client_id;
+}
+
+//-----------------------------------------------------------------------------
+// Collection
+
+void gpu_fdinfo_set_proc_root(const gchar *root) {
+    g_free(proc_root);
+    proc_root = root ? g_strdup(root) : NULL;
+    last_update_us = 0;
+    if (client_states) g_hash_table_remove_all(client_states);
+    if (process_fds) g_hash_table_remove_all(process_fds);
+}
+
+static const gchar* get_proc_root(void) {
+    return proc_root ? proc_root : "/proc";
+}
+
+static gboolean read_small_file(const char *path, char *buf, gsize size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return FALSE;
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n <= 0) return FALSE;
+    buf[n] = '\0';
+    return TRUE;
+}
+
+// Busiest engine of a client since its previous sample, in percent
+static gdouble client_busy_percent(const DrmFdinfo *cur, const DrmClientState *prev,
+                                   gint64 now_us, gchar *engine_out, gsize engine_size) {
+    gdouble best = 0.0;
+    gint64 wall_ns = (now_us - prev->timestamp_us) * 1000;
+    for (guint i = 0; i < cur->n_engines; i++) {
+        const DrmEngineSample *e = &cur->engines[i];
+        const DrmEngineSample *p = NULL;
+        for (guint j = 0; j < prev->n_engines; j++) {
+            if (strcmp(prev->engines[j].name, e->name) == 0) { p = &prev->engines[j]; break; }
+        }
+        if (!p) continue;
+
+        // A counter that went backwards (engine reset, reopened client) only gives a new baseline
+        gdouble pct = 0.0;
+        if (e->total_cycles > 0) {
+            if (e->total_cycles > p->total_cycles && e->cycles >= p->cycles) {
+                pct = 100.0 * (gdouble)(e->cycles - p->cycles) / (gdouble)(e->total_cycles - p->total_cycles);
+            }
+        } else if (wall_ns > 0 && e->busy_ns >= p->busy_ns) {
+            pct = 100.0 * (gdouble)(e->busy_ns - p->busy_ns) / (gdouble)wall_ns / e->capacity;
+        }
+        pct = CLAMP(pct, 0.0, 100.0);
+        if (pct > best) {
+            best = pct;
+            g_strlcpy(engine_out, e->name, engine_size);
+        }
+    }
+    return best;
+}
+
+static GpuProcessUsage* usage_entry(guint pid, const gchar *comm, const gchar *pdev) {
+    // Entries for the current pid are appended contiguously, so only scan the tail
+    for (gint i = (gint)usage_by_gpu->len - 1; i >= 0; i--) {
+        GpuProcessUsage *u = &g_array_index(usage_by_gpu, GpuProcessUsage, i);
+        if (u->pid != pid) break;
+        if (strcmp(u->pdev, pdev) == 0) return u;
+    }
+    GpuProcessUsage fresh = { 0 };
+    fresh.pid = pid;
+    g_strlcpy(fresh.comm, comm, sizeof(fresh.comm));
+    g_strlcpy(fresh.pdev, pdev, sizeof(fresh.pdev));
+    g_array_append_val(usage_by_gpu, fresh);
+    return &g_array_index(usage_by_gpu, GpuProcessUsage, usage_by_gpu->len - 1);
+}
+
+static void drm_process_fds_free(gpointer data) {
+    DrmProcessFds *proc = data;
+    g_array_free(proc->fds, TRUE);
+    g_free(proc);
+}
+
+static guint64 read_starttime(const gchar *root, const gchar *pid_str) {
+    char path[PATH_MAX], buf[1024];
+    snprintf(path, sizeof(path), "%s/%s/stat", root, pid_str);
+    if (!read_small_file(path, buf, sizeof(buf))) return 0;
+    // The comm field may contain spaces; count from the closing parenthesis
+    const char *p = strrchr(buf, ')');
+    for (gint field = 2; p && field < 22; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    return p ? g_ascii_strtoull(p + 1, NULL, 10) : 0;
+}
+
+// Walk /proc/<pid>/fd for DRM device fds; FALSE if the table is not readable
+static gboolean find_drm_fds(const gchar *root, const gchar *pid_str, GArray *fds) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s/fd", root, pid_str);
+    DIR *fd_dir = opendir(path);
+    if (!fd_dir) return FALSE; // other users' processes are not readable
+
+    g_array_set_size(fds, 0);
+    struct dirent *fd_entry;
+    while ((fd_entry = readdir(fd_dir)) != NULL) {
+        if (!isdigit((unsigned char)fd_entry->d_name[0])) continue;
+
+        char target[64];
+        snprintf(path, sizeof(path), "%s/%s/fd/%s", root, pid_str, fd_entry->d_name);
+        ssize_t tlen = readlink(path, target, sizeof(target) - 1);
+        if (tlen <= 0) continue;
+        target[tlen] = '\0';
+        if (strncmp(target, "/dev/dri/", 9) != 0) continue;
+        int fd = atoi(fd_entry->d_name);
+        g_array_append_val(fds, fd);
+    }
+    closedir(fd_dir);
+    return TRUE;
+}
+
+static DrmProcessFds* lookup_process_fds(const gchar *root, const gchar *pid_str, guint pid) {
+    DrmProcessFds *proc = g_hash_table_lookup(process_fds, GUINT_TO_POINTER(pid));
+    gboolean periodic = (update_tick + pid) % FDINFO_RESCAN_SCANS == 0;
+    // Most processes have no DRM fds; they cost nothing until their next walk
+    if (proc && proc->fds->len == 0 && !proc->stale && !periodic) {
+        proc->last_tick = update_tick;
+        return proc;
+    }
+
+    guint64 starttime = read_starttime(root, pid_str);
+    gboolean rescan = proc == NULL || proc->stale || proc->starttime != starttime || periodic;
+    if (!proc) {
+        proc = g_new0(DrmProcessFds, 1);
+        proc->fds = g_array_new(FALSE, FALSE, sizeof(int));
+        g_hash_table_insert(process_fds, GUINT_TO_POINTER(pid), proc);
+    }
+    if (proc->starttime != starttime) proc->comm[0] = '\0';   // another process got the pid
+    proc->starttime = starttime;
+    proc->last_tick = update_tick;
+    if (rescan) {
+        proc->stale = FALSE;
+        if (!find_drm_fds(root, pid_str, proc->fds)) g_array_set_size(proc->fds, 0);
+    }
+    return proc;
+}
+
+static void scan_process(const gchar *root, const gchar *pid_str, gint64 now_us, GHashTable *seen_clients) {
+    guint pid = (guint)atoi(pid_str);
+    DrmProcessFds *proc = lookup_process_fds(root, pid_str, pid);
+
+    char path[PATH_MAX];
+    char buf[4096];
+    for (guint f = 0; f < proc->fds->len; f++) {
+        snprintf(path, sizeof(path), "%s/%s/fdinfo/%d", root, pid_str, g_array_index(proc->fds, int, f));
+        DrmFdinfo info;
+        if (!read_small_file(path, buf, sizeof(buf)) || !gpu_fdinfo_parse(buf, &info)) {
+            // Closed, or the number now belongs to another file
+            proc->stale = TRUE;
+            continue;
+        }
+        if (!info.has_client_id) continue;
+
+        // One client can sit behind several fds (dup, fork); count it once
+        gchar *key = g_strdup_printf("%s/%" G_GUINT64_FORMAT, info.pdev, info.client_id);
+        if (g_hash_table_contains(seen_clients, key)) {
+            g_free(key);
+            continue;
+        }
+        g_hash_table_add(seen_clients, g_strdup(key));
+
+        if (proc->comm[0] == '\0') {
+            snprintf(path, sizeof(path), "%s/%s/comm", root, pid_str);
+            if (read_small_file(path, proc->comm, sizeof(proc->comm))) proc->comm[strcspn(proc->comm, "\n")] = '\0';
+        }
+
+        GpuProcessUsage *u = usage_entry(pid, proc->comm, info.pdev);
+        u->vram_bytes += info.vram_bytes;
+        u->system_bytes += info.system_bytes;
+
+        DrmClientState *state = g_hash_table_lookup(client_states, key);
+        if (state) {
+            gchar engine[24] = "";
+            gdouble busy = client_busy_percent(&info, state, now_us, engine, sizeof(engine));
+            u->busy_percent = MIN(100.0, u->busy_percent + busy);
+            if (busy > 0.0 && engine[0]) g_strlcpy(u->busy_engine, engine, sizeof(u->busy_engine));
+            g_free(key);
+        } else {
+            state = g_new0(DrmClientState, 1);
+            g_hash_table_insert(client_states, key, state);
+        }
+        memcpy(state->engines, info.engines, sizeof(state->engines));
+        state->n_engines = info.n_engines;
+        state->timestamp_us = now_us;
+        state->last_tick = update_tick;
+    }
+}
+
+void gpu_fdinfo_update(void) {
+    gpu_fdinfo_update_at(g_get_monotonic_time());
+}
+
+void gpu_fdinfo_update_at(gint64 now_us) {
+    // Both the GPU tabs and the Apps tab ask for data; share one scan per tick
+    if (last_update_us > 0 && now_us - last_update_us < FDINFO_MIN_INTERVAL_US) return;
+    last_update_us = now_us;
+
+    if (!client_states) {
+        client_states = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        usage_by_gpu = g_array_new(FALSE, FALSE, sizeof(GpuProcessUsage));
+        usage_by_pid = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        process_fds = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, drm_process_fds_free);
+    }
+    update_tick++;
+    g_array_set_size(usage_by_gpu, 0);
+    g_hash_table_remove_all(usage_by_pid);
+
+    const gchar *root = get_proc_root();
+    DIR *dir = opendir(root);
+    if (!dir) return;
+
+    GHashTable *seen_clients = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0])) continue;
+        scan_process(root, entry->d_name, now_us, seen_clients);
+    }
+    closedir(dir);
+    g_hash_table_destroy(seen_clients);
+
+    // Forget clients that were closed and processes that exited since the last scan
+    GHashTableIter it; gpointer key, value;
+    g_hash_table_iter_init(&it, client_states);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        if (((DrmClientState*)value)->last_tick != update_tick) g_hash_table_iter_remove(&it);
+    }
+    g_hash_table_iter_init(&it, process_fds);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        if (((DrmProcessFds*)value)->last_tick != update_tick) g_hash_table_iter_remove(&it);
+    }
+
+    for (guint i = 0; i < usage_by_gpu->len; i++) {
+        const GpuProcessUsage *u = &g_array_index(usage_by_gpu, GpuProcessUsage, i);
+        GpuProcessUsage *total = g_hash_table_lookup(usage_by_pid, GUINT_TO_POINTER(u->pid));
+        if (!total) {
+            total = g_new0(GpuProcessUsage, 1);
+            total->pid = u->pid;
+            g_strlcpy(total->comm, u->comm, sizeof(total->comm));
+            g_hash_table_insert(usage_by_pid, GUINT_TO_POINTER(u->pid), total);
+        }
+        if (u->busy_percent >= total->busy_percent) {
+            total->busy_percent = u->busy_percent;
+            g_strlcpy(total->busy_engine, u->busy_engine, sizeof(total->busy_engine));
+        }
+        total->vram_bytes += u->vram_bytes;
+        total->system_bytes += u->system_bytes;
+    }
+}
+
+void gpu_fdinfo_cleanup(void) {
+    if (client_states) g_hash_table_destroy(client_states);
+    if (usage_by_pid) g_hash_table_destroy(usage_by_pid);
+    if (usage_by_gpu) g_array_free(usage_by_gpu, TRUE);
+    if (process_fds) g_hash_table_destroy(process_fds);
+    process_fds = NULL;
+    client_states = NULL;
+    usage_by_pid = NULL;
+    usage_by_gpu = NULL;
+    g_free(proc_root);
+    proc_root = NULL;
+    last_update_us = 0;
+}
+
+const GpuProcessUsage* gpu_fdinfo_get_process(guint pid) {
+    return usage_by_pid ? g_hash_table_lookup(usage_by_pid, GUINT_TO_POINTER(pid)) : NULL;
+}
+
+static gint compare_usage_desc(gconstpointer a, gconstpointer b) {
+    const GpuProcessUsage *ua = *(const GpuProcessUsage* const*)a;
+    const GpuProcessUsage *ub = *(const GpuProcessUsage* const*)b;
+    if (ua->busy_percent != ub->busy_percent) return ua->busy_percent < ub->busy_percent ? 1 : -1;
+    if (ua->vram_bytes != ub->vram_bytes) return ua->vram_bytes < ub->vram_bytes ? 1 : -1;
+    return (ua->pid > ub->pid) - (ua->pid < ub->pid);
+}
+
+guint gpu_fdinfo_get_top(const gchar *pdev, const GpuProcessUsage **out, guint max_out) {
+    if (!usage_by_gpu || !out || max_out == 0) return 0;
+    gboolean any_gpu = (pdev == NULL || pdev[0] == '\0');
+
+    GPtrArray *matches = g_ptr_array_new();
+    if (any_gpu) {
+        GHashTableIter it; gpointer key, value;
+        g_hash_table_iter_init(&it, usage_by_pid);
+        while (g_hash_table_iter_next(&it, &key, &value)) g_ptr_array_add(matches, value);
+    } else {
+        for (guint i = 0; i < usage_by_gpu->len; i++) {
+            GpuProcessUsage *u = &g_array_index(usage_by_gpu, GpuProcessUsage, i);
+            if (strcmp(u->pdev, pdev) == 0) g_ptr_array_add(matches, u);
+        }
+    }
+    g_ptr_array_sort(matches, compare_usage_desc);
+
+    guint n = MIN(max_out, matches->len);
+    for (guint i = 0; i < n; i++) out[i] = g_ptr_array_index(matches, i);
+    g_ptr_array_free(matches, TRUE);
+    return n;
+}
@@ -11,6 +11,10 @@
 #include "gpu/gpu_data.h"
 #include "ui/ui_gpu.h"
 #include "ui/ui_app.h"
+#include "cgroup/cgroup_data.h"
+#include "ui/ui_cgroup.h"
+#include "pressure/psi_data.h"
+#include "ui/ui_pressure.h"
 #include "ui/ui_about.h"
 #include "utils/icon_cache.h"
 #include "utils/hotkey.h"
@@ -23,6 +27,8 @@ static void on_shutdown(GtkApplication* app, gpointer user_data) {
     disk_data_cleanup();
     network_data_cleanup();
     gpu_data_cleanup();
+    cgroup_data_cleanup();
+    psi_data_cleanup();
 }
 
 static void activate (GtkApplication* app, gpointer user_data) {
@@ -41,10 +47,12 @@ static void activate (GtkApplication* app, gpointer user_data) {
     gtk_notebook_append_page(GTK_NOTEBOOK(performance_notebook), create_disk_tab(), gtk_label_new("Disks"));
     gtk_notebook_append_page(GTK_NOTEBOOK(performance_notebook), create_network_tab(), gtk_label_new("Network"));
     gtk_notebook_append_page(GTK_NOTEBOOK(performance_notebook), create_gpu_tab(), gtk_label_new("GPU"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(performance_notebook), create_pressure_tab(), gtk_label_new("Pressure"));
   
     gtk_notebook_append_page(GTK_NOTEBOOK(main_notebook), performance_notebook, gtk_label_new("Performance"));
 
     gtk_notebook_append_page(GTK_NOTEBOOK(main_notebook), create_apps_tab(), gtk_label_new("Apps"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(main_notebook), create_cgroup_tab(), gtk_label_new("Cgroups"));
     gtk_notebook_append_page(GTK_NOTEBOOK(main_notebook), create_about_tab(), gtk_label_new("About"));
 
     gtk_widget_show_all(window);
@@ -63,6 +71,7 @@ static void activate (GtkApplication* app, gpointer user_data) {
 int main (int argc, char **argv) {
     cpu_data_init();
     memory_data_init();
+    psi_data_init();
 
     GtkApplication *app = gtk_application_new("org.gtk.systemmonitor", G_APPLICATION_DEFAULT_FLAGS);
     g_signal_connect(app, "activate", G_CALLBACK(activate), NULL);
@@ -77,6 +86,8 @@ int main (int argc, char **argv) {
     disk_data_cleanup();
     network_data_cleanup();
     gpu_data_cleanup();
+    cgroup_data_cleanup();
+    psi_data_cleanup();
 
     return status;
 }
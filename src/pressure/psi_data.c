@@ -0,0 +1,217 @@
+#include "pressure/psi_data.h"
+#include <glib-unix.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+G_DEFINE_QUARK(psi-error-quark, psi_error)
+
+static const gchar *const resource_files[PSI_N_RESOURCES] = { "cpu", "memory", "io" };
+static const gchar *const resource_names[PSI_N_RESOURCES] = { "CPU", "Memory", "I/O" };
+
+static int stat_fds[PSI_N_RESOURCES] = { -1, -1, -1 };   // kept open, re-read with pread
+static PsiStats stats[PSI_N_RESOURCES];
+static gdouble some_history[PSI_N_RESOURCES][MAX_POINTS];
+static gdouble full_history[PSI_N_RESOURCES][MAX_POINTS];
+static gint history_index = 0;
+static gint64 last_update_us = 0;
+// Totals as of the last tick; triggers refresh stats[] in between, the percentages must not see that
+static guint64 tick_some_total[PSI_N_RESOURCES];
+static guint64 tick_full_total[PSI_N_RESOURCES];
+
+static int trigger_fds[PSI_N_RESOURCES] = { -1, -1, -1 };
+static guint trigger_sources[PSI_N_RESOURCES];
+static PsiTriggerFunc trigger_func = NULL;
+static gpointer trigger_data = NULL;
+
+// "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+static gboolean parse_psi_line(const char *line, PsiLine *out) {
+    const char *p = strstr(line, "avg10=");
+    if (!p) return FALSE;
+    out->avg10 = g_ascii_strtod(p + 6, NULL);
+    if ((p = strstr(line, "avg60="))) out->avg60 = g_ascii_strtod(p + 6, NULL);
+    if ((p = strstr(line, "avg300="))) out->avg300 = g_ascii_strtod(p + 7, NULL);
+    if ((p = strstr(line, "total="))) out->total = g_ascii_strtoull(p + 6, NULL, 10);
+    return TRUE;
+}
+
+static gboolean read_resource(PsiResource r) {
+    if (stat_fds[r] < 0) return FALSE;
+    char buf[256];
+    ssize_t n = pread(stat_fds[r], buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return FALSE;
+    buf[n] = '\0';
+
+    char *full_line = strstr(buf, "full ");
+    if (full_line) full_line[-1] = '\0';   // split the two lines
+    if (strncmp(buf, "some ", 5) != 0 || !parse_psi_line(buf, &stats[r].some)) return FALSE;
+    // System-wide cpu "full" is always zero, so it is not worth a graph
+    stats[r].has_full = full_line && r != PSI_CPU && parse_psi_line(full_line, &stats[r].full);
+    return TRUE;
+}
+
+void psi_data_init(void) {
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        char path[64];
+        snprintf(path, sizeof(path), PSI_ROOT "/%s", resource_files[r]);
+        stat_fds[r] = open(path, O_RDONLY | O_CLOEXEC);
+        stats[r].available = read_resource(r);
+        tick_some_total[r] = stats[r].some.total;
+        tick_full_total[r] = stats[r].full.total;
+        if (!stats[r].available && stat_fds[r] >= 0) {
+            close(stat_fds[r]);
+            stat_fds[r] = -1;
+        }
+    }
+    last_update_us = g_get_monotonic_time();
+    if (!psi_is_available()) {
+        g_print("PSI not available (kernel without CONFIG_PSI or booted with psi=0)\n");
+    }
+}
+
+void psi_data_update(void) {
+    gint64 now = g_get_monotonic_time();
+    gint64 elapsed = now - last_update_us;
+    last_update_us = now;
+
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        if (!stats[r].available) continue;
+        guint64 prev_some = tick_some_total[r];
+        guint64 prev_full = tick_full_total[r];
+        if (!read_resource(r)) continue;
+        tick_some_total[r] = stats[r].some.total;
+        tick_full_total[r] = stats[r].full.total;
+
+        if (elapsed > 0) {
+            stats[r].some_percent = CLAMP(100.0 * (stats[r].some.total - prev_some) / elapsed, 0.0, 100.0);
+            stats[r].full_percent = stats[r].has_full
+                ? CLAMP(100.0 * (stats[r].full.total - prev_full) / elapsed, 0.0, 100.0) : 0.0;
+        }
+        some_history[r][history_index] = stats[r].some_percent;
+        full_history[r][history_index] = stats[r].full_percent;
+    }
+    history_index = (history_index + 1) % MAX_POINTS;
+}
+
+gboolean psi_is_available(void) {
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        if (stats[r].available) return TRUE;
+    }
+    return FALSE;
+}
+
+const gchar* psi_get_resource_name(PsiResource resource) {
+    return (resource >= 0 && resource < PSI_N_RESOURCES) ? resource_names[resource] : "";
+}
+
+const PsiStats* psi_get_stats(PsiResource resource) {
+    return (resource >= 0 && resource < PSI_N_RESOURCES) ? &stats[resource] : NULL;
+}
+
+const gdouble* psi_get_some_history(PsiResource resource) {
+    return (resource >= 0 && resource < PSI_N_RESOURCES) ? some_history[resource] : NULL;
+}
+
+const gdouble* psi_get_full_history(PsiResource resource) {
+    return (resource >= 0 && resource < PSI_N_RESOURCES) ? full_history[resource] : NULL;
+}
+
+gint psi_get_history_index(void) {
+    return history_index;
+}
+
+/* ----------------------------------------------------------------------------------
+ *  Triggers
+ * --------------------------------------------------------------------------------*/
+
+static gboolean on_trigger(gint fd, GIOCondition condition, gpointer user_data) {
+    PsiResource r = GPOINTER_TO_INT(user_data);
+    if (condition & G_IO_ERR) {
+        // The kernel drops the trigger when the monitored file goes away
+        g_printerr("PSI trigger for %s stopped\n", resource_files[r]);
+        close(trigger_fds[r]);
+        trigger_fds[r] = -1;
+        trigger_sources[r] = 0;
+        return G_SOURCE_REMOVE;
+    }
+    stats[r].trigger_events++;
+    // Refresh the averages only; history keeps one point per tick
+    read_resource(r);
+    if (trigger_func) trigger_func(r, trigger_data);
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean psi_triggers_enable(guint64 stall_us, guint64 window_us,
+                             PsiTriggerFunc func, gpointer user_data, GError **error) {
+    psi_triggers_disable();
+    if (!psi_is_available()) {
+        g_set_error(error, PSI_ERROR, PSI_ERROR_UNSUPPORTED, "Pressure stall information is not available");
+        return FALSE;
+    }
+    trigger_func = func;
+    trigger_data = user_data;
+
+    char trigger[64];
+    snprintf(trigger, sizeof(trigger), "some %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, stall_us, window_us);
+    int first_errno = 0;
+    gboolean armed = FALSE;
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        if (!stats[r].available) continue;
+        char path[64];
+        snprintf(path, sizeof(path), PSI_ROOT "/%s", resource_files[r]);
+        int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        // The trigger lives as long as the fd; the terminating NUL is part of the write
+        if (fd < 0 || write(fd, trigger, strlen(trigger) + 1) < 0) {
+            if (!first_errno) first_errno = errno;
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        trigger_fds[r] = fd;
+        trigger_sources[r] = g_unix_fd_add(fd, G_IO_PRI | G_IO_ERR, on_trigger, GINT_TO_POINTER(r));
+        armed = TRUE;
+    }
+
+    if (!armed) {
+        g_set_error(error, PSI_ERROR,
+                    (first_errno == EPERM || first_errno == EACCES) ? PSI_ERROR_PERMISSION : PSI_ERROR_FAILED,
+                    "Could not register PSI trigger \"%s\": %s", trigger, g_strerror(first_errno));
+        trigger_func = NULL;
+        trigger_data = NULL;
+    }
+    return armed;
+}
+
+void psi_triggers_disable(void) {
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        if (trigger_sources[r]) {
+            g_source_remove(trigger_sources[r]);
+            trigger_sources[r] = 0;
+        }
+        if (trigger_fds[r] >= 0) {
+            close(trigger_fds[r]);
+            trigger_fds[r] = -1;
+        }
+        stats[r].trigger_events = 0;
+    }
+    trigger_func = NULL;
+    trigger_data = NULL;
+}
+
+gboolean psi_triggers_enabled(void) {
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        if (trigger_fds[r] >= 0) return TRUE;
+    }
+    return FALSE;
+}
+
+void psi_data_cleanup(void) {
+    psi_triggers_disable();
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        if (stat_fds[r] >= 0) {
+            close(stat_fds[r]);
+            stat_fds[r] = -1;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#include "ui/cell_renderer_sparkline.h"
+#include "ui/graph_utils.h"
+
+#define SPARKLINE_WIDTH 80
+#define SPARKLINE_HEIGHT 18
+
+struct _KhosCellRendererSparkline {
+    GtkCellRenderer parent_instance;
+    const ProcHistoryRing *ring;
+};
+
+G_DEFINE_TYPE(KhosCellRendererSparkline, khos_cell_renderer_sparkline, GTK_TYPE_CELL_RENDERER)
+
+static void sparkline_get_preferred_width(GtkCellRenderer *cell, GtkWidget *widget,
+                                          gint *minimum, gint *natural) {
+    gint xpad;
+    gtk_cell_renderer_get_padding(cell, &xpad, NULL);
+    if (minimum) *minimum = SPARKLINE_WIDTH + 2 * xpad;
+    if (natural) *natural = SPARKLINE_WIDTH + 2 * xpad;
+}
+
+static void sparkline_get_preferred_height(GtkCellRenderer *cell, GtkWidget *widget,
+                                           gint *minimum, gint *natural) {
+    gint ypad;
+    gtk_cell_renderer_get_padding(cell, NULL, &ypad);
+    if (minimum) *minimum = SPARKLINE_HEIGHT + 2 * ypad;
+    if (natural) *natural = SPARKLINE_HEIGHT + 2 * ypad;
+}
+
+// Trace a ring oldest-to-newest, right-aligned so a young ring grows from the right edge
+static void sparkline_path(cairo_t *cr, const ProcHistoryRing *ring, const gfloat *values,
+                           gdouble x0, gdouble y0, gdouble w, gdouble h, gdouble max_val) {
+    gint start = (ring->head + PROC_HISTORY_POINTS - ring->count) % PROC_HISTORY_POINTS;
+    gdouble step = w / (PROC_HISTORY_POINTS - 1);
+    gdouble x_first = x0 + w - step * (ring->count - 1);
+    for (gint i = 0; i < ring->count; i++) {
+        gfloat v = values[(start + i) % PROC_HISTORY_POINTS];
+        gdouble y = y0 + h - CLAMP(v / max_val, 0.0, 1.0) * h;
+        gdouble x = x_first + step * i;
+        if (i == 0) cairo_move_to(cr, x, y);
+        else cairo_line_to(cr, x, y);
+    }
+}
+
+static void sparkline_render(GtkCellRenderer *cell, cairo_t *cr, GtkWidget *widget,
+                             const GdkRectangle *background_area,
+                             const GdkRectangle *cell_area,
+                             GtkCellRendererState flags) {
+    KhosCellRendererSparkline *self = KHOS_CELL_RENDERER_SPARKLINE(cell);
+    const ProcHistoryRing *ring = self->ring;
+    if (!ring || ring->count < 2) return;
+
+    gint xpad, ypad;
+    gtk_cell_renderer_get_padding(cell, &xpad, &ypad);
+    gdouble x0 = cell_area->x + xpad;
+    gdouble y0 = cell_area->y + ypad;
+    gdouble w = MIN(cell_area->width - 2 * xpad, SPARKLINE_WIDTH);
+    gdouble h = cell_area->height - 2 * ypad;
+    if (w <= 2 || h <= 2) return;
+
+    // Cached on the tree view until its next style-updated, like the graphs
+    GdkRGBA bg, fg, accent;
+    graph_get_theme_colors(widget, &bg, &fg, &accent, NULL);
+
+    // CPU: scaled to the ring's peak plus 20%, at most 100% and with a 1% floor so an idle process stays flat
+    gfloat cpu_max = 1.0f;
+    gfloat mem_max = 0.0f;
+    for (gint i = 0; i < PROC_HISTORY_POINTS; i++) {
+        if (ring->cpu[i] > cpu_max) cpu_max = ring->cpu[i];
+        if (ring->mem[i] > mem_max) mem_max = ring->mem[i];
+    }
+    cpu_max = MIN(100.0f, cpu_max * 1.2f);
+
+    cairo_save(cr);
+    cairo_rectangle(cr, x0, y0, w, h);
+    cairo_clip(cr);
+
+    sparkline_path(cr, ring, ring->cpu, x0, y0, w, h, cpu_max);
+    cairo_set_source_rgba(cr, accent.red, accent.green, accent.blue, 0.9);
+    cairo_set_line_width(cr, 1.2);
+    cairo_stroke_preserve(cr);
+    cairo_line_to(cr, x0 + w, y0 + h);
+    cairo_line_to(cr, x0 + w - (w / (PROC_HISTORY_POINTS - 1)) * (ring->count - 1), y0 + h);
+    cairo_close_path(cr);
+    cairo_set_source_rgba(cr, accent.red, accent.green, accent.blue, 0.25);
+    cairo_fill(cr);
+
+    if (mem_max > 0.0f) {
+        sparkline_path(cr, ring, ring->mem, x0, y0, w, h, mem_max * 1.1);
+        cairo_set_source_rgba(cr, fg.red, fg.green, fg.blue, 0.5);
+        cairo_set_line_width(cr, 0.8);
+        cairo_stroke(cr);
+    }
+
+    cairo_restore(cr);
+}
+
+static void khos_cell_renderer_sparkline_class_init(KhosCellRendererSparklineClass *klass) {
+    GtkCellRendererClass *cell_class = GTK_CELL_RENDERER_CLASS(klass);
+    cell_class->render = sparkline_render;
+    cell_class->get_preferred_width = sparkline_get_preferred_width;
+    cell_class->get_preferred_height = sparkline_get_preferred_height;
+}
+
+static void khos_cell_renderer_sparkline_init(KhosCellRendererSparkline *self) {
+    self->ring = NULL;
+    gtk_cell_renderer_set_padding(GTK_CELL_RENDERER(self), 2, 2);
+}
+
+GtkCellRenderer* khos_cell_renderer_sparkline_new(void) {
+    return g_object_new(KHOS_TYPE_CELL_RENDERER_SPARKLINE, NULL);
+}
+
+void khos_cell_renderer_sparkline_set_ring(KhosCellRendererSparkline *self,
+                                           const ProcHistoryRing *ring) {
+    self->ring = ring;
+}
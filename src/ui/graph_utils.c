@@ -1,28 +1,121 @@
 #include "ui/graph_utils.h"
+#include "cpu/cpu_topology.h"
+#include <stdio.h>
 #include <string.h>
+#include <math.h>
+
+typedef struct CoreLayout CoreLayout;
+typedef struct HeatmapLayout HeatmapLayout;
+
+/* Per-widget cache: theme colors until the next style-updated, the
+ * background + grid layer until the next size-allocate or style change,
+ * and the per-core layouts until the size or the number of CPUs changes */
+typedef struct {
+    gboolean colors_valid;
+    gchar *accent_fallback;
+    GdkRGBA bg;
+    GdkRGBA fg;
+    GdkRGBA accent;
+    cairo_surface_t *layer;
+    int layer_width;
+    int layer_height;
+    // graph_draw_scrolling(): plotted data, (num_points - 1) * plot_step wide
+    cairo_surface_t *plot;
+    int plot_step;
+    int plot_height;
+    int plot_scale;
+    gint plot_points;
+    guint64 plot_count;         // sample_count the plot was last drawn at
+    gdouble plot_key;
+    gboolean plot_edge_dirty;   // newest sample changed in place, see graph_touch_scrolling()
+    CoreLayout *core_layout;
+    HeatmapLayout *heatmap_layout;
+} GraphCache;
+
+static void graph_cache_drop_layer(GraphCache *cache) {
+    if (cache->layer) cairo_surface_destroy(cache->layer);
+    cache->layer = NULL;
+}
+
+static void graph_cache_drop_plot(GraphCache *cache) {
+    if (cache->plot) cairo_surface_destroy(cache->plot);
+    cache->plot = NULL;
+}
+
+static void graph_cache_free(gpointer data) {
+    GraphCache *cache = data;
+    graph_cache_drop_layer(cache);
+    graph_cache_drop_plot(cache);
+    g_free(cache->core_layout);
+    g_free(cache->heatmap_layout);
+    g_free(cache->accent_fallback);
+    g_free(cache);
+}
+
+static void on_graph_style_updated(GtkWidget *widget, gpointer user_data) {
+    GraphCache *cache = user_data;
+    cache->colors_valid = FALSE;
+    graph_cache_drop_layer(cache);
+    graph_cache_drop_plot(cache);
+}
+
+static void on_graph_size_allocate(GtkWidget *widget, GdkRectangle *allocation, gpointer user_data) {
+    GraphCache *cache = user_data;
+    if (allocation->width != cache->layer_width || allocation->height != cache->layer_height) {
+        graph_cache_drop_layer(cache);
+    }
+    graph_cache_drop_plot(cache);
+}
+
+// Samples kept coming while the graph was hidden; the shifted plot is stale
+static void on_graph_map(GtkWidget *widget, gpointer user_data) {
+    graph_cache_drop_plot(user_data);
+}
+
+static GraphCache* graph_cache_get(GtkWidget *widget) {
+    GraphCache *cache = g_object_get_data(G_OBJECT(widget), "graph-cache");
+    if (!cache) {
+        cache = g_new0(GraphCache, 1);
+        g_object_set_data_full(G_OBJECT(widget), "graph-cache", cache, graph_cache_free);
+        g_signal_connect(widget, "style-updated", G_CALLBACK(on_graph_style_updated), cache);
+        g_signal_connect(widget, "size-allocate", G_CALLBACK(on_graph_size_allocate), cache);
+        g_signal_connect(widget, "map", G_CALLBACK(on_graph_map), cache);
+    }
+    return cache;
+}
+
+static void graph_cache_load_colors(GtkWidget *widget, GraphCache *cache) {
+    GtkStyleContext *style = gtk_widget_get_style_context(widget);
+
+    // Defaults
+    gdk_rgba_parse(&cache->bg, "rgb(24, 25, 26)");
+    gdk_rgba_parse(&cache->fg, "rgb(238, 238, 236)");
+    gdk_rgba_parse(&cache->accent, cache->accent_fallback ? cache->accent_fallback : "rgb(53, 132, 228)");
+
+    // Theme overrides
+    gtk_style_context_lookup_color(style, "theme_bg_color", &cache->bg);
+    gtk_style_context_lookup_color(style, "theme_fg_color", &cache->fg);
+    gtk_style_context_lookup_color(style, "theme_selected_bg_color", &cache->accent);
+    cache->colors_valid = TRUE;
+}
 
 void graph_get_theme_colors(GtkWidget *widget,
                             GdkRGBA *bg,
                             GdkRGBA *fg,
                             GdkRGBA *accent,
                             const gchar *accent_fallback) {
-    if (!widget || !bg || !fg || !accent) return;
+    if (!widget || !bg || !fg) return;
 
-    GtkStyleContext *style = gtk_widget_get_style_context(widget);
-
-    // Defaults
-    gdk_rgba_parse(bg, "rgb(24, 25, 26)");
-    gdk_rgba_parse(fg, "rgb(238, 238, 236)");
-    if (accent_fallback) {
-        gdk_rgba_parse(accent, accent_fallback);
-    } else {
-        gdk_rgba_parse(accent, "rgb(53, 132, 228)");
+    GraphCache *cache = graph_cache_get(widget);
+    if (g_strcmp0(cache->accent_fallback, accent_fallback) != 0) {
+        g_free(cache->accent_fallback);
+        cache->accent_fallback = g_strdup(accent_fallback);
+        cache->colors_valid = FALSE;
     }
-
-    // Theme overrides
-    gtk_style_context_lookup_color(style, "theme_bg_color", bg);
-    gtk_style_context_lookup_color(style, "theme_fg_color", fg);
-    gtk_style_context_lookup_color(style, "theme_selected_bg_color", accent);
+    if (!cache->colors_valid) graph_cache_load_colors(widget, cache);
+    *bg = cache->bg;
+    *fg = cache->fg;
+    if (accent) *accent = cache->accent;
 }
 
 void graph_draw_background(cairo_t *cr, int width, int height, GdkRGBA *bg_color) {
@@ -31,6 +124,122 @@ void graph_draw_background(cairo_t *cr, int width, int height, GdkRGBA *bg_color
     cairo_paint(cr);
 }
 
+void graph_draw_background_layer(cairo_t *cr, GtkWidget *widget) {
+    if (!cr || !widget) return;
+    GraphCache *cache = graph_cache_get(widget);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+
+    if (!cache->layer || cache->layer_width != width || cache->layer_height != height) {
+        if (!cache->colors_valid) graph_cache_load_colors(widget, cache);
+        GdkRGBA bg = cache->bg, fg = cache->fg;
+        graph_cache_drop_layer(cache);
+        GdkWindow *window = gtk_widget_get_window(widget);
+        if (!window || width <= 0 || height <= 0) {
+            graph_draw_background(cr, width, height, &bg);
+            graph_draw_grid(cr, width, height, &fg);
+            return;
+        }
+        cache->layer = gdk_window_create_similar_surface(window, CAIRO_CONTENT_COLOR, width, height);
+        cache->layer_width = width;
+        cache->layer_height = height;
+        cairo_t *layer_cr = cairo_create(cache->layer);
+        graph_draw_background(layer_cr, width, height, &bg);
+        graph_draw_grid(layer_cr, width, height, &fg);
+        cairo_destroy(layer_cr);
+    }
+    cairo_set_source_surface(cr, cache->layer, 0, 0);
+    cairo_paint(cr);
+}
+
+/* Scrolling plot: the data is kept in an image surface whose sample
+ * spacing is a whole number of pixels. A new sample shifts the pixels left
+ * by that spacing and only the strip at the right edge is re-plotted, so
+ * the result matches a full redraw while rasterizing a few columns. */
+#define SCROLL_STRIP_MARGIN 4   // covers line width and joins left of the new segments
+
+void graph_invalidate_scrolling(GtkWidget *widget) {
+    if (!widget) return;
+    graph_cache_drop_plot(graph_cache_get(widget));
+    gtk_widget_queue_draw(widget);
+}
+
+void graph_touch_scrolling(GtkWidget *widget) {
+    if (!widget) return;
+    graph_cache_get(widget)->plot_edge_dirty = TRUE;
+}
+
+void graph_draw_scrolling(cairo_t *cr, GtkWidget *widget,
+                          guint64 sample_count, gint num_points, gdouble scale_key,
+                          GraphPlotFunc plot, gpointer user_data) {
+    if (!cr || !widget || !plot || num_points <= 1) return;
+    GraphCache *cache = graph_cache_get(widget);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    if (width <= 0 || height <= 0) return;
+
+    int step = MAX(1, (int)round(width / (double)(num_points - 1)));
+    int plot_width = step * (num_points - 1);
+    int scale = gtk_widget_get_scale_factor(widget);
+    // A monotonic count, unlike a ring index, cannot alias when the widget skipped whole windows
+    guint64 gap = sample_count - cache->plot_count;
+    gboolean stale = sample_count < cache->plot_count || gap >= (guint64)(num_points - 2);
+    gint steps = stale ? num_points : (gint)gap;
+
+    gboolean full = stale || !cache->plot || cache->plot_step != step || cache->plot_height != height ||
+                    cache->plot_scale != scale || cache->plot_points != num_points ||
+                    cache->plot_key != scale_key;
+    if (full) {
+        graph_cache_drop_plot(cache);
+        cache->plot = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, plot_width * scale, height * scale);
+        if (cairo_surface_status(cache->plot) != CAIRO_STATUS_SUCCESS) {
+            graph_cache_drop_plot(cache);
+            return;
+        }
+        cairo_surface_set_device_scale(cache->plot, scale, scale);
+        cache->plot_step = step;
+        cache->plot_height = height;
+        cache->plot_scale = scale;
+        cache->plot_points = num_points;
+        cache->plot_key = scale_key;
+
+        cairo_t *plot_cr = cairo_create(cache->plot);
+        plot(plot_cr, plot_width, height, user_data);
+        cairo_destroy(plot_cr);
+    } else if (steps > 0 || cache->plot_edge_dirty) {
+        if (steps > 0) {
+            cairo_surface_flush(cache->plot);
+            unsigned char *data = cairo_image_surface_get_data(cache->plot);
+            int stride = cairo_image_surface_get_stride(cache->plot);
+            int shift = steps * step * scale * 4;
+            int row_bytes = plot_width * scale * 4;
+            for (int y = 0; y < height * scale; y++) {
+                memmove(data + y * stride, data + y * stride + shift, row_bytes - shift);
+            }
+            cairo_surface_mark_dirty(cache->plot);
+        }
+
+        // Re-plot only the strip that holds new samples; the clip keeps the rest untouched
+        int x0 = MAX(0, plot_width - (steps + 1) * step - SCROLL_STRIP_MARGIN);
+        cairo_t *plot_cr = cairo_create(cache->plot);
+        cairo_rectangle(plot_cr, x0, 0, plot_width - x0, height);
+        cairo_clip(plot_cr);
+        cairo_set_operator(plot_cr, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(plot_cr);
+        cairo_set_operator(plot_cr, CAIRO_OPERATOR_OVER);
+        plot(plot_cr, plot_width, height, user_data);
+        cairo_destroy(plot_cr);
+    }
+    cache->plot_count = sample_count;
+    cache->plot_edge_dirty = FALSE;
+
+    cairo_save(cr);
+    cairo_scale(cr, width / (double)plot_width, 1.0);
+    cairo_set_source_surface(cr, cache->plot, 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+}
+
 void graph_draw_grid(cairo_t *cr, int width, int height, GdkRGBA *fg_color) {
     if (!cr || !fg_color) return;
 
@@ -48,29 +257,97 @@ void graph_draw_grid(cairo_t *cr, int width, int height, GdkRGBA *fg_color) {
     cairo_stroke(cr);
 }
 
+/* Fill gradients only depend on the height and the color, and most frames
+ * draw the same few; keep a handful around instead of rebuilding them */
+#define FILL_PATTERN_CACHE_SIZE 8
+
+typedef struct {
+    cairo_pattern_t *pattern;
+    int height;
+    GdkRGBA color;
+} FillPattern;
+
+static FillPattern fill_patterns[FILL_PATTERN_CACHE_SIZE];
+static gint fill_pattern_next = 0;
+
+static cairo_pattern_t* get_fill_pattern(int height, const GdkRGBA *color) {
+    for (gint i = 0; i < FILL_PATTERN_CACHE_SIZE; i++) {
+        FillPattern *p = &fill_patterns[i];
+        if (p->pattern && p->height == height && gdk_rgba_equal(&p->color, color)) return p->pattern;
+    }
+    FillPattern *p = &fill_patterns[fill_pattern_next];
+    fill_pattern_next = (fill_pattern_next + 1) % FILL_PATTERN_CACHE_SIZE;
+    if (p->pattern) cairo_pattern_destroy(p->pattern);
+    p->pattern = cairo_pattern_create_linear(0, 0, 0, height);
+    cairo_pattern_add_color_stop_rgba(p->pattern, 0, color->red, color->green, color->blue, 0.7);
+    cairo_pattern_add_color_stop_rgba(p->pattern, 1, color->red, color->green, color->blue, 0.1);
+    p->height = height;
+    p->color = *color;
+    return p->pattern;
+}
+
+/* Histories with more samples than the graph has pixel columns are reduced
+ * to one column each before they become path segments: the line keeps the
+ * column's min and max (in the order they happened, so spikes survive), the
+ * fill its max and stacked bands their mean. A path then has at most about
+ * two vertices per column however long the history is. */
+static gint graph_column_count(int width, gint num_points) {
+    return (width > 1 && num_points - 1 > width) ? width : 0;
+}
+
+typedef struct {
+    double x;           // center of the column's samples
+    gdouble first;      // min or max, whichever came first
+    gdouble second;
+    gdouble max;
+    gdouble mean;
+} GraphColumn;
+
+static void graph_reduce_column(const gdouble *history, gint history_idx, gint num_points,
+                                gint columns, gint c, int width, GraphColumn *out) {
+    gint start = (gint)((gint64)c * num_points / columns);
+    gint end = MAX(start + 1, (gint)((gint64)(c + 1) * num_points / columns));
+    gdouble min = G_MAXDOUBLE, max = -G_MAXDOUBLE, sum = 0.0;
+    gint min_at = start, max_at = start;
+    for (gint i = start; i < end; i++) {
+        gdouble v = history[(history_idx + i) % num_points];
+        if (v < min) { min = v; min_at = i; }
+        if (v > max) { max = v; max_at = i; }
+        sum += v;
+    }
+    out->x = (start + end - 1) / 2.0 / (num_points - 1) * width;
+    out->first = min_at <= max_at ? min : max;
+    out->second = min_at <= max_at ? max : min;
+    out->max = max;
+    out->mean = sum / (end - start);
+}
+
 void graph_draw_fill(cairo_t *cr, int width, int height,
                      const gdouble *history, gint history_idx,
                      gint num_points, GdkRGBA *accent_color) {
     if (!cr || !history || !accent_color || num_points <= 1) return;
 
-    cairo_pattern_t *fill = cairo_pattern_create_linear(0, 0, 0, height);
-    cairo_pattern_add_color_stop_rgba(fill, 0,
-                                      accent_color->red, accent_color->green, accent_color->blue, 0.7);
-    cairo_pattern_add_color_stop_rgba(fill, 1,
-                                      accent_color->red, accent_color->green, accent_color->blue, 0.1);
-    cairo_set_source(cr, fill);
+    cairo_set_source(cr, get_fill_pattern(height, accent_color));
 
     cairo_move_to(cr, 0, height);
-    for (int i = 0; i < num_points; i++) {
-        int idx = (history_idx + i) % num_points;
-        double x = (double)i / (num_points - 1) * width;
-        double y = height - (history[idx] / 100.0 * height);
-        cairo_line_to(cr, x, y);
+    gint columns = graph_column_count(width, num_points);
+    if (columns > 0) {
+        for (gint c = 0; c < columns; c++) {
+            GraphColumn col;
+            graph_reduce_column(history, history_idx, num_points, columns, c, width, &col);
+            cairo_line_to(cr, col.x, height - (col.max / 100.0 * height));
+        }
+    } else {
+        for (int i = 0; i < num_points; i++) {
+            int idx = (history_idx + i) % num_points;
+            double x = (double)i / (num_points - 1) * width;
+            double y = height - (history[idx] / 100.0 * height);
+            cairo_line_to(cr, x, y);
+        }
     }
     cairo_line_to(cr, width, height);
     cairo_close_path(cr);
     cairo_fill(cr);
-    cairo_pattern_destroy(fill);
 }
 
 void graph_draw_line(cairo_t *cr, int width, int height,
@@ -81,6 +358,19 @@ void graph_draw_line(cairo_t *cr, int width, int height,
     cairo_set_source_rgba(cr, accent_color->red, accent_color->green, accent_color->blue, 0.9);
     cairo_set_line_width(cr, line_width);
 
+    gint columns = graph_column_count(width, num_points);
+    if (columns > 0) {
+        for (gint c = 0; c < columns; c++) {
+            GraphColumn col;
+            graph_reduce_column(history, history_idx, num_points, columns, c, width, &col);
+            double y = height - (col.first / 100.0 * height);
+            if (c == 0) cairo_move_to(cr, col.x, y);
+            else cairo_line_to(cr, col.x, y);
+            cairo_line_to(cr, col.x, height - (col.second / 100.0 * height));
+        }
+        cairo_stroke(cr);
+        return;
+    }
     for (int i = 0; i < num_points; i++) {
         int idx = (history_idx + i) % num_points;
         double x = (double)i / (num_points - 1) * width;
@@ -91,6 +381,53 @@ void graph_draw_line(cairo_t *cr, int width, int height,
     cairo_stroke(cr);
 }
 
+void graph_draw_stacked(cairo_t *cr, int width, int height,
+                        const gdouble *const *series, const GdkRGBA *colors, gint n_series,
+                        gint history_idx, gint num_points) {
+    if (!cr || !series || !colors || n_series <= 0 || num_points <= 1) return;
+
+    // One point per sample, or per pixel column (the band's mean) for long histories
+    gint columns = graph_column_count(width, num_points);
+    gint n = columns > 0 ? columns : num_points;
+    gdouble *base = g_new0(gdouble, n);
+    gdouble *value = g_new(gdouble, n);
+    double *xs = g_new(double, n);
+    for (gint s = 0; s < n_series; s++) {
+        const gdouble *history = series[s];
+        if (!history) continue;
+        for (gint i = 0; i < n; i++) {
+            if (columns > 0) {
+                GraphColumn col;
+                graph_reduce_column(history, history_idx, num_points, columns, i, width, &col);
+                xs[i] = col.x;
+                value[i] = col.mean;
+            } else {
+                xs[i] = (double)i / (num_points - 1) * width;
+                value[i] = history[(history_idx + i) % num_points];
+            }
+        }
+
+        // Upper edge left to right, then back along the previous band's top
+        for (gint i = 0; i < n; i++) {
+            double top = MIN(100.0, base[i] + MAX(0.0, value[i]));
+            double y = height - (top / 100.0 * height);
+            if (i == 0) cairo_move_to(cr, xs[i], y);
+            else cairo_line_to(cr, xs[i], y);
+        }
+        for (gint i = n - 1; i >= 0; i--) {
+            cairo_line_to(cr, xs[i], height - (base[i] / 100.0 * height));
+        }
+        cairo_close_path(cr);
+        cairo_set_source_rgba(cr, colors[s].red, colors[s].green, colors[s].blue, 0.75);
+        cairo_fill(cr);
+
+        for (gint i = 0; i < n; i++) base[i] = MIN(100.0, base[i] + MAX(0.0, value[i]));
+    }
+    g_free(xs);
+    g_free(value);
+    g_free(base);
+}
+
 void graph_draw(cairo_t *cr, int width, int height,
                 const gdouble *history, gint history_idx, gint num_points,
                 GdkRGBA *bg_color, GdkRGBA *fg_color, GdkRGBA *accent_color,
@@ -103,39 +440,372 @@ void graph_draw(cairo_t *cr, int width, int height,
     graph_draw_line(cr, width, height, history, history_idx, num_points, accent_color, line_width);
 }
 
+/* Per-core layout: CPUs in topology order, one row per physical core with
+ * its SMT siblings side by side (two cores per row without SMT), and a
+ * header strip above each group when there is more than one. */
+#define GROUP_HEADER_HEIGHT 18
+
+struct CoreLayout {
+    int width, height;                      // allocation and CPU count it was computed for
+    gint num_cores;
+    GdkRectangle cells[MAX_CPU_CORES];      // indexed by logical CPU
+    GdkRectangle headers[MAX_NUMA_NODES];   // indexed by group
+    gint n_headers;
+};
+
+static void compute_core_layout(int width, int height, gint num_cores, CoreLayout *layout) {
+    memset(layout, 0, sizeof(*layout));
+    layout->width = width;
+    layout->height = height;
+    layout->num_cores = num_cores;
+    num_cores = CLAMP(num_cores, 0, MAX_CPU_CORES);
+    if (num_cores == 0) return;
+
+    gint topo_count = 0;
+    const CpuTopoEntry *topo = cpu_topology_get_ordered(&topo_count);
+    gboolean use_topo = topo_count == num_cores;
+    gint groups = use_topo ? cpu_topology_get_group_count() : 1;
+    gint per_row = (use_topo && cpu_topology_get_threads_per_core() > 1) || num_cores == 1 ? 1 : 2;
+
+    // Physical cores ("units") per group; siblings are adjacent in topology order
+    gint units_in_group[MAX_NUMA_NODES] = {0};
+    for (gint i = 0; i < num_cores; i++) {
+        if (!use_topo) { units_in_group[0]++; continue; }
+        if (i == 0 || topo[i].group != topo[i - 1].group || topo[i].package != topo[i - 1].package ||
+            topo[i].core != topo[i - 1].core) {
+            units_in_group[topo[i].group]++;
+        }
+    }
+    gint total_rows = 0;
+    for (gint g = 0; g < groups; g++) total_rows += (units_in_group[g] + per_row - 1) / per_row;
+    layout->n_headers = groups > 1 ? groups : 0;
+    int row_height = MAX(1, (height - layout->n_headers * GROUP_HEADER_HEIGHT) / MAX(1, total_rows));
+    int cell_width = width / per_row;
+
+    int y = 0;
+    gint i = 0;
+    for (gint g = 0; g < groups; g++) {
+        if (layout->n_headers > 0) {
+            layout->headers[g] = (GdkRectangle){ 0, y, width, GROUP_HEADER_HEIGHT };
+            y += GROUP_HEADER_HEIGHT;
+        }
+        gint unit = 0;
+        while (i < num_cores && (!use_topo || topo[i].group == g)) {
+            // Siblings of this physical core
+            gint n = 1;
+            while (use_topo && i + n < num_cores && topo[i + n].group == g &&
+                   topo[i + n].package == topo[i].package && topo[i + n].core == topo[i].core) n++;
+
+            int x0 = (unit % per_row) * cell_width;
+            int y0 = y + (unit / per_row) * row_height;
+            for (gint j = 0; j < n; j++) {
+                gint cpu = use_topo ? topo[i + j].cpu : i + j;
+                if (cpu < 0 || cpu >= MAX_CPU_CORES) continue;
+                layout->cells[cpu] = (GdkRectangle){ x0 + j * cell_width / n, y0, cell_width / n, row_height };
+            }
+            i += n;
+            unit++;
+        }
+        y += (units_in_group[g] + per_row - 1) / per_row * row_height;
+    }
+}
+
+/* Heatmap layout for many-core machines: one row per CPU in topology order,
+ * one pixel column per sample, CPU numbers in a gutter on the left. Used
+ * when the mini graphs would be too short to read, or when asked for. */
+#define HEATMAP_GUTTER_WIDTH 30
+#define HEATMAP_MIN_CELL_HEIGHT 28
+
+typedef struct {
+    cairo_surface_t *surface;   // RGB24, num_points x rows
+    gint rows;
+    gint columns;
+    gint last_idx;              // history index the newest column was taken from
+    guint64 last_count;         // sample count at that point, to notice a full wrap
+    GdkRGBA bg;
+    GdkRGBA accent;
+} GraphHeatmap;
+
+struct HeatmapLayout {
+    int alloc_width, alloc_height;  // allocation and CPU count it was computed for
+    gint num_cores;
+    gint row_cpu[MAX_CPU_CORES];    // logical CPU shown in each row
+    gint row_group[MAX_CPU_CORES];  // its topology group, for the separators
+    gint cpu_row[MAX_CPU_CORES];    // -1 for a CPU without a row
+    gint rows;
+    double x, y, width, row_height;
+};
+
+static void compute_heatmap_layout(int width, int height, gint num_cores, HeatmapLayout *layout) {
+    memset(layout, 0, sizeof(*layout));
+    layout->alloc_width = width;
+    layout->alloc_height = height;
+    layout->num_cores = num_cores;
+    for (gint cpu = 0; cpu < MAX_CPU_CORES; cpu++) layout->cpu_row[cpu] = -1;
+
+    // Rows are dense: each distinct CPU id gets the next one, whatever the gaps between ids
+    gint topo_count = 0;
+    const CpuTopoEntry *topo = cpu_topology_get_ordered(&topo_count);
+    gboolean use_topo = topo_count == num_cores;
+    for (gint i = 0; i < CLAMP(num_cores, 0, MAX_CPU_CORES); i++) {
+        gint cpu = use_topo ? topo[i].cpu : i;
+        if (cpu < 0 || cpu >= MAX_CPU_CORES || layout->cpu_row[cpu] >= 0) continue;
+        layout->row_cpu[layout->rows] = cpu;
+        layout->row_group[layout->rows] = use_topo ? topo[i].group : 0;
+        layout->cpu_row[cpu] = layout->rows++;
+    }
+    layout->x = HEATMAP_GUTTER_WIDTH;
+    layout->y = 0;
+    layout->width = MAX(1, width - HEATMAP_GUTTER_WIDTH);
+    layout->row_height = (double)height / MAX(1, layout->rows);
+}
+
+/* The layouts are looked up on every draw and pointer motion; they only
+ * change with the allocation or the number of CPUs */
+static const CoreLayout* graph_cache_core_layout(GtkWidget *widget, gint num_cores) {
+    GraphCache *cache = graph_cache_get(widget);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    CoreLayout *layout = cache->core_layout;
+    if (!layout || layout->width != width || layout->height != height || layout->num_cores != num_cores) {
+        if (!layout) layout = cache->core_layout = g_new(CoreLayout, 1);
+        compute_core_layout(width, height, num_cores, layout);
+    }
+    return layout;
+}
+
+static const HeatmapLayout* graph_cache_heatmap_layout(GtkWidget *widget, gint num_cores) {
+    GraphCache *cache = graph_cache_get(widget);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    HeatmapLayout *layout = cache->heatmap_layout;
+    if (!layout || layout->alloc_width != width || layout->alloc_height != height ||
+        layout->num_cores != num_cores) {
+        if (!layout) layout = cache->heatmap_layout = g_new(HeatmapLayout, 1);
+        compute_heatmap_layout(width, height, num_cores, layout);
+    }
+    return layout;
+}
+
+void graph_per_core_set_heatmap(GtkWidget *widget, gboolean heatmap) {
+    if (!widget) return;
+    g_object_set_data(G_OBJECT(widget), "graph-per-core-heatmap", GINT_TO_POINTER(heatmap));
+    gtk_widget_queue_draw(widget);
+}
+
+gboolean graph_per_core_use_heatmap(GtkWidget *widget, gint num_cores) {
+    if (!widget || num_cores <= 1) return FALSE;
+    if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(widget), "graph-per-core-heatmap"))) return TRUE;
+    const CoreLayout *layout = graph_cache_core_layout(widget, num_cores);
+    gint first = 0;
+    gint topo_count = 0;
+    const CpuTopoEntry *topo = cpu_topology_get_ordered(&topo_count);
+    if (topo_count == num_cores) first = topo[0].cpu;
+    return layout->cells[first].height < HEATMAP_MIN_CELL_HEIGHT;
+}
+
+static void graph_heatmap_free(gpointer data) {
+    GraphHeatmap *heatmap = data;
+    if (heatmap->surface) cairo_surface_destroy(heatmap->surface);
+    g_free(heatmap);
+}
+
+static inline guint32 heatmap_pixel(const GraphHeatmap *heatmap, gdouble value) {
+    double t = CLAMP(value, 0.0, 100.0) / 100.0;
+    guint32 r = (heatmap->bg.red + (heatmap->accent.red - heatmap->bg.red) * t) * 255.0;
+    guint32 g = (heatmap->bg.green + (heatmap->accent.green - heatmap->bg.green) * t) * 255.0;
+    guint32 b = (heatmap->bg.blue + (heatmap->accent.blue - heatmap->bg.blue) * t) * 255.0;
+    return (r << 16) | (g << 8) | b;
+}
+
+static void heatmap_write_column(GraphHeatmap *heatmap, const HeatmapLayout *layout, gint column,
+                                 GraphGetHistoryFunc get_history, gint slot) {
+    unsigned char *data = cairo_image_surface_get_data(heatmap->surface);
+    int stride = cairo_image_surface_get_stride(heatmap->surface);
+    for (gint r = 0; r < heatmap->rows; r++) {
+        const gdouble *history = get_history(layout->row_cpu[r]);
+        gdouble value = history ? history[slot] : 0.0;
+        ((guint32 *)(data + r * stride))[column] = heatmap_pixel(heatmap, value);
+    }
+}
+
+/* Bring the surface up to date with the histories. Normally that is one
+ * scroll and one new column per tick; a resize, a theme change or a gap
+ * longer than the history repaints every column. */
+static void graph_heatmap_sync(GraphHeatmap *heatmap, const HeatmapLayout *layout,
+                               GraphGetHistoryFunc get_history, gint history_idx, guint64 sample_count,
+                               gint num_points, const GdkRGBA *bg, const GdkRGBA *accent) {
+    // The ring index alone cannot tell one step from a full wrap plus one; the count can
+    guint64 gap = sample_count - heatmap->last_count;
+    gboolean rebuild = !heatmap->surface || heatmap->rows != layout->rows || heatmap->columns != num_points ||
+                       !gdk_rgba_equal(&heatmap->bg, bg) || !gdk_rgba_equal(&heatmap->accent, accent) ||
+                       sample_count < heatmap->last_count || gap >= (guint64)num_points;
+
+    if (rebuild) {
+        if (heatmap->surface) cairo_surface_destroy(heatmap->surface);
+        heatmap->rows = layout->rows;
+        heatmap->columns = num_points;
+        heatmap->bg = *bg;
+        heatmap->accent = *accent;
+        heatmap->surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, num_points, MAX(1, heatmap->rows));
+        if (cairo_surface_status(heatmap->surface) != CAIRO_STATUS_SUCCESS) {
+            cairo_surface_destroy(heatmap->surface);
+            heatmap->surface = NULL;
+            return;
+        }
+        cairo_surface_flush(heatmap->surface);
+        for (gint c = 0; c < num_points; c++) {
+            heatmap_write_column(heatmap, layout, c, get_history, (history_idx + c) % num_points);
+        }
+        cairo_surface_mark_dirty(heatmap->surface);
+        heatmap->last_idx = history_idx;
+        heatmap->last_count = sample_count;
+        return;
+    }
+
+    gint steps = (gint)gap;
+    if (steps == 0) return;
+    cairo_surface_flush(heatmap->surface);
+    unsigned char *data = cairo_image_surface_get_data(heatmap->surface);
+    int stride = cairo_image_surface_get_stride(heatmap->surface);
+    for (gint r = 0; r < heatmap->rows; r++) {
+        guint32 *row = (guint32 *)(data + r * stride);
+        memmove(row, row + steps, (num_points - steps) * sizeof(guint32));
+    }
+    for (gint s = 0; s < steps; s++) {
+        heatmap_write_column(heatmap, layout, num_points - steps + s, get_history,
+                             (heatmap->last_idx + s) % num_points);
+    }
+    cairo_surface_mark_dirty(heatmap->surface);
+    heatmap->last_idx = history_idx;
+    heatmap->last_count = sample_count;
+}
+
+void graph_draw_per_core_heatmap(cairo_t *cr, GtkWidget *widget,
+                                 gint num_cores,
+                                 GraphGetHistoryFunc get_history,
+                                 GraphGetHistoryIndexFunc get_history_idx,
+                                 GraphGetSampleCountFunc get_sample_count,
+                                 GdkRGBA *bg_color, GdkRGBA *fg_color, GdkRGBA *accent_color,
+                                 gint num_points) {
+    if (!cr || !widget || num_cores <= 0 || !get_history || !get_history_idx || !get_sample_count ||
+        num_points <= 1) return;
+
+    GraphHeatmap *heatmap = g_object_get_data(G_OBJECT(widget), "graph-heatmap");
+    if (!heatmap) {
+        heatmap = g_new0(GraphHeatmap, 1);
+        g_object_set_data_full(G_OBJECT(widget), "graph-heatmap", heatmap, graph_heatmap_free);
+    }
+    const HeatmapLayout *layout = graph_cache_heatmap_layout(widget, num_cores);
+    graph_heatmap_sync(heatmap, layout, get_history, get_history_idx(), get_sample_count(), num_points,
+                       bg_color, accent_color);
+    if (!heatmap->surface) return;
+
+    // One scaled blit; nearest keeps the rows and samples crisp when enlarged
+    cairo_save(cr);
+    cairo_rectangle(cr, layout->x, layout->y, layout->width, layout->row_height * layout->rows);
+    cairo_clip(cr);
+    cairo_translate(cr, layout->x, layout->y);
+    cairo_scale(cr, layout->width / num_points, layout->row_height);
+    cairo_set_source_surface(cr, heatmap->surface, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), layout->row_height >= 1.0 ? CAIRO_FILTER_NEAREST : CAIRO_FILTER_GOOD);
+    cairo_paint(cr);
+    cairo_restore(cr);
+
+    // Separators between nodes/packages, CPU numbers where they fit
+    cairo_set_source_rgba(cr, fg_color->red, fg_color->green, fg_color->blue, 0.5);
+    cairo_set_line_width(cr, 1.0);
+    for (gint r = 1; r < layout->rows; r++) {
+        if (layout->row_group[r] == layout->row_group[r - 1]) continue;
+        double y = floor(layout->y + r * layout->row_height) + 0.5;
+        cairo_move_to(cr, 0, y);
+        cairo_line_to(cr, layout->x + layout->width, y);
+    }
+    cairo_stroke(cr);
+
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, MIN(10.0, MAX(7.0, layout->row_height - 1)));
+    gint every = MAX(1, (gint)ceil(10.0 / layout->row_height));
+    cairo_set_source_rgba(cr, fg_color->red, fg_color->green, fg_color->blue, 0.8);
+    for (gint r = 0; r < layout->rows; r += every) {
+        gchar label[8];
+        snprintf(label, sizeof(label), "%d", layout->row_cpu[r]);
+        cairo_move_to(cr, 3, layout->y + r * layout->row_height + MIN(layout->row_height, 10.0) - 1);
+        cairo_show_text(cr, label);
+    }
+}
+
+gboolean graph_per_core_cell(GtkWidget *widget, gint num_cores, gint index, GdkRectangle *cell) {
+    if (!widget || index < 0 || index >= num_cores || index >= MAX_CPU_CORES) return FALSE;
+    if (graph_per_core_use_heatmap(widget, num_cores)) {
+        const HeatmapLayout *heat = graph_cache_heatmap_layout(widget, num_cores);
+        gint r = heat->cpu_row[index];
+        if (r < 0) return FALSE;
+        GdkRectangle row = { heat->x, heat->y + r * heat->row_height, heat->width, MAX(1, (int)heat->row_height) };
+        if (cell) *cell = row;
+        return TRUE;
+    }
+    const CoreLayout *layout = graph_cache_core_layout(widget, num_cores);
+    if (cell) *cell = layout->cells[index];
+    return layout->cells[index].width > 0 && layout->cells[index].height > 0;
+}
+
+void graph_draw_per_core_headers(cairo_t *cr, GtkWidget *widget, gint num_cores,
+                                 GraphGetLabelFunc get_group_label, GdkRGBA *fg_color) {
+    if (!cr || !widget || !fg_color) return;
+    // The heatmap draws separators instead
+    if (graph_per_core_use_heatmap(widget, num_cores)) return;
+    const CoreLayout *layout = graph_cache_core_layout(widget, num_cores);
+
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 11);
+    for (gint g = 0; g < layout->n_headers; g++) {
+        const GdkRectangle *h = &layout->headers[g];
+        cairo_set_source_rgba(cr, fg_color->red, fg_color->green, fg_color->blue, 0.08);
+        cairo_rectangle(cr, h->x, h->y, h->width, h->height);
+        cairo_fill(cr);
+
+        gchar label[64];
+        if (get_group_label) get_group_label(g, label, sizeof(label));
+        else cpu_topology_get_group_label(g, label, sizeof(label));
+        cairo_set_source_rgba(cr, fg_color->red, fg_color->green, fg_color->blue, 0.9);
+        cairo_move_to(cr, h->x + 5, h->y + h->height - 5);
+        cairo_show_text(cr, label);
+    }
+}
+
 void graph_draw_per_core_graphs(cairo_t *cr, GtkWidget *widget,
                                 gint num_cores,
                                 GraphGetHistoryFunc get_history,
                                 GraphGetHistoryIndexFunc get_history_idx,
+                                GraphGetSampleCountFunc get_sample_count,
                                 GraphGetLabelFunc get_label,
                                 GdkRGBA *bg_color, GdkRGBA *fg_color, GdkRGBA *accent_color,
                                 gint num_points) {
     if (!cr || !widget || num_cores <= 0 || !get_history || !get_history_idx || !get_label) return;
 
-    int width = gtk_widget_get_allocated_width(widget);
-    int height = gtk_widget_get_allocated_height(widget);
-
-    int rows = (num_cores + 1) / 2;
-    int cols = (num_cores > 1) ? 2 : 1;
-
-    int graph_width = width / cols;
-    int graph_height = height / rows;
+    if (graph_per_core_use_heatmap(widget, num_cores)) {
+        graph_draw_per_core_heatmap(cr, widget, num_cores, get_history, get_history_idx, get_sample_count,
+                                    bg_color, fg_color, accent_color, num_points);
+        return;
+    }
 
-    for (int i = 0; i < num_cores; i++) {
-        int row = i / cols;
-        int col = i % cols;
+    const CoreLayout *layout = graph_cache_core_layout(widget, num_cores);
+    for (int i = 0; i < num_cores && i < MAX_CPU_CORES; i++) {
+        const GdkRectangle *cell = &layout->cells[i];
+        if (cell->width <= 0 || cell->height <= 0) continue;
 
         cairo_save(cr);
-        cairo_translate(cr, col * graph_width, row * graph_height);
+        cairo_translate(cr, cell->x, cell->y);
 
         // Draw grid for each mini graph
-        graph_draw_grid(cr, graph_width, graph_height, fg_color);
+        graph_draw_grid(cr, cell->width, cell->height, fg_color);
 
         const gdouble* history = get_history(i);
         if (history) {
             gint history_idx = get_history_idx();
-            graph_draw_fill(cr, graph_width, graph_height, history, history_idx, num_points, accent_color);
-            graph_draw_line(cr, graph_width, graph_height, history, history_idx, num_points, accent_color, 2.0);
+            graph_draw_fill(cr, cell->width, cell->height, history, history_idx, num_points, accent_color);
+            graph_draw_line(cr, cell->width, cell->height, history, history_idx, num_points, accent_color, 2.0);
         }
 
         // Label
@@ -150,4 +820,22 @@ void graph_draw_per_core_graphs(cairo_t *cr, GtkWidget *widget,
 
         cairo_restore(cr);
     }
-}
\ No newline at end of file
+    graph_draw_per_core_headers(cr, widget, num_cores, NULL, fg_color);
+}
+
+gint graph_per_core_index_at(GtkWidget *widget, gint num_cores, gdouble x, gdouble y) {
+    if (!widget || num_cores <= 0) return -1;
+
+    if (graph_per_core_use_heatmap(widget, num_cores)) {
+        const HeatmapLayout *heat = graph_cache_heatmap_layout(widget, num_cores);
+        gint r = (gint)((y - heat->y) / heat->row_height);
+        return (y >= heat->y && r >= 0 && r < heat->rows) ? heat->row_cpu[r] : -1;
+    }
+
+    const CoreLayout *layout = graph_cache_core_layout(widget, num_cores);
+    for (gint i = 0; i < num_cores && i < MAX_CPU_CORES; i++) {
+        const GdkRectangle *c = &layout->cells[i];
+        if (x >= c->x && x < c->x + c->width && y >= c->y && y < c->y + c->height) return i;
+    }
+    return -1;
+}
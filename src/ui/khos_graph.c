@@ -0,0 +1,451 @@
+#include "ui/khos_graph.h"
+#include <math.h>
+
+#define KHOS_GRAPH_STRIP_MARGIN 6   // graph_draw_scrolling() strip margin plus antialiasing
+
+/* With more samples than pixel columns, each series is kept decimated: one
+ * bucket of bucket_size consecutive samples per column, holding their min
+ * and max. Buckets follow arrival, so a new sample only touches the newest
+ * one and the plot scrolls by a column once it is full. Min/max rather than
+ * LTTB: LTTB picks a bucket's point from its neighbours, so every sample
+ * would move points that are already drawn. */
+typedef struct {
+    gdouble min;
+    gdouble max;
+    gboolean min_first;         // the min came before the max
+} KhosGraphBucket;
+
+typedef struct {
+    GdkRGBA color;
+    gboolean theme_accent;
+    KhosGraphStyle style;
+    gdouble line_width;
+    const gdouble *history;
+    KhosGraphBucket *buckets;   // n_buckets ring, while bucket_size > 1
+} KhosGraphSeries;
+
+/* Monotonic deque of (sample number, value) pairs over the visible window.
+ * The front is the window's max (or min); a push drops every entry it
+ * dominates from the back, so each sample is added and removed once. */
+typedef struct {
+    guint64 seq;
+    gdouble value;
+} KhosGraphSample;
+
+typedef struct {
+    KhosGraphSample *buf;
+    gint capacity;
+    gint head;
+    gint len;
+} KhosGraphDeque;
+
+struct _KhosGraph {
+    GtkDrawingArea parent_instance;
+    gint num_points;
+    GArray *series;             // KhosGraphSeries
+    gdouble value_scale;
+    gboolean autoscale;
+    gdouble fixed_max;
+    gdouble autoscale_floor;
+    gdouble autoscale_headroom;
+    gdouble axis_max;
+    KhosGraphDeque max_deque;
+    KhosGraphDeque min_deque;
+    guint64 seq;                // number of the newest sample fed to the deques
+    gint history_idx;
+    gboolean primed;            // deques hold the current window
+    gdouble *scratch;           // one series in % of the axis, for the graph_draw_* helpers
+    gint bucket_size;           // samples per plotted column; 1 draws every sample
+    gint n_buckets;
+    gint bucket_idx;            // newest bucket, possibly still filling
+    gint bucket_fill;           // samples in the newest bucket
+    guint64 bucket_seq;         // buckets started so far, to count scrolled columns
+    GraphPlotFunc underlay;
+    gpointer underlay_data;
+    KhosGraphOverlayFunc overlay;
+    gpointer overlay_data;
+    gint overlay_dynamic_height;
+};
+
+G_DEFINE_TYPE(KhosGraph, khos_graph, GTK_TYPE_DRAWING_AREA)
+
+static void deque_reserve(KhosGraphDeque *d, gint capacity) {
+    if (d->capacity >= capacity) return;
+    g_free(d->buf);
+    d->buf = g_new(KhosGraphSample, capacity);
+    d->capacity = capacity;
+    d->head = 0;
+    d->len = 0;
+}
+
+static inline KhosGraphSample* deque_at(KhosGraphDeque *d, gint i) {
+    return &d->buf[(d->head + i) % d->capacity];
+}
+
+// @keep_max: TRUE for the max deque, FALSE for the min deque
+static void deque_push(KhosGraphDeque *d, guint64 seq, gdouble value, gboolean keep_max) {
+    while (d->len > 0) {
+        gdouble back = deque_at(d, d->len - 1)->value;
+        if (keep_max ? back > value : back < value) break;
+        d->len--;
+    }
+    *deque_at(d, d->len) = (KhosGraphSample){ seq, value };
+    d->len++;
+}
+
+static void deque_expire(KhosGraphDeque *d, guint64 oldest_seq) {
+    while (d->len > 0 && d->buf[d->head].seq < oldest_seq) {
+        d->head = (d->head + 1) % d->capacity;
+        d->len--;
+    }
+}
+
+// Rounded up to 1, 2 or 5 times a power of ten, so the axis (and a full redraw) changes rarely
+static gdouble nice_ceiling(gdouble value) {
+    if (value <= 0.0) return 1.0;
+    gdouble magnitude = pow(10.0, floor(log10(value)));
+    if (value <= magnitude) return magnitude;
+    if (value <= 2.0 * magnitude) return 2.0 * magnitude;
+    if (value <= 5.0 * magnitude) return 5.0 * magnitude;
+    return 10.0 * magnitude;
+}
+
+static gdouble compute_axis_max(KhosGraph *self) {
+    if (!self->autoscale) return self->fixed_max;
+    gdouble peak = self->max_deque.len > 0 ? self->max_deque.buf[self->max_deque.head].value : 0.0;
+    return nice_ceiling(MAX(self->autoscale_floor, peak * self->autoscale_headroom));
+}
+
+// Zoom level for a plot @width pixels wide
+static gint bucket_size_for_width(KhosGraph *self, int width) {
+    if (width <= 1 || self->num_points - 1 <= width) return 1;
+    return (self->num_points - 1 + width - 1) / width;
+}
+
+static void bucket_add(KhosGraphBucket *bucket, gdouble v, gboolean first) {
+    if (first) {
+        *bucket = (KhosGraphBucket){ v, v, TRUE };
+        return;
+    }
+    if (v < bucket->min) {
+        bucket->min = v;
+        bucket->min_first = FALSE;
+    }
+    if (v > bucket->max) {
+        bucket->max = v;
+        bucket->min_first = TRUE;
+    }
+}
+
+// One sample slot of every series enters the window; the oldest one leaves
+static void feed_slot(KhosGraph *self, gint slot) {
+    gboolean decimate = self->bucket_size > 1;
+    if (decimate && self->bucket_fill == self->bucket_size) {
+        self->bucket_idx = (self->bucket_idx + 1) % self->n_buckets;
+        self->bucket_fill = 0;
+        self->bucket_seq++;
+    }
+
+    self->seq++;
+    if (self->seq >= (guint64)self->num_points) {
+        guint64 oldest = self->seq - self->num_points + 1;
+        deque_expire(&self->max_deque, oldest);
+        deque_expire(&self->min_deque, oldest);
+    }
+    for (guint s = 0; s < self->series->len; s++) {
+        const KhosGraphSeries *series = &g_array_index(self->series, KhosGraphSeries, s);
+        if (!series->history) continue;
+        gdouble v = series->history[slot] * self->value_scale;
+        deque_push(&self->max_deque, self->seq, v, TRUE);
+        deque_push(&self->min_deque, self->seq, v, FALSE);
+        if (decimate) bucket_add(&series->buckets[self->bucket_idx], series->history[slot], self->bucket_fill == 0);
+    }
+    if (decimate) self->bucket_fill++;
+}
+
+static void rebuild_window(KhosGraph *self) {
+    gint capacity = self->num_points * MAX(1, (gint)self->series->len);
+    deque_reserve(&self->max_deque, capacity);
+    deque_reserve(&self->min_deque, capacity);
+    self->max_deque.len = 0;
+    self->min_deque.len = 0;
+
+    // Decimated columns for the current zoom level; the stream below fills them
+    self->n_buckets = (self->num_points + self->bucket_size - 1) / self->bucket_size;
+    self->bucket_idx = self->n_buckets - 1;
+    self->bucket_fill = self->bucket_size;
+    for (guint s = 0; s < self->series->len; s++) {
+        KhosGraphSeries *series = &g_array_index(self->series, KhosGraphSeries, s);
+        g_free(series->buckets);
+        series->buckets = self->bucket_size > 1 ? g_new0(KhosGraphBucket, self->n_buckets) : NULL;
+    }
+    for (gint i = 0; i < self->num_points; i++) {
+        feed_slot(self, (self->history_idx + i) % self->num_points);
+    }
+    self->primed = TRUE;
+}
+
+static void plot_area(cairo_t *cr, int width, int height, const gdouble *values, gint idx, gint count,
+                      const GdkRGBA *color) {
+    cairo_set_source_rgba(cr, color->red, color->green, color->blue, 0.3);
+    cairo_move_to(cr, 0, height);
+    for (gint i = 0; i < count; i++) {
+        cairo_line_to(cr, (double)i / (count - 1) * width, height - values[(idx + i) % count] / 100.0 * height);
+    }
+    cairo_line_to(cr, width, height);
+    cairo_close_path(cr);
+    cairo_fill(cr);
+}
+
+// Decimated series: fills follow each column's max, the line visits its min and max in order
+static void plot_buckets(KhosGraph *self, cairo_t *cr, int width, int height,
+                         const KhosGraphSeries *series, const GdkRGBA *color, gdouble factor) {
+    gint count = self->n_buckets;
+    gint oldest = (self->bucket_idx + 1) % count;
+    if (series->style != KHOS_GRAPH_LINE) {
+        for (gint c = 0; c < count; c++) self->scratch[c] = series->buckets[c].max * factor;
+        if (series->style == KHOS_GRAPH_GRADIENT) {
+            graph_draw_fill(cr, width, height, self->scratch, oldest, count, (GdkRGBA *)color);
+        } else {
+            plot_area(cr, width, height, self->scratch, oldest, count, color);
+        }
+    }
+
+    cairo_set_source_rgba(cr, color->red, color->green, color->blue, 0.9);
+    cairo_set_line_width(cr, series->line_width);
+    for (gint i = 0; i < count; i++) {
+        const KhosGraphBucket *b = &series->buckets[(oldest + i) % count];
+        double x = (double)i / (count - 1) * width;
+        double first = height - (b->min_first ? b->min : b->max) * factor / 100.0 * height;
+        double second = height - (b->min_first ? b->max : b->min) * factor / 100.0 * height;
+        if (i == 0) cairo_move_to(cr, x, first);
+        else cairo_line_to(cr, x, first);
+        cairo_line_to(cr, x, second);
+    }
+    cairo_stroke(cr);
+}
+
+static void khos_graph_plot(cairo_t *cr, int width, int height, gpointer user_data) {
+    KhosGraph *self = user_data;
+    GtkWidget *widget = GTK_WIDGET(self);
+    if (self->underlay) self->underlay(cr, width, height, self->underlay_data);
+
+    GdkRGBA bg, fg, accent;
+    graph_get_theme_colors(widget, &bg, &fg, &accent, NULL);
+    gdouble factor = self->axis_max > 0.0 ? 100.0 * self->value_scale / self->axis_max : 0.0;
+
+    for (guint s = 0; s < self->series->len; s++) {
+        const KhosGraphSeries *series = &g_array_index(self->series, KhosGraphSeries, s);
+        if (!series->history) continue;
+        GdkRGBA color = series->theme_accent ? accent : series->color;
+        if (series->buckets) {
+            plot_buckets(self, cr, width, height, series, &color, factor);
+            continue;
+        }
+
+        // The helpers plot 0-100; rescale into the scratch ring only when the axis differs
+        const gdouble *values = series->history;
+        if (factor != 1.0) {
+            for (gint i = 0; i < self->num_points; i++) self->scratch[i] = series->history[i] * factor;
+            values = self->scratch;
+        }
+
+        if (series->style == KHOS_GRAPH_GRADIENT) {
+            graph_draw_fill(cr, width, height, values, self->history_idx, self->num_points, &color);
+        } else if (series->style == KHOS_GRAPH_AREA) {
+            plot_area(cr, width, height, values, self->history_idx, self->num_points, &color);
+        }
+        graph_draw_line(cr, width, height, values, self->history_idx, self->num_points, &color, series->line_width);
+    }
+}
+
+static gboolean khos_graph_draw(GtkWidget *widget, cairo_t *cr) {
+    KhosGraph *self = KHOS_GRAPH(widget);
+    // A resize may change the zoom level; the size-allocate already dropped the plot
+    gint bucket_size = bucket_size_for_width(self, gtk_widget_get_allocated_width(widget));
+    if (bucket_size != self->bucket_size || !self->primed) {
+        self->bucket_size = bucket_size;
+        rebuild_window(self);
+    }
+
+    graph_draw_background_layer(cr, widget);
+    if (self->bucket_size > 1) {
+        graph_draw_scrolling(cr, widget, self->bucket_seq, self->n_buckets,
+                             self->axis_max, khos_graph_plot, self);
+    } else {
+        graph_draw_scrolling(cr, widget, self->seq, self->num_points, self->axis_max,
+                             khos_graph_plot, self);
+    }
+    if (self->overlay) {
+        self->overlay(self, cr, gtk_widget_get_allocated_width(widget), gtk_widget_get_allocated_height(widget),
+                      self->overlay_data);
+    }
+    return FALSE;
+}
+
+static void khos_graph_finalize(GObject *object) {
+    KhosGraph *self = KHOS_GRAPH(object);
+    for (guint s = 0; s < self->series->len; s++) g_free(g_array_index(self->series, KhosGraphSeries, s).buckets);
+    g_array_free(self->series, TRUE);
+    g_free(self->max_deque.buf);
+    g_free(self->min_deque.buf);
+    g_free(self->scratch);
+    G_OBJECT_CLASS(khos_graph_parent_class)->finalize(object);
+}
+
+static void khos_graph_class_init(KhosGraphClass *klass) {
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+    object_class->finalize = khos_graph_finalize;
+    widget_class->draw = khos_graph_draw;
+}
+
+static void khos_graph_init(KhosGraph *self) {
+    self->series = g_array_new(FALSE, TRUE, sizeof(KhosGraphSeries));
+    self->value_scale = 1.0;
+    self->fixed_max = 100.0;
+    self->axis_max = 100.0;
+    self->autoscale_floor = 1.0;
+    self->autoscale_headroom = 1.0;
+    self->bucket_size = 1;
+}
+
+GtkWidget* khos_graph_new(gint num_points) {
+    KhosGraph *self = g_object_new(KHOS_TYPE_GRAPH, NULL);
+    self->num_points = MAX(2, num_points);
+    self->scratch = g_new0(gdouble, self->num_points);
+    return GTK_WIDGET(self);
+}
+
+gint khos_graph_add_series(KhosGraph *self, const GdkRGBA *color, KhosGraphStyle style, gdouble line_width) {
+    g_return_val_if_fail(KHOS_IS_GRAPH(self), -1);
+    KhosGraphSeries series = {0};
+    if (color) series.color = *color;
+    series.theme_accent = color == NULL;
+    series.style = style;
+    series.line_width = line_width;
+    g_array_append_val(self->series, series);
+    self->primed = FALSE;
+    return self->series->len - 1;
+}
+
+void khos_graph_set_series_history(KhosGraph *self, gint series, const gdouble *history) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    if (series < 0 || series >= (gint)self->series->len) return;
+    KhosGraphSeries *s = &g_array_index(self->series, KhosGraphSeries, series);
+    if (s->history == history) return;
+    s->history = history;
+    khos_graph_reset(self);
+}
+
+void khos_graph_set_value_scale(KhosGraph *self, gdouble factor) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    self->value_scale = factor;
+    khos_graph_reset(self);
+}
+
+void khos_graph_set_fixed_range(KhosGraph *self, gdouble max) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    self->autoscale = FALSE;
+    self->fixed_max = max > 0.0 ? max : 100.0;
+    self->axis_max = self->fixed_max;
+    gtk_widget_queue_draw(GTK_WIDGET(self));
+}
+
+void khos_graph_set_autoscale(KhosGraph *self, gdouble floor, gdouble headroom) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    self->autoscale = TRUE;
+    self->autoscale_floor = floor;
+    self->autoscale_headroom = MAX(1.0, headroom);
+    khos_graph_reset(self);
+}
+
+gdouble khos_graph_get_axis_max(KhosGraph *self) {
+    g_return_val_if_fail(KHOS_IS_GRAPH(self), 0.0);
+    return self->axis_max;
+}
+
+void khos_graph_get_range(KhosGraph *self, gdouble *min, gdouble *max) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    if (!self->primed) rebuild_window(self);
+    if (min) *min = self->min_deque.len > 0 ? self->min_deque.buf[self->min_deque.head].value : 0.0;
+    if (max) *max = self->max_deque.len > 0 ? self->max_deque.buf[self->max_deque.head].value : 0.0;
+}
+
+void khos_graph_set_underlay_func(KhosGraph *self, GraphPlotFunc plot, gpointer user_data) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    self->underlay = plot;
+    self->underlay_data = user_data;
+    graph_invalidate_scrolling(GTK_WIDGET(self));
+}
+
+void khos_graph_set_overlay_func(KhosGraph *self, KhosGraphOverlayFunc func, gpointer user_data,
+                                 gint dynamic_height) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    self->overlay = func;
+    self->overlay_data = user_data;
+    self->overlay_dynamic_height = MAX(0, dynamic_height);
+    gtk_widget_queue_draw(GTK_WIDGET(self));
+}
+
+void khos_graph_push(KhosGraph *self, gint history_idx) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    GtkWidget *widget = GTK_WIDGET(self);
+    gint n = self->num_points;
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    history_idx = ((history_idx % n) + n) % n;
+    gint steps = (history_idx - self->history_idx + n) % n;
+    guint64 bucket_seq = self->bucket_seq;
+
+    gint bucket_size = bucket_size_for_width(self, width);
+    if (!self->primed || bucket_size != self->bucket_size) {
+        self->history_idx = history_idx;
+        self->bucket_size = bucket_size;
+        rebuild_window(self);
+        steps = n;
+    } else {
+        for (gint s = 0; s < steps; s++) feed_slot(self, (self->history_idx + s) % n);
+        self->history_idx = history_idx;
+    }
+
+    // Decimated, the plot only scrolls when a column fills up; until then the newest one changes in place
+    gint columns = n;
+    gint scrolled = steps;
+    if (self->bucket_size > 1 && steps < n) {
+        columns = self->n_buckets;
+        scrolled = (gint)MIN(self->bucket_seq - bucket_seq, (guint64)columns);
+        if (steps > 0) graph_touch_scrolling(widget);
+    }
+
+    gdouble axis_max = compute_axis_max(self);
+    if (axis_max != self->axis_max || scrolled > 0 || width <= 1) {
+        // The whole plot moves left (or rescales), so every pixel changes on screen; the
+        // saving is in graph_draw_scrolling(), which only re-rasterizes the new strip
+        self->axis_max = axis_max;
+        gtk_widget_queue_draw(widget);
+        return;
+    }
+
+    if (steps > 0) {
+        // Decimated and no column completed: only the newest column changed in place
+        int step = MAX(1, (int)round(width / (double)(columns - 1)));
+        int plot_width = step * (columns - 1);
+        int x0 = MAX(0, plot_width - step - KHOS_GRAPH_STRIP_MARGIN);
+        int wx = (int)floor(x0 * (double)width / plot_width);
+        gtk_widget_queue_draw_area(widget, wx, 0, width - wx, height);
+    }
+    if (self->overlay && self->overlay_dynamic_height > 0) {
+        gtk_widget_queue_draw_area(widget, 0, 0, width, MIN(height, self->overlay_dynamic_height));
+    }
+}
+
+void khos_graph_reset(KhosGraph *self) {
+    g_return_if_fail(KHOS_IS_GRAPH(self));
+    self->primed = FALSE;
+    if (self->series->len > 0) {
+        rebuild_window(self);
+        self->axis_max = compute_axis_max(self);
+    }
+    graph_invalidate_scrolling(GTK_WIDGET(self));
+}
@@ -1,5 +1,13 @@
 #include "ui/ui_app.h"
 #include "utils/icon_cache.h"
+#include "utils/proc_history.h"
+#include "ui/cell_renderer_sparkline.h"
+#include "gpu/gpu_fdinfo.h"
+#include "cpu/cpu_data.h"
+#include "utils/app_identity.h"
+#include "utils/proc_control.h"
+#include "utils/user_stats.h"
+#include "memory/memory_data.h"
 #include <gtk/gtk.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <dirent.h>
@@ -15,15 +23,29 @@
 #include <unistd.h>
 #include "config.h"
 
+// Previous value of a cumulative counter; zero is a valid sample, so it has its own flag
+typedef struct {
+    guint64 prev;
+    gboolean sampled;
+} EventCounter;
+
 // Struct to store previous CPU times for a process
 typedef struct {
     gulong prev_utime;
     gulong prev_stime;
+    guint64 prev_io_bytes;  // read_bytes + write_bytes
+    gint64 io_sampled_us;   // scan that took prev_io_bytes, 0 until first sampled
+    EventCounter wait_ns;   // run-queue wait from /proc/<pid>/schedstat
+    EventCounter minflt;    // page faults from stat
+    EventCounter majflt;
+    EventCounter vcsw;      // context switches from status
+    EventCounter nvcsw;
     gboolean seen_this_cycle;
 } ProcessCpuData;
 
 static GHashTable *process_cpu_times_hash = NULL;
 static gulong prev_total_system_jiffies = 0;
+static gint64 prev_scan_time_us = 0;
 
 enum {
   COLUMN_APP_ICON,
@@ -31,11 +53,56 @@ enum {
   COLUMN_APP_PID,
   COLUMN_APP_CPU_STR,
   COLUMN_APP_MEM_STR,
+  COLUMN_APP_IO_STR,
+  COLUMN_APP_GPU_STR,
+  COLUMN_APP_VRAM_STR,
+  COLUMN_APP_RQ_WAIT_STR,
+  COLUMN_APP_MINFLT_STR,
+  COLUMN_APP_MAJFLT_STR,
+  COLUMN_APP_VCSW_STR,
+  COLUMN_APP_NVCSW_STR,
+  COLUMN_APP_GROUP_ID,      // hidden: AppIdentity id, or "uid:<n>" in the user view, on group rows
   N_APP_COLUMNS
 };
 
 static char apps_search_filter[128] = "";
 
+/* Top N mode: keep only the N heaviest processes during the scan */
+#define APPS_TOP_N 40
+
+typedef enum {
+    APPS_TOP_OFF,
+    APPS_TOP_CPU,
+    APPS_TOP_RSS,
+    APPS_TOP_IO
+} AppsTopKey;
+
+static AppsTopKey apps_top_key = APPS_TOP_OFF;
+
+/* What the top-level rows group by */
+typedef enum {
+    APPS_GROUP_APP,
+    APPS_GROUP_USER
+} AppsGroupBy;
+
+static AppsGroupBy apps_group_by = APPS_GROUP_APP;
+
+/* Parsed process that may become a tree row */
+typedef struct {
+    pid_t pid;
+    gchar name[64];
+    const AppIdentity *app;
+    guint uid;
+    gdouble cpu;
+    gulong mem_kb;
+    gdouble io_kbps;        // only measured in Top by I/O and the user view
+    gdouble rq_wait_ms;     // ms spent runnable but not running, per second
+    gdouble minflt_rate;    // per second
+    gdouble majflt_rate;
+    gdouble vcsw_rate;
+    gdouble nvcsw_rate;
+} AppsRow;
+
 
 static gboolean update_apps_list(gpointer user_data);
 // static GtkWidget* create_startup_tab(void); /* disabled */
@@ -72,6 +139,197 @@ static gulong get_total_system_jiffies() {
     return user + nice + system + idle + iowait + irq + softirq + steal;
 }
 
+static gdouble apps_row_key(const AppsRow *row) {
+    switch (apps_top_key) {
+        case APPS_TOP_RSS: return (gdouble)row->mem_kb;
+        case APPS_TOP_IO:  return row->io_kbps;
+        default:           return row->cpu;
+    }
+}
+
+static gint compare_apps_row_desc(gconstpointer a, gconstpointer b) {
+    gdouble ka = apps_row_key(a), kb = apps_row_key(b);
+    return (ka < kb) - (ka > kb);
+}
+
+/* Bounded min-heap: the root is the lightest of the kept rows, so a new row
+ * only has to beat the root to get in. O(log n) per offer. */
+static void top_heap_offer(GArray *heap, const AppsRow *row, guint n) {
+    AppsRow *h = (AppsRow*)heap->data;
+    gdouble key = apps_row_key(row);
+
+    if (heap->len < n) {
+        g_array_append_val(heap, *row);
+        h = (AppsRow*)heap->data;
+        guint i = heap->len - 1;
+        while (i > 0) {
+            guint parent = (i - 1) / 2;
+            if (apps_row_key(&h[parent]) <= key) break;
+            AppsRow tmp = h[parent]; h[parent] = h[i]; h[i] = tmp;
+            i = parent;
+        }
+        return;
+    }
+    if (n == 0 || key <= apps_row_key(&h[0])) return;
+
+    h[0] = *row;
+    guint i = 0;
+    for (;;) {
+        guint l = 2 * i + 1, r = l + 1, smallest = i;
+        if (l < heap->len && apps_row_key(&h[l]) < apps_row_key(&h[smallest])) smallest = l;
+        if (r < heap->len && apps_row_key(&h[r]) < apps_row_key(&h[smallest])) smallest = r;
+        if (smallest == i) break;
+        AppsRow tmp = h[smallest]; h[smallest] = h[i]; h[i] = tmp;
+        i = smallest;
+    }
+}
+
+/* Disk I/O rate from /proc/<pid>/io; only readable for our own processes
+ * unless running privileged. The file is only read while a view shows I/O,
+ * so a rate needs the previous sample to come from the previous scan. */
+static gdouble get_process_io_kbps(pid_t pid, gint64 scan_us, gint64 prev_scan_us) {
+    ProcessCpuData *data = process_cpu_times_hash ? g_hash_table_lookup(process_cpu_times_hash, GINT_TO_POINTER(pid)) : NULL;
+    if (!data) return 0.0;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/io", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0.0;
+    char line[128];
+    guint64 bytes = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "read_bytes:", 11) == 0) bytes += g_ascii_strtoull(line + 11, NULL, 10);
+        else if (strncmp(line, "write_bytes:", 12) == 0) bytes += g_ascii_strtoull(line + 12, NULL, 10);
+    }
+    fclose(fp);
+
+    gdouble kbps = 0.0;
+    if (prev_scan_us > 0 && data->io_sampled_us == prev_scan_us && bytes >= data->prev_io_bytes && scan_us > prev_scan_us)
+        kbps = (bytes - data->prev_io_bytes) / 1024.0 / ((scan_us - prev_scan_us) / (gdouble)G_USEC_PER_SEC);
+    data->prev_io_bytes = bytes;
+    data->io_sampled_us = scan_us;
+    return kbps;
+}
+
+// Per-second increase of a counter since the previous scan; 0 for the first sample
+static inline gdouble counter_rate(EventCounter *counter, guint64 now, gdouble elapsed_s) {
+    gdouble rate = (counter->sampled && now >= counter->prev && elapsed_s > 0)
+        ? (now - counter->prev) / elapsed_s : 0.0;
+    counter->prev = now;
+    counter->sampled = TRUE;
+    return rate;
+}
+
+/* Run-queue wait from /proc/<pid>/schedstat: "<run ns> <wait ns> <timeslices>" */
+static gdouble get_process_rq_wait_ms(pid_t pid, gdouble elapsed_s) {
+    ProcessCpuData *data = process_cpu_times_hash ? g_hash_table_lookup(process_cpu_times_hash, GINT_TO_POINTER(pid)) : NULL;
+    if (!data) return 0.0;
+
+    char path[64], buf[96];
+    snprintf(path, sizeof(path), "/proc/%d/schedstat", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0.0;
+    guint64 run_ns = 0, wait_ns = 0;
+    gboolean ok = fgets(buf, sizeof(buf), fp) &&
+                  sscanf(buf, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, &run_ns, &wait_ns) == 2;
+    fclose(fp);
+    if (!ok) return 0.0;
+
+    return counter_rate(&data->wait_ns, wait_ns, elapsed_s) / 1e6;
+}
+
+/* Sample kept per process during one scan so that sparkline rings can be
+ * handed out once the top N is known. */
+typedef struct {
+    guint pid;
+    gfloat cpu;
+    gfloat mem_mb;
+} ProcessSample;
+
+static gint compare_float_desc(gconstpointer a, gconstpointer b) {
+    gfloat fa = *(const gfloat*)a, fb = *(const gfloat*)b;
+    return (fa < fb) - (fa > fb);
+}
+
+/* Collect the PIDs of rows currently scrolled into view */
+static void collect_visible_pids(GtkTreeView *tree_view, GHashTable *visible) {
+    GtkTreePath *start = NULL, *end = NULL;
+    if (!gtk_tree_view_get_visible_range(tree_view, &start, &end)) return;
+
+    GtkTreeModel *model = gtk_tree_view_get_model(tree_view);
+    GtkTreeIter iter;
+    GtkTreePath *path = gtk_tree_path_copy(start);
+    while (gtk_tree_path_compare(path, end) <= 0 && gtk_tree_model_get_iter(model, &iter, path)) {
+        guint pid = 0;
+        gtk_tree_model_get(model, &iter, COLUMN_APP_PID, &pid, -1);
+        if (pid > 0) g_hash_table_add(visible, GUINT_TO_POINTER(pid));
+
+        // Depth-first walk over rows that are actually shown
+        if (gtk_tree_model_iter_has_child(model, &iter) && gtk_tree_view_row_expanded(tree_view, path)) {
+            gtk_tree_path_down(path);
+            continue;
+        }
+        gtk_tree_path_next(path);
+        while (!gtk_tree_model_get_iter(model, &iter, path) && gtk_tree_path_get_depth(path) > 1) {
+            gtk_tree_path_up(path);
+            gtk_tree_path_next(path);
+        }
+    }
+    gtk_tree_path_free(path);
+    gtk_tree_path_free(start);
+    gtk_tree_path_free(end);
+}
+
+/* Feed the sparkline pool: processes that are on screen or in the top N by CPU
+ * get a ring; processes that already have one keep being sampled until the
+ * pool expires it. */
+static void update_process_history(GArray *samples, GHashTable *visible) {
+    gfloat top_threshold = G_MAXFLOAT;
+    if (samples->len > 0) {
+        GArray *cpus = g_array_sized_new(FALSE, FALSE, sizeof(gfloat), samples->len);
+        for (guint i = 0; i < samples->len; i++) {
+            g_array_append_val(cpus, g_array_index(samples, ProcessSample, i).cpu);
+        }
+        g_array_sort(cpus, compare_float_desc);
+        guint nth = MIN(cpus->len, PROC_HISTORY_TOP_N) - 1;
+        top_threshold = g_array_index(cpus, gfloat, nth);
+        g_array_free(cpus, TRUE);
+    }
+
+    proc_history_begin_cycle();
+    for (guint i = 0; i < samples->len; i++) {
+        ProcessSample *s = &g_array_index(samples, ProcessSample, i);
+        gboolean wanted = g_hash_table_contains(visible, GUINT_TO_POINTER(s->pid)) ||
+                          (s->cpu > 0.0f && s->cpu >= top_threshold);
+        ProcHistoryRing *ring = wanted ? proc_history_acquire(s->pid) : proc_history_lookup(s->pid);
+        proc_history_push(ring, s->cpu, s->mem_mb);
+    }
+    proc_history_end_cycle();
+}
+
+static void sparkline_cell_data_func(GtkTreeViewColumn *tree_column,
+                                     GtkCellRenderer   *cell,
+                                     GtkTreeModel      *tree_model,
+                                     GtkTreeIter       *iter,
+                                     gpointer           data) {
+    guint pid_val = 0;
+    gtk_tree_model_get(tree_model, iter, COLUMN_APP_PID, &pid_val, -1);
+    const ProcHistoryRing *ring = NULL;
+    if (pid_val > 0) {
+        ring = proc_history_lookup(pid_val);
+    } else if (apps_group_by == APPS_GROUP_USER) {
+        // User rows draw the per-user history
+        gchar *group_id = NULL;
+        gtk_tree_model_get(tree_model, iter, COLUMN_APP_GROUP_ID, &group_id, -1);
+        if (group_id && g_str_has_prefix(group_id, "uid:")) {
+            const UserStats *user = user_stats_get((guint)g_ascii_strtoull(group_id + 4, NULL, 10));
+            if (user) ring = &user->history;
+        }
+        g_free(group_id);
+    }
+    khos_cell_renderer_sparkline_set_ring(KHOS_CELL_RENDERER_SPARKLINE(cell), ring);
+}
+
 static void mark_process_unseen(gpointer key, gpointer value, gpointer user_data) {
     ((ProcessCpuData*)value)->seen_this_cycle = FALSE;
 }
@@ -119,11 +377,17 @@ static void collect_pids(GtkTreeModel *model, GtkTreeIter *iter, GArray *pids) {
     }
 }
 
+// A user row spans unrelated processes (this monitor included), so actions only batch over app groups
+static gboolean is_user_row(GtkTreeModel *model, GtkTreeIter *iter) {
+    return apps_group_by == APPS_GROUP_USER && gtk_tree_model_iter_has_child(model, iter);
+}
+
 static GArray* get_selected_pids(GtkTreeView *tree_view) {
     GtkTreeSelection *selection = gtk_tree_view_get_selection(tree_view);
     GtkTreeModel *model;
     GtkTreeIter iter;
     if (!gtk_tree_selection_get_selected(selection, &model, &iter)) return NULL;
+    if (is_user_row(model, &iter)) return NULL;
     GArray *pids = g_array_new(FALSE, FALSE, sizeof(guint));
     collect_pids(model, &iter, pids);
     return pids;
@@ -170,7 +434,182 @@ static void on_kill_activate(GtkMenuItem *item, gpointer user_data) {
     g_array_free(pids, TRUE);
 }
 
+static void show_action_error(GtkTreeView *tree_view, const gchar *what, GError *err) {
+    GtkWidget *parent_window = gtk_widget_get_toplevel(GTK_WIDGET(tree_view));
+    GtkWidget *err_dialog = gtk_message_dialog_new(GTK_WINDOW(parent_window),
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   GTK_MESSAGE_ERROR,
+                                                   GTK_BUTTONS_CLOSE,
+                                                   "%s: %s", what, err->message);
+    if (g_error_matches(err, PROC_CONTROL_ERROR, PROC_CONTROL_ERROR_PERMISSION)) {
+        gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(err_dialog),
+                                                 "Raising priority or changing another user's processes needs elevated privileges.");
+    }
+    gtk_dialog_run(GTK_DIALOG(err_dialog));
+    gtk_widget_destroy(err_dialog);
+    g_error_free(err);
+}
+
+// Value attached to priority menu items
+#define ACTION_VALUE_KEY "khos-action-value"
 
+static void on_renice_activate(GtkMenuItem *item, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    GArray *pids = get_selected_pids(tree_view);
+    if (!pids) return;
+    GError *err = NULL;
+    gint nice_value = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(item), ACTION_VALUE_KEY));
+    if (!proc_control_renice(pids, nice_value, &err)) show_action_error(tree_view, "Failed to change priority", err);
+    g_array_free(pids, TRUE);
+}
+
+static void on_ionice_activate(GtkMenuItem *item, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    GArray *pids = get_selected_pids(tree_view);
+    if (!pids) return;
+    GError *err = NULL;
+    gint level = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(item), ACTION_VALUE_KEY));
+    ProcControlIoClass io_class = level < 0 ? PROC_CONTROL_IOPRIO_IDLE : PROC_CONTROL_IOPRIO_BEST_EFFORT;
+    if (!proc_control_ionice(pids, io_class, MAX(level, 0), &err)) show_action_error(tree_view, "Failed to change I/O priority", err);
+    g_array_free(pids, TRUE);
+}
+
+static void on_affinity_activate(GtkMenuItem *item, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    GtkWidget *parent_window = gtk_widget_get_toplevel(GTK_WIDGET(tree_view));
+    GArray *pids = get_selected_pids(tree_view);
+    if (!pids) return;
+
+    gint num_cpus = MAX(1, get_cpu_threads());
+    GtkWidget *dialog = gtk_dialog_new_with_buttons("Set CPU Affinity",
+                                                   GTK_WINDOW(parent_window),
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   "Apply", GTK_RESPONSE_OK,
+                                                   "Cancel", GTK_RESPONSE_CANCEL,
+                                                   NULL);
+    GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    gtk_container_add(GTK_CONTAINER(content), gtk_label_new("Allow the selected process(es) to run on:"));
+    GtkWidget *grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(grid), 10);
+    GtkWidget **checks = g_new(GtkWidget*, num_cpus);
+    for (gint i = 0; i < num_cpus; i++) {
+        gchar label[16];
+        snprintf(label, sizeof(label), "CPU %d", i);
+        checks[i] = gtk_check_button_new_with_label(label);
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(checks[i]), TRUE);
+        gtk_grid_attach(GTK_GRID(grid), checks[i], i % 4, i / 4, 1, 1);
+    }
+    gtk_container_add(GTK_CONTAINER(content), grid);
+    gtk_widget_show_all(dialog);
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK) {
+        guint8 *cpus = g_new0(guint8, num_cpus);
+        for (gint i = 0; i < num_cpus; i++) cpus[i] = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(checks[i]));
+        GError *err = NULL;
+        if (!proc_control_set_affinity(pids, cpus, num_cpus, &err)) show_action_error(tree_view, "Failed to set CPU affinity", err);
+        g_free(cpus);
+    }
+    gtk_widget_destroy(dialog);
+    g_free(checks);
+    g_array_free(pids, TRUE);
+}
+
+// cgroup actions finish once systemd has set up a scope; the error dialog comes from here
+typedef struct {
+    GtkTreeView *tree_view;
+    const gchar *what;
+} CgroupActionContext;
+
+static gpointer cgroup_action_context(GtkTreeView *tree_view, const gchar *what) {
+    CgroupActionContext *ctx = g_new(CgroupActionContext, 1);
+    ctx->tree_view = g_object_ref(tree_view);
+    ctx->what = what;
+    return ctx;
+}
+
+static void on_cgroup_action_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    CgroupActionContext *ctx = user_data;
+    GError *err = NULL;
+    if (!proc_control_cgroup_finish(result, &err)) show_action_error(ctx->tree_view, ctx->what, err);
+    g_object_unref(ctx->tree_view);
+    g_free(ctx);
+}
+
+static void on_freeze_activate(GtkMenuItem *item, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    GArray *pids = get_selected_pids(tree_view);
+    if (!pids) return;
+    gboolean frozen = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(item), ACTION_VALUE_KEY));
+    proc_control_freeze_async(pids, frozen, on_cgroup_action_done,
+                              cgroup_action_context(tree_view, frozen ? "Failed to freeze" : "Failed to thaw"));
+    g_array_free(pids, TRUE);
+}
+
+/* Ask for a limit with a spin button; returns -1 on cancel */
+static gint run_limit_dialog(GtkTreeView *tree_view, const gchar *title, const gchar *message, gint max, gint step) {
+    GtkWidget *parent_window = gtk_widget_get_toplevel(GTK_WIDGET(tree_view));
+    GtkWidget *dialog = gtk_dialog_new_with_buttons(title,
+                                                   GTK_WINDOW(parent_window),
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   "Apply", GTK_RESPONSE_OK,
+                                                   "Cancel", GTK_RESPONSE_CANCEL,
+                                                   NULL);
+    GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    gtk_container_add(GTK_CONTAINER(content), gtk_label_new(message));
+    GtkWidget *spin = gtk_spin_button_new_with_range(0, max, step);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(spin), 0);
+    gtk_entry_set_activates_default(GTK_ENTRY(spin), TRUE);
+    gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_OK);
+    gtk_container_add(GTK_CONTAINER(content), spin);
+    gtk_widget_show_all(dialog);
+
+    gint value = -1;
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK) {
+        value = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(spin));
+    }
+    gtk_widget_destroy(dialog);
+    return value;
+}
+
+static void on_limit_cpu_activate(GtkMenuItem *item, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    gint percent = run_limit_dialog(tree_view, "Limit CPU",
+                                    "CPU limit in % of one CPU (0 removes the limit):",
+                                    100 * MAX(1, get_cpu_threads()), 5);
+    if (percent < 0) return;
+    GArray *pids = get_selected_pids(tree_view);
+    if (!pids) return;
+    proc_control_set_cpu_max_async(pids, percent, on_cgroup_action_done,
+                                   cgroup_action_context(tree_view, "Failed to limit CPU"));
+    g_array_free(pids, TRUE);
+}
+
+static void on_limit_memory_activate(GtkMenuItem *item, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    gint total_mb = (gint)MIN(get_total_memory(), (gulong)G_MAXINT);
+    gint mb = run_limit_dialog(tree_view, "Limit Memory",
+                               "Memory limit in MB (0 removes the limit):",
+                               total_mb > 0 ? total_mb : G_MAXINT, 64);
+    if (mb < 0) return;
+    GArray *pids = get_selected_pids(tree_view);
+    if (!pids) return;
+    proc_control_set_memory_high_async(pids, (guint64)mb * 1024 * 1024, on_cgroup_action_done,
+                                       cgroup_action_context(tree_view, "Failed to limit memory"));
+    g_array_free(pids, TRUE);
+}
+
+static void append_value_item(GtkWidget *menu, const gchar *label, gint value, GCallback callback, gpointer tree_view) {
+    GtkWidget *item = gtk_menu_item_new_with_label(label);
+    g_object_set_data(G_OBJECT(item), ACTION_VALUE_KEY, GINT_TO_POINTER(value));
+    g_signal_connect(item, "activate", callback, tree_view);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+}
+
+static void append_submenu(GtkWidget *menu, const gchar *label, GtkWidget *submenu) {
+    GtkWidget *item = gtk_menu_item_new_with_label(label);
+    gtk_menu_item_set_submenu(GTK_MENU_ITEM(item), submenu);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+}
 
 static gboolean on_apps_tree_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
     if (event->type == GDK_BUTTON_PRESS && event->button == 3) { // Right-click
@@ -180,6 +619,15 @@ static gboolean on_apps_tree_button_press(GtkWidget *widget, GdkEventButton *eve
             GtkTreeSelection *selection = gtk_tree_view_get_selection(tree_view);
             gtk_tree_selection_unselect_all(selection);
             gtk_tree_selection_select_path(selection, path);
+
+            // Every item is a process action; none of them applies to a whole user
+            GtkTreeModel *model = gtk_tree_view_get_model(tree_view);
+            GtkTreeIter iter;
+            gboolean actionable = !(gtk_tree_model_get_iter(model, &iter, path) && is_user_row(model, &iter));
+            GList *items = gtk_container_get_children(GTK_CONTAINER(user_data));
+            for (GList *l = items; l; l = l->next) gtk_widget_set_sensitive(GTK_WIDGET(l->data), actionable);
+            g_list_free(items);
+
             gtk_menu_popup_at_pointer(GTK_MENU(user_data), (GdkEvent*)event);
             gtk_tree_path_free(path);
             return TRUE; // Event handled
@@ -212,7 +660,8 @@ static gint sort_by_pid(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, gpo
     return 0;
 }
 
-static gulong get_process_memory_kb(pid_t pid) {
+/* VmRSS, the real uid and the context-switch counters at the end of /proc/<pid>/status */
+static gulong get_process_status(pid_t pid, guint *uid, gulong *vcsw, gulong *nvcsw) {
     char path[64];
     snprintf(path, sizeof(path), "/proc/%d/status", pid);
     FILE *fp = fopen(path,"r");
@@ -220,8 +669,14 @@ static gulong get_process_memory_kb(pid_t pid) {
     char line[256];
     gulong kb=0;
     while (fgets(line,sizeof(line),fp)) {
-        if (strncmp(line,"VmRSS:",6)==0) {
+        if (strncmp(line,"Uid:",4)==0) {
+            sscanf(line+4, "%u", uid);
+        } else if (strncmp(line,"VmRSS:",6)==0) {
             sscanf(line+6, "%lu", &kb);
+        } else if (strncmp(line,"voluntary_ctxt_switches:",24)==0) {
+            sscanf(line+24, "%lu", vcsw);
+        } else if (strncmp(line,"nonvoluntary_ctxt_switches:",27)==0) {
+            sscanf(line+27, "%lu", nvcsw);
             break;
         }
     }
@@ -229,6 +684,17 @@ static gulong get_process_memory_kb(pid_t pid) {
     return kb;
 }
 
+/* Fault and context-switch rates since the previous scan */
+static void update_process_event_rates(pid_t pid, gulong minflt, gulong majflt, gulong vcsw, gulong nvcsw,
+                                       gdouble elapsed_s, AppsRow *row) {
+    ProcessCpuData *data = process_cpu_times_hash ? g_hash_table_lookup(process_cpu_times_hash, GINT_TO_POINTER(pid)) : NULL;
+    if (!data) return;
+    row->minflt_rate = counter_rate(&data->minflt, minflt, elapsed_s);
+    row->majflt_rate = counter_rate(&data->majflt, majflt, elapsed_s);
+    row->vcsw_rate = counter_rate(&data->vcsw, vcsw, elapsed_s);
+    row->nvcsw_rate = counter_rate(&data->nvcsw, nvcsw, elapsed_s);
+}
+
 static gint sort_by_cpu_str(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, gpointer user_data) {
     gchar *str_a=NULL,*str_b=NULL;
     gtk_tree_model_get(model,a,COLUMN_APP_CPU_STR,&str_a,-1);
@@ -249,6 +715,18 @@ static gint sort_by_mem_str(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
     return (va<vb)?-1:(va>vb);
 }
 
+/* Numeric sort for the string columns added after CPU/Mem; column id comes via user_data */
+static gint sort_by_numeric_str(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, gpointer user_data) {
+    gint column = GPOINTER_TO_INT(user_data);
+    gchar *str_a=NULL,*str_b=NULL;
+    gtk_tree_model_get(model,a,column,&str_a,-1);
+    gtk_tree_model_get(model,b,column,&str_b,-1);
+    gdouble va = str_a ? g_ascii_strtod(str_a,NULL) : 0.0;
+    gdouble vb = str_b ? g_ascii_strtod(str_b,NULL) : 0.0;
+    g_free(str_a); g_free(str_b);
+    return (va<vb)?-1:(va>vb);
+}
+
 /* ----------------------------------------------------------------------------------
  *  Update the GtkTreeStore for the "Apps" tab
  * --------------------------------------------------------------------------------*/
@@ -277,12 +755,17 @@ static gboolean update_apps_list(gpointer user_data) {
     GtkTreeStore *tree_store = GTK_TREE_STORE(gtk_tree_view_get_model(tree_view));
 
     gulong current_total_system_jiffies = get_total_system_jiffies();
+    gpu_fdinfo_update();
     gulong system_jiffies_delta = (prev_total_system_jiffies > 0 && current_total_system_jiffies > prev_total_system_jiffies) 
                                   ? current_total_system_jiffies - prev_total_system_jiffies : 0;
 
     if (process_cpu_times_hash) {
         g_hash_table_foreach(process_cpu_times_hash, mark_process_unseen, NULL);
     }
+    gint num_cpus = MAX(1, get_cpu_threads());
+    cpu_core_attribution_begin();
+    app_identity_begin_cycle();
+    user_stats_begin_cycle();
 
     /* ---------------------------------------------------------------------
      *  Preserve expand/collapse state + selection of rows
@@ -298,7 +781,7 @@ static gboolean update_apps_list(gpointer user_data) {
             GtkTreePath *path_exp = gtk_tree_model_get_path(old_model, &top_iter);
             if (gtk_tree_view_row_expanded(tree_view, path_exp)) {
                 gchar *app_tmp = NULL;
-                gtk_tree_model_get(old_model, &top_iter, COLUMN_APP_NAME, &app_tmp, -1);
+                gtk_tree_model_get(old_model, &top_iter, COLUMN_APP_GROUP_ID, &app_tmp, -1);
                 if (app_tmp) {
                     g_hash_table_add(expanded_apps, g_strdup(app_tmp));
                 }
@@ -318,13 +801,24 @@ static gboolean update_apps_list(gpointer user_data) {
     if (had_selection) {
         gtk_tree_model_get(GTK_TREE_MODEL(tree_store), &sel_iter,
                            COLUMN_APP_PID, &saved_pid,
-                           COLUMN_APP_NAME, &saved_app,
+                           COLUMN_APP_GROUP_ID, &saved_app,
                            -1);
         if (saved_pid == 0 && saved_app) {
             saved_is_parent = TRUE;
         }
     }
 
+    /* Rows on screen keep their sparkline rings alive */
+    GHashTable *visible_pids = g_hash_table_new(g_direct_hash, g_direct_equal);
+    collect_visible_pids(tree_view, visible_pids);
+    GArray *samples = g_array_new(FALSE, FALSE, sizeof(ProcessSample));
+    GArray *rows = apps_top_key == APPS_TOP_OFF ? g_array_new(FALSE, FALSE, sizeof(AppsRow))
+                                                : g_array_sized_new(FALSE, FALSE, sizeof(AppsRow), APPS_TOP_N);
+    gint64 scan_now = g_get_monotonic_time();
+    gint64 prev_scan_us = prev_scan_time_us;
+    gdouble elapsed_s = prev_scan_us > 0 ? (scan_now - prev_scan_us) / (gdouble)G_USEC_PER_SEC : 0.0;
+    prev_scan_time_us = scan_now;
+
     /* Capture first visible row path before model reset */
     GtkTreePath *first_visible_path = NULL;
     gtk_tree_view_get_path_at_pos(tree_view, 0, 0, &first_visible_path, NULL, NULL, NULL);
@@ -334,13 +828,17 @@ static gboolean update_apps_list(gpointer user_data) {
     GHashTable *parent_iter_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
     GHashTable *pid_iter_hash = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
 
-    typedef struct { GtkTreeIter *iter; double cpu; gulong mem; } AggData;
+    typedef struct { GtkTreeIter *iter; guint uid; double cpu; gulong mem; double io; double gpu; guint64 vram; double rq_wait;
+                     double minflt, majflt, vcsw, nvcsw; } AggData;
     GHashTable *agg_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 
     DIR *proc_dir = opendir("/proc");
     if (!proc_dir) {
         perror("opendir /proc failed");
         prev_total_system_jiffies = current_total_system_jiffies;
+        g_hash_table_destroy(visible_pids);
+        g_array_free(samples, TRUE);
+        g_array_free(rows, TRUE);
         return TRUE;
     }
 
@@ -348,8 +846,13 @@ static gboolean update_apps_list(gpointer user_data) {
     while ((entry = readdir(proc_dir)) != NULL) {
         if (entry->d_type == DT_DIR && isdigit(entry->d_name[0])) {
             pid_t pid = atoi(entry->d_name);
-            char stat_path[512], comm_path[512], proc_name[256] = {0}, cpu_percent_str[16] = "0.0%", mem_str[16] = "0.0 MB";
+            char stat_path[512], comm_path[512], proc_name[256] = {0};
             gulong utime = 0, stime = 0, kb = 0;
+            gulong minflt = 0, majflt = 0, vcsw = 0, nvcsw = 0;
+            guint uid = 0;
+            gint last_cpu = -1;
+            guint64 starttime = 0;
+            double cpu_percent = 0.0;
 
             snprintf(comm_path, sizeof(comm_path), "/proc/%s/comm", entry->d_name);
             FILE *fp_comm = fopen(comm_path, "r");
@@ -369,27 +872,29 @@ static gboolean update_apps_list(gpointer user_data) {
                     char *p_close = strrchr(stat_buffer, ')');
                     if (p_open && p_close) {
                         *p_close = '\0';
-                        sscanf(p_close + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime);
+                        // ... utime stime, starttime (field 22), then processor (field 39)
+                        sscanf(p_close + 2, "%*c %*d %*d %*d %*d %*d %*u %lu %*u %lu %*u %lu %lu "
+                               "%*d %*d %*d %*d %*d %*d %" G_GUINT64_FORMAT " %*u %*d %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*d %d",
+                               &minflt, &majflt, &utime, &stime, &starttime, &last_cpu);
                     }
                 }
                 fclose(fp_stat);
             }
 
-            kb = get_process_memory_kb(pid);
-            snprintf(mem_str, sizeof(mem_str), "%.1f", kb/1024.0);
+            kb = get_process_status(pid, &uid, &vcsw, &nvcsw);
 
             if (process_cpu_times_hash && system_jiffies_delta > 0) {
                 ProcessCpuData *data = g_hash_table_lookup(process_cpu_times_hash, GINT_TO_POINTER(pid));
                 gulong current_process_total = utime + stime;
                 if (data) {
                     gulong process_jiffies_delta = current_process_total - (data->prev_utime + data->prev_stime);
-                    double cpu_percent = 100.0 * process_jiffies_delta / system_jiffies_delta;
-                    snprintf(cpu_percent_str, sizeof(cpu_percent_str), "%.1f%%", cpu_percent > 0.0 ? cpu_percent : 0.0);
+                    cpu_percent = 100.0 * process_jiffies_delta / system_jiffies_delta;
+                    if (cpu_percent < 0.0) cpu_percent = 0.0;
                     data->prev_utime = utime;
                     data->prev_stime = stime;
                     data->seen_this_cycle = TRUE;
                 } else {
-                    data = g_new(ProcessCpuData, 1);
+                    data = g_new0(ProcessCpuData, 1);
                     data->prev_utime = utime;
                     data->prev_stime = stime;
                     data->seen_this_cycle = TRUE;
@@ -398,7 +903,7 @@ static gboolean update_apps_list(gpointer user_data) {
             } else if (process_cpu_times_hash) {
                  ProcessCpuData *data = g_hash_table_lookup(process_cpu_times_hash, GINT_TO_POINTER(pid));
                  if (!data) {
-                    data = g_new(ProcessCpuData, 1);
+                    data = g_new0(ProcessCpuData, 1);
                     data->prev_utime = utime;
                     data->prev_stime = stime;
                     data->seen_this_cycle = TRUE;
@@ -410,70 +915,160 @@ static gboolean update_apps_list(gpointer user_data) {
                  }
             }
             
-            // Skip system services (in system.slice) for Apps tab
-            char cgroup_path[64];
-            snprintf(cgroup_path, sizeof(cgroup_path), "/proc/%d/cgroup", pid);
-            FILE *fp_cg = fopen(cgroup_path, "r");
+            // Charge this interval's CPU time to the core the process last ran on
+            cpu_core_attribution_add(last_cpu, (guint)pid, proc_name, cpu_percent * num_cpus);
+
+            // Application identity is resolved once per process lifetime
             gboolean is_service = FALSE;
-            if (fp_cg) {
-                char cg_line[256];
-                while (fgets(cg_line, sizeof(cg_line), fp_cg)) {
-                    if (strstr(cg_line, "system.slice")) { is_service = TRUE; break; }
-                }
-                fclose(fp_cg);
-            }
-            if (is_service) continue;
+            const AppIdentity *app = app_identity_for_pid((guint)pid, starttime, proc_name, &is_service);
+
+            // /proc/<pid>/io is only read when a view shows it
+            gboolean want_io = apps_top_key == APPS_TOP_IO || apps_group_by == APPS_GROUP_USER;
+            gdouble io_kbps = want_io ? get_process_io_kbps(pid, scan_now, prev_scan_us) : 0.0;
+
+            // Every process counts towards its user, services and filtered rows included
+            user_stats_add(uid, cpu_percent, kb, io_kbps);
+
+            // Skip system services (in system.slice) unless grouping by user
+            if (is_service && apps_group_by == APPS_GROUP_APP) continue;
+
+            // Rates are updated for every process so filtered rows do not go stale
+            AppsRow row = { .pid = pid, .uid = uid, .cpu = cpu_percent, .mem_kb = kb, .io_kbps = io_kbps };
+            row.rq_wait_ms = get_process_rq_wait_ms(pid, elapsed_s);
+            update_process_event_rates(pid, minflt, majflt, vcsw, nvcsw, elapsed_s, &row);
+
+            ProcessSample sample = { (guint)pid, (gfloat)cpu_percent, (gfloat)(kb / 1024.0) };
+            g_array_append_val(samples, sample);
 
             // Apply search filter: show only matching app names
-            gchar *proc_lower = g_ascii_strdown(proc_name, -1);
-            if (apps_search_filter[0] != '\0' && !g_strrstr(proc_lower, apps_search_filter)) {
+            if (apps_search_filter[0] != '\0') {
+                gchar *proc_lower = g_ascii_strdown(proc_name, -1);
+                gchar *app_lower = g_ascii_strdown(app->name, -1);
+                gboolean match = g_strrstr(proc_lower, apps_search_filter) || g_strrstr(app_lower, apps_search_filter);
                 g_free(proc_lower);
-                continue;
-            }
-            g_free(proc_lower);
-
-            GtkTreeIter *parent_iter_ptr = g_hash_table_lookup(parent_iter_hash, proc_name);
-            if (!parent_iter_ptr) {
-                parent_iter_ptr = g_new(GtkTreeIter, 1);
-                gtk_tree_store_append(tree_store, parent_iter_ptr, NULL); // Top-level row
-                gtk_tree_store_set(tree_store, parent_iter_ptr,
-                                   COLUMN_APP_ICON, get_icon_for_app(proc_name),
-                                   COLUMN_APP_NAME, proc_name,
-                                   COLUMN_APP_PID, (guint)0, // No PID for parent row
-                                   COLUMN_APP_CPU_STR, "",
-                                   COLUMN_APP_MEM_STR, "",
-                                   -1);
-                g_hash_table_insert(parent_iter_hash, g_strdup(proc_name), parent_iter_ptr);
-
-                // create agg entry
-                AggData *ad = g_new0(AggData,1);
-                ad->iter = parent_iter_ptr;
-                g_hash_table_insert(agg_hash, g_strdup(proc_name), ad);
+                g_free(app_lower);
+                if (!match) continue;
             }
 
-            // update aggregator
-            AggData *ad = g_hash_table_lookup(agg_hash, proc_name);
-            if (ad) {
-                ad->cpu += atof(cpu_percent_str); // using previously computed string without %
-                ad->mem += kb;
-            }
+            g_strlcpy(row.name, proc_name, sizeof(row.name));
+            row.app = app;
 
-            GtkTreeIter child_iter;
-            gtk_tree_store_append(tree_store, &child_iter, parent_iter_ptr);
-            gtk_tree_store_set(tree_store, &child_iter,
-                               COLUMN_APP_ICON, get_icon_for_app(proc_name),
-                               COLUMN_APP_NAME, proc_name,
-                               COLUMN_APP_PID, (guint)pid,
-                               COLUMN_APP_CPU_STR, cpu_percent_str,
-                               COLUMN_APP_MEM_STR, mem_str,
+            if (apps_top_key == APPS_TOP_OFF) g_array_append_val(rows, row);
+            else top_heap_offer(rows, &row, APPS_TOP_N);
+        }
+    }
+    closedir(proc_dir);
+    cpu_core_attribution_end();
+    app_identity_end_cycle();
+    user_stats_end_cycle();
+
+    // Highest first, so the tree fills in rank order before sorting kicks in
+    if (apps_top_key != APPS_TOP_OFF) g_array_sort(rows, compare_apps_row_desc);
+
+    /* Only the selected rows get strings, icons and tree rows */
+    for (guint i = 0; i < rows->len; i++) {
+        const AppsRow *row = &g_array_index(rows, AppsRow, i);
+        const gchar *proc_name = row->name;
+        char cpu_percent_str[16], mem_str[16], io_str[16] = "", gpu_str[16] = "", vram_str[16] = "", wait_str[16];
+        snprintf(cpu_percent_str, sizeof(cpu_percent_str), "%.1f%%", row->cpu);
+        if (apps_top_key == APPS_TOP_IO || apps_group_by == APPS_GROUP_USER)
+            snprintf(io_str, sizeof(io_str), "%.1f", row->io_kbps);
+        snprintf(wait_str, sizeof(wait_str), "%.1f", row->rq_wait_ms);
+        char minflt_str[16], majflt_str[16], vcsw_str[16], nvcsw_str[16];
+        snprintf(minflt_str, sizeof(minflt_str), "%.0f", row->minflt_rate);
+        snprintf(majflt_str, sizeof(majflt_str), "%.0f", row->majflt_rate);
+        snprintf(vcsw_str, sizeof(vcsw_str), "%.0f", row->vcsw_rate);
+        snprintf(nvcsw_str, sizeof(nvcsw_str), "%.0f", row->nvcsw_rate);
+        snprintf(mem_str, sizeof(mem_str), "%.1f", row->mem_kb / 1024.0);
+        const GpuProcessUsage *gpu_usage = gpu_fdinfo_get_process((guint)row->pid);
+        if (gpu_usage) {
+            snprintf(gpu_str, sizeof(gpu_str), "%.1f%%", gpu_usage->busy_percent);
+            snprintf(vram_str, sizeof(vram_str), "%.1f", gpu_usage->vram_bytes / (1024.0 * 1024.0));
+        }
+
+        const AppIdentity *app = row->app;
+        const gchar *group_id = app->id, *group_name = app->name, *group_icon = app->icon;
+        char uid_id[24];
+        if (apps_group_by == APPS_GROUP_USER) {
+            snprintf(uid_id, sizeof(uid_id), "uid:%u", row->uid);
+            const UserStats *user = user_stats_get(row->uid);
+            group_id = uid_id;
+            group_name = user ? user->name : uid_id + 4;
+            group_icon = "avatar-default";
+        }
+        GtkTreeIter *parent_iter_ptr = g_hash_table_lookup(parent_iter_hash, group_id);
+        if (!parent_iter_ptr) {
+            parent_iter_ptr = g_new(GtkTreeIter, 1);
+            gtk_tree_store_append(tree_store, parent_iter_ptr, NULL); // Top-level row
+            gtk_tree_store_set(tree_store, parent_iter_ptr,
+                               COLUMN_APP_ICON, get_icon_for_app(group_icon),
+                               COLUMN_APP_NAME, group_name,
+                               COLUMN_APP_GROUP_ID, group_id,
+                               COLUMN_APP_PID, (guint)0, // No PID for parent row
+                               COLUMN_APP_CPU_STR, "",
+                               COLUMN_APP_MEM_STR, "",
+                               COLUMN_APP_IO_STR, "",
+                               COLUMN_APP_GPU_STR, "",
+                               COLUMN_APP_VRAM_STR, "",
+                               COLUMN_APP_RQ_WAIT_STR, "",
+                               COLUMN_APP_MINFLT_STR, "",
+                               COLUMN_APP_MAJFLT_STR, "",
+                               COLUMN_APP_VCSW_STR, "",
+                               COLUMN_APP_NVCSW_STR, "",
                                -1);
+            g_hash_table_insert(parent_iter_hash, g_strdup(group_id), parent_iter_ptr);
 
-            GtkTreeIter *child_copy = g_new(GtkTreeIter,1);
-            *child_copy = child_iter;
-            g_hash_table_insert(pid_iter_hash, GINT_TO_POINTER(pid), child_copy);
+            // create agg entry
+            AggData *ad = g_new0(AggData,1);
+            ad->iter = parent_iter_ptr;
+            ad->uid = row->uid;
+            g_hash_table_insert(agg_hash, g_strdup(group_id), ad);
         }
+
+        // update aggregator
+        AggData *ad = g_hash_table_lookup(agg_hash, group_id);
+        if (ad) {
+            ad->cpu += row->cpu;
+            ad->mem += row->mem_kb;
+            ad->io += row->io_kbps;
+            ad->rq_wait += row->rq_wait_ms;
+            ad->minflt += row->minflt_rate;
+            ad->majflt += row->majflt_rate;
+            ad->vcsw += row->vcsw_rate;
+            ad->nvcsw += row->nvcsw_rate;
+            if (gpu_usage) {
+                ad->gpu += gpu_usage->busy_percent;
+                ad->vram += gpu_usage->vram_bytes;
+            }
+        }
+
+        GtkTreeIter child_iter;
+        gtk_tree_store_append(tree_store, &child_iter, parent_iter_ptr);
+        gtk_tree_store_set(tree_store, &child_iter,
+                           COLUMN_APP_ICON, get_icon_for_app(app->icon),
+                           COLUMN_APP_NAME, proc_name,
+                           COLUMN_APP_PID, (guint)row->pid,
+                           COLUMN_APP_CPU_STR, cpu_percent_str,
+                           COLUMN_APP_MEM_STR, mem_str,
+                           COLUMN_APP_IO_STR, io_str,
+                           COLUMN_APP_GPU_STR, gpu_str,
+                           COLUMN_APP_VRAM_STR, vram_str,
+                           COLUMN_APP_RQ_WAIT_STR, wait_str,
+                           COLUMN_APP_MINFLT_STR, minflt_str,
+                           COLUMN_APP_MAJFLT_STR, majflt_str,
+                           COLUMN_APP_VCSW_STR, vcsw_str,
+                           COLUMN_APP_NVCSW_STR, nvcsw_str,
+                           -1);
+
+        GtkTreeIter *child_copy = g_new(GtkTreeIter,1);
+        *child_copy = child_iter;
+        g_hash_table_insert(pid_iter_hash, GINT_TO_POINTER(row->pid), child_copy);
     }
-    closedir(proc_dir);
+    g_array_free(rows, TRUE);
+
+    update_process_history(samples, visible_pids);
+    g_array_free(samples, TRUE);
+    g_hash_table_destroy(visible_pids);
 
     if (process_cpu_times_hash) {
         GList *keys_to_remove = NULL;
@@ -491,7 +1086,7 @@ static gboolean update_apps_list(gpointer user_data) {
     if (gtk_tree_model_get_iter_first(new_model, &parent_iter_re)) {
         do {
             gchar *app_name = NULL;
-            gtk_tree_model_get(new_model, &parent_iter_re, COLUMN_APP_NAME, &app_name, -1);
+            gtk_tree_model_get(new_model, &parent_iter_re, COLUMN_APP_GROUP_ID, &app_name, -1);
             if (app_name && g_hash_table_contains(expanded_apps, app_name)) {
                 GtkTreePath *path = gtk_tree_model_get_path(new_model, &parent_iter_re);
                 gtk_tree_view_expand_row(tree_view, path, FALSE);
@@ -508,11 +1103,45 @@ static gboolean update_apps_list(gpointer user_data) {
     g_hash_table_iter_init(&itagg, agg_hash);
     while (g_hash_table_iter_next(&itagg, &kagg, &vagg)) {
         AggData *ad = vagg;
+        char io_str[16] = "";
+        if (apps_group_by == APPS_GROUP_USER) {
+            // User rows show the whole user, even when the filter or Top N hides some processes
+            const UserStats *user = user_stats_get(ad->uid);
+            if (user) {
+                gchar *name = g_strdup_printf("%s (%u processes)", user->name, user->nprocs);
+                gtk_tree_store_set(tree_store, ad->iter, COLUMN_APP_NAME, name, -1);
+                g_free(name);
+                ad->cpu = user->cpu;
+                ad->mem = user->mem_kb;
+                ad->io = user->io_kbps;
+            }
+            snprintf(io_str,sizeof(io_str),"%.1f", ad->io);
+        } else if (apps_top_key == APPS_TOP_IO) {
+            snprintf(io_str,sizeof(io_str),"%.1f", ad->io);
+        }
         char cpu_str[16]; snprintf(cpu_str,sizeof(cpu_str),"%.1f", ad->cpu);
         char mem_str[16]; snprintf(mem_str,sizeof(mem_str),"%.1f", ad->mem/1024.0);
+        char wait_str[16]; snprintf(wait_str,sizeof(wait_str),"%.1f", ad->rq_wait);
+        char minflt_str[16]; snprintf(minflt_str,sizeof(minflt_str),"%.0f", ad->minflt);
+        char majflt_str[16]; snprintf(majflt_str,sizeof(majflt_str),"%.0f", ad->majflt);
+        char vcsw_str[16]; snprintf(vcsw_str,sizeof(vcsw_str),"%.0f", ad->vcsw);
+        char nvcsw_str[16]; snprintf(nvcsw_str,sizeof(nvcsw_str),"%.0f", ad->nvcsw);
+        char gpu_str[16] = "", vram_str[16] = "";
+        if (ad->gpu > 0.0 || ad->vram > 0) {
+            snprintf(gpu_str,sizeof(gpu_str),"%.1f%%", MIN(ad->gpu, 100.0));
+            snprintf(vram_str,sizeof(vram_str),"%.1f", ad->vram/(1024.0*1024.0));
+        }
         gtk_tree_store_set(tree_store, ad->iter,
                            COLUMN_APP_CPU_STR, cpu_str,
                            COLUMN_APP_MEM_STR, mem_str,
+                           COLUMN_APP_IO_STR, io_str,
+                           COLUMN_APP_GPU_STR, gpu_str,
+                           COLUMN_APP_VRAM_STR, vram_str,
+                           COLUMN_APP_RQ_WAIT_STR, wait_str,
+                           COLUMN_APP_MINFLT_STR, minflt_str,
+                           COLUMN_APP_MAJFLT_STR, majflt_str,
+                           COLUMN_APP_VCSW_STR, vcsw_str,
+                           COLUMN_APP_NVCSW_STR, nvcsw_str,
                            -1);
     }
 
@@ -575,6 +1204,28 @@ static void on_apps_search_changed(GtkEntry *entry, gpointer user_data) {
     update_apps_list(user_data);
 }
 
+/* Top N selector changed */
+static void on_apps_top_mode_changed(GtkComboBox *combo, gpointer user_data) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
+    apps_top_key = (AppsTopKey)gtk_combo_box_get_active(combo);
+
+    GtkTreeSortable *sortable = GTK_TREE_SORTABLE(gtk_tree_view_get_model(tree_view));
+    if (apps_top_key == APPS_TOP_CPU)
+        gtk_tree_sortable_set_sort_column_id(sortable, COLUMN_APP_CPU_STR, GTK_SORT_DESCENDING);
+    else if (apps_top_key == APPS_TOP_RSS)
+        gtk_tree_sortable_set_sort_column_id(sortable, COLUMN_APP_MEM_STR, GTK_SORT_DESCENDING);
+    else if (apps_top_key == APPS_TOP_IO)
+        gtk_tree_sortable_set_sort_column_id(sortable, COLUMN_APP_IO_STR, GTK_SORT_DESCENDING);
+
+    update_apps_list(tree_view);
+}
+
+/* Group-by selector changed */
+static void on_apps_group_by_changed(GtkComboBox *combo, gpointer user_data) {
+    apps_group_by = (AppsGroupBy)gtk_combo_box_get_active(combo);
+    update_apps_list(user_data);
+}
+
 /* --------------------------- Start New Task ---------------------------*/
 static void on_start_task_clicked(GtkButton *btn, gpointer user_data) {
     GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
@@ -631,7 +1282,10 @@ GtkWidget* create_apps_tab(void) {
     apps_scrolled_window = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(apps_scrolled_window), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
 
-    GtkTreeStore *apps_tree_store = gtk_tree_store_new(N_APP_COLUMNS, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_UINT, G_TYPE_STRING, G_TYPE_STRING);
+    GtkTreeStore *apps_tree_store = gtk_tree_store_new(N_APP_COLUMNS, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_UINT, G_TYPE_STRING, G_TYPE_STRING,
+                                                        G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                                        G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                                        G_TYPE_STRING);
     apps_tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(apps_tree_store));
     g_object_unref(apps_tree_store);
 
@@ -663,12 +1317,87 @@ GtkWidget* create_apps_tab(void) {
     gtk_tree_view_column_set_sort_column_id(mem_col, COLUMN_APP_MEM_STR);
     gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), mem_col);
 
+    GtkTreeViewColumn *io_col = gtk_tree_view_column_new_with_attributes("Disk KB/s", text_renderer, "text", COLUMN_APP_IO_STR, NULL);
+    gtk_tree_view_column_set_sort_column_id(io_col, COLUMN_APP_IO_STR);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), io_col);
+    gtk_widget_set_tooltip_text(gtk_tree_view_column_get_button(io_col),
+                                "Disk reads and writes per second (/proc/<pid>/io); measured in the user view and Top by I/O");
+
+    GtkTreeViewColumn *gpu_col = gtk_tree_view_column_new_with_attributes("GPU %", text_renderer, "text", COLUMN_APP_GPU_STR, NULL);
+    gtk_tree_view_column_set_sort_column_id(gpu_col, COLUMN_APP_GPU_STR);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), gpu_col);
+
+    GtkTreeViewColumn *vram_col = gtk_tree_view_column_new_with_attributes("VRAM MB", text_renderer, "text", COLUMN_APP_VRAM_STR, NULL);
+    gtk_tree_view_column_set_sort_column_id(vram_col, COLUMN_APP_VRAM_STR);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), vram_col);
+
+    GtkTreeViewColumn *wait_col = gtk_tree_view_column_new_with_attributes("Wait ms/s", text_renderer, "text", COLUMN_APP_RQ_WAIT_STR, NULL);
+    gtk_tree_view_column_set_sort_column_id(wait_col, COLUMN_APP_RQ_WAIT_STR);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), wait_col);
+    gtk_widget_set_tooltip_text(gtk_tree_view_column_get_button(wait_col),
+                                "Time spent runnable but waiting for a CPU, per second (/proc/<pid>/schedstat)");
+
+    /* Page-fault and context-switch rates, all sorted numerically */
+    static const struct { const gchar *title; gint column; const gchar *tooltip; } rate_columns[] = {
+        { "Min flt/s",  COLUMN_APP_MINFLT_STR, "Minor page faults per second" },
+        { "Maj flt/s",  COLUMN_APP_MAJFLT_STR, "Major page faults (disk reads) per second" },
+        { "Vol cs/s",   COLUMN_APP_VCSW_STR,   "Voluntary context switches per second (blocking, waiting on locks or I/O)" },
+        { "Invol cs/s", COLUMN_APP_NVCSW_STR,  "Involuntary context switches per second (preempted)" },
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(rate_columns); i++) {
+        GtkTreeViewColumn *col = gtk_tree_view_column_new_with_attributes(rate_columns[i].title, text_renderer,
+                                                                          "text", rate_columns[i].column, NULL);
+        gtk_tree_view_column_set_sort_column_id(col, rate_columns[i].column);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), col);
+        gtk_widget_set_tooltip_text(gtk_tree_view_column_get_button(col), rate_columns[i].tooltip);
+    }
+
+    GtkCellRenderer *spark_renderer = khos_cell_renderer_sparkline_new();
+    GtkTreeViewColumn *spark_col = gtk_tree_view_column_new();
+    gtk_tree_view_column_set_title(spark_col, "History");
+    gtk_tree_view_column_pack_start(spark_col, spark_renderer, FALSE);
+    gtk_tree_view_column_set_cell_data_func(spark_col, spark_renderer, sparkline_cell_data_func, NULL, NULL);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tree_view), spark_col);
+
     GtkWidget *apps_menu = gtk_menu_new();
     GtkWidget *kill_item = gtk_menu_item_new_with_label("Kill");
 
     g_signal_connect(kill_item, "activate", G_CALLBACK(on_kill_activate), apps_tree_view);
 
     gtk_menu_shell_append(GTK_MENU_SHELL(apps_menu), kill_item);
+
+    // Resource controls; a group row applies them to every process of the app
+    gtk_menu_shell_append(GTK_MENU_SHELL(apps_menu), gtk_separator_menu_item_new());
+    GtkWidget *priority_menu = gtk_menu_new();
+    append_value_item(priority_menu, "Very high", -10, G_CALLBACK(on_renice_activate), apps_tree_view);
+    append_value_item(priority_menu, "High", -5, G_CALLBACK(on_renice_activate), apps_tree_view);
+    append_value_item(priority_menu, "Normal", 0, G_CALLBACK(on_renice_activate), apps_tree_view);
+    append_value_item(priority_menu, "Low", 10, G_CALLBACK(on_renice_activate), apps_tree_view);
+    append_value_item(priority_menu, "Very low", 19, G_CALLBACK(on_renice_activate), apps_tree_view);
+    append_submenu(apps_menu, "Priority", priority_menu);
+
+    GtkWidget *io_menu = gtk_menu_new();
+    append_value_item(io_menu, "High", 0, G_CALLBACK(on_ionice_activate), apps_tree_view);
+    append_value_item(io_menu, "Normal", 4, G_CALLBACK(on_ionice_activate), apps_tree_view);
+    append_value_item(io_menu, "Low", 7, G_CALLBACK(on_ionice_activate), apps_tree_view);
+    append_value_item(io_menu, "Idle", -1, G_CALLBACK(on_ionice_activate), apps_tree_view);
+    append_submenu(apps_menu, "I/O priority", io_menu);
+
+    GtkWidget *affinity_item = gtk_menu_item_new_with_label("Set CPU affinity...");
+    g_signal_connect(affinity_item, "activate", G_CALLBACK(on_affinity_activate), apps_tree_view);
+    gtk_menu_shell_append(GTK_MENU_SHELL(apps_menu), affinity_item);
+
+    gtk_menu_shell_append(GTK_MENU_SHELL(apps_menu), gtk_separator_menu_item_new());
+    append_value_item(apps_menu, "Freeze", TRUE, G_CALLBACK(on_freeze_activate), apps_tree_view);
+    append_value_item(apps_menu, "Thaw", FALSE, G_CALLBACK(on_freeze_activate), apps_tree_view);
+
+    GtkWidget *limit_cpu_item = gtk_menu_item_new_with_label("Limit CPU...");
+    g_signal_connect(limit_cpu_item, "activate", G_CALLBACK(on_limit_cpu_activate), apps_tree_view);
+    gtk_menu_shell_append(GTK_MENU_SHELL(apps_menu), limit_cpu_item);
+    GtkWidget *limit_mem_item = gtk_menu_item_new_with_label("Limit memory...");
+    g_signal_connect(limit_mem_item, "activate", G_CALLBACK(on_limit_memory_activate), apps_tree_view);
+    gtk_menu_shell_append(GTK_MENU_SHELL(apps_menu), limit_mem_item);
+
     gtk_widget_show_all(apps_menu);
 
     gtk_widget_add_events(apps_tree_view, GDK_BUTTON_PRESS_MASK);
@@ -682,6 +1411,26 @@ GtkWidget* create_apps_tab(void) {
     gtk_box_pack_start(GTK_BOX(toolbar), start_btn, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(toolbar), search_entry, TRUE, TRUE, 0);
 
+    GtkWidget *group_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(group_combo), "By application");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(group_combo), "By user");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(group_combo), apps_group_by);
+    gtk_box_pack_start(GTK_BOX(toolbar), group_combo, FALSE, FALSE, 0);
+    g_signal_connect(group_combo, "changed", G_CALLBACK(on_apps_group_by_changed), apps_tree_view);
+
+    GtkWidget *top_combo = gtk_combo_box_text_new();
+    gchar *top_label = NULL;
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(top_combo), "All processes");
+    static const gchar *const top_keys[] = { "CPU", "memory", "I/O" };
+    for (guint i = 0; i < G_N_ELEMENTS(top_keys); i++) {
+        top_label = g_strdup_printf("Top %d by %s", APPS_TOP_N, top_keys[i]);
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(top_combo), top_label);
+        g_free(top_label);
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(top_combo), apps_top_key);
+    gtk_box_pack_start(GTK_BOX(toolbar), top_combo, FALSE, FALSE, 0);
+    g_signal_connect(top_combo, "changed", G_CALLBACK(on_apps_top_mode_changed), apps_tree_view);
+
     g_signal_connect(search_entry, "search-changed", G_CALLBACK(on_apps_search_changed), apps_tree_view);
     g_signal_connect(start_btn, "clicked", G_CALLBACK(on_start_task_clicked), apps_tree_view);
 
@@ -697,6 +1446,13 @@ GtkWidget* create_apps_tab(void) {
     gtk_tree_sortable_set_sort_column_id(sortable, COLUMN_APP_NAME, GTK_SORT_ASCENDING);
     gtk_tree_sortable_set_sort_func(sortable, COLUMN_APP_CPU_STR, sort_by_cpu_str, NULL, NULL);
     gtk_tree_sortable_set_sort_func(sortable, COLUMN_APP_MEM_STR, sort_by_mem_str, NULL, NULL);
+    gtk_tree_sortable_set_sort_func(sortable, COLUMN_APP_IO_STR, sort_by_numeric_str, GINT_TO_POINTER(COLUMN_APP_IO_STR), NULL);
+    gtk_tree_sortable_set_sort_func(sortable, COLUMN_APP_GPU_STR, sort_by_numeric_str, GINT_TO_POINTER(COLUMN_APP_GPU_STR), NULL);
+    gtk_tree_sortable_set_sort_func(sortable, COLUMN_APP_VRAM_STR, sort_by_numeric_str, GINT_TO_POINTER(COLUMN_APP_VRAM_STR), NULL);
+    gtk_tree_sortable_set_sort_func(sortable, COLUMN_APP_RQ_WAIT_STR, sort_by_numeric_str, GINT_TO_POINTER(COLUMN_APP_RQ_WAIT_STR), NULL);
+    for (gint col = COLUMN_APP_MINFLT_STR; col <= COLUMN_APP_NVCSW_STR; col++) {
+        gtk_tree_sortable_set_sort_func(sortable, col, sort_by_numeric_str, GINT_TO_POINTER(col), NULL);
+    }
 
     AppsUpdateData *apps_upd = g_new0(AppsUpdateData, 1);
     apps_upd->interval_seconds = 2;
@@ -714,4 +1470,7 @@ void ui_app_cleanup(void) {
         g_hash_table_destroy(process_cpu_times_hash);
         process_cpu_times_hash = NULL;
     }
+    proc_history_cleanup();
+    app_identity_cleanup();
+    user_stats_cleanup();
 }
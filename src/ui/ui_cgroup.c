@@ -0,0 +1,373 @@
+#include "ui/ui_cgroup.h"
+#include "ui/graph_utils.h"
+#include "ui/khos_graph.h"
+#include "cgroup/cgroup_data.h"
+#include <string.h>
+
+/* ----------------------------------------------------------------------------------
+ *  "Cgroups" tab – slices, scopes, services and containers straight from
+ *  /sys/fs/cgroup, with per-cgroup rates and history for the selected row
+ * --------------------------------------------------------------------------------*/
+
+static const GdkRGBA cgroup_memory_color = { 76 / 255.0, 175 / 255.0, 80 / 255.0, 1.0 };  // Green, as in the Memory tab
+
+enum {
+    CG_COL_NAME,
+    CG_COL_PATH,
+    CG_COL_CPU_STR,
+    CG_COL_CPU_VAL,
+    CG_COL_MEM_STR,
+    CG_COL_MEM_VAL,
+    CG_COL_IO_READ_STR,
+    CG_COL_IO_WRITE_STR,
+    CG_COL_IO_VAL,
+    CG_COL_PIDS,
+    N_CG_COLUMNS
+};
+
+/* Worst offenders list (throttling, PSI and memory.events) */
+#define CG_STALL_ROWS 10
+
+enum {
+    STALL_COL_NAME,
+    STALL_COL_PATH,
+    STALL_COL_THROTTLED,
+    STALL_COL_CPU_PSI,
+    STALL_COL_MEM_PSI,
+    STALL_COL_EVENTS,
+    N_STALL_COLUMNS
+};
+
+typedef struct {
+    GtkTreeView *tree_view;
+    GtkTreeStore *store;
+    GHashTable *rows;            // path -> GtkTreeRowReference*
+    GtkListStore *stall_store;
+    GtkWidget *cpu_area;
+    GtkWidget *mem_area;
+    GtkWidget *selected_label;
+    gchar *selected_path;
+    guint timeout_id;
+} CgroupUpdateData;
+
+static void cleanup_cgroup_update_data(gpointer data) {
+    CgroupUpdateData *upd = (CgroupUpdateData*)data;
+    if (!upd) return;
+    if (upd->timeout_id > 0) {
+        g_source_remove(upd->timeout_id);
+        upd->timeout_id = 0;
+    }
+    g_hash_table_destroy(upd->rows);
+    g_free(upd->selected_path);
+    g_free(upd);
+    // Only the tab's own state; the collector is released once at shutdown in main.c
+}
+
+static void format_rate(char *buf, gsize size, gdouble kbps) {
+    if (kbps >= 1024.0) snprintf(buf, size, "%.1f MB/s", kbps / 1024.0);
+    else if (kbps >= 0.1) snprintf(buf, size, "%.1f KB/s", kbps);
+    else snprintf(buf, size, "-");
+}
+
+static void set_row_values(GtkTreeStore *store, GtkTreeIter *iter, const CgroupInfo *cg) {
+    char cpu_str[16], mem_str[24], read_str[24], write_str[24];
+    snprintf(cpu_str, sizeof(cpu_str), "%.1f%%", cg->cpu_percent);
+    if (cg->has_memory) snprintf(mem_str, sizeof(mem_str), "%.1f MB", cg->memory_current / (1024.0 * 1024.0));
+    else snprintf(mem_str, sizeof(mem_str), "-");
+    format_rate(read_str, sizeof(read_str), cg->io_read_kbps);
+    format_rate(write_str, sizeof(write_str), cg->io_write_kbps);
+
+    gtk_tree_store_set(store, iter,
+                       CG_COL_CPU_STR, cpu_str,
+                       CG_COL_CPU_VAL, cg->cpu_percent,
+                       CG_COL_MEM_STR, mem_str,
+                       CG_COL_MEM_VAL, (gdouble)cg->memory_current,
+                       CG_COL_IO_READ_STR, read_str,
+                       CG_COL_IO_WRITE_STR, write_str,
+                       CG_COL_IO_VAL, cg->io_read_kbps + cg->io_write_kbps,
+                       CG_COL_PIDS, cg->has_pids ? (guint)cg->pids_current : 0u,
+                       -1);
+}
+
+static void update_stall_list(CgroupUpdateData *upd) {
+    CgroupStallRank ranks[CG_STALL_ROWS];
+    gint n = cgroup_get_worst_stalls(ranks, CG_STALL_ROWS);
+
+    gtk_list_store_clear(upd->stall_store);
+    for (gint i = 0; i < n; i++) {
+        const CgroupStallRank *r = &ranks[i];
+        char throttled[48], cpu_psi[16], mem_psi[16], events[64];
+        if (r->throttles > 0)
+            snprintf(throttled, sizeof(throttled), "%.1f%% (%" G_GUINT64_FORMAT "x)", r->throttled_percent, r->throttles);
+        else
+            snprintf(throttled, sizeof(throttled), "-");
+        snprintf(cpu_psi, sizeof(cpu_psi), "%.1f%%", r->cpu_pressure);
+        snprintf(mem_psi, sizeof(mem_psi), "%.1f%%", r->mem_pressure);
+        if (r->mem_high || r->mem_max || r->oom_kills)
+            snprintf(events, sizeof(events), "high %" G_GUINT64_FORMAT ", max %" G_GUINT64_FORMAT ", oom %" G_GUINT64_FORMAT,
+                     r->mem_high, r->mem_max, r->oom_kills);
+        else
+            snprintf(events, sizeof(events), "-");
+
+        GtkTreeIter iter;
+        gtk_list_store_append(upd->stall_store, &iter);
+        gtk_list_store_set(upd->stall_store, &iter,
+                           STALL_COL_NAME, r->cgroup->name,
+                           STALL_COL_PATH, r->cgroup->path,
+                           STALL_COL_THROTTLED, throttled,
+                           STALL_COL_CPU_PSI, cpu_psi,
+                           STALL_COL_MEM_PSI, mem_psi,
+                           STALL_COL_EVENTS, events,
+                           -1);
+    }
+}
+
+/* Selecting another cgroup swaps the plotted histories, which rebuilds the
+ * graphs; a cgroup that went away leaves them empty */
+static void update_selected_graphs(CgroupUpdateData *upd) {
+    const CgroupInfo *cg = cgroup_lookup(upd->selected_path ? upd->selected_path : "");
+    KhosGraph *cpu_graph = KHOS_GRAPH(upd->cpu_area);
+    KhosGraph *mem_graph = KHOS_GRAPH(upd->mem_area);
+    khos_graph_set_series_history(cpu_graph, 0, cg ? cg->cpu_history : NULL);
+    khos_graph_set_series_history(mem_graph, 0, cg ? cg->mem_history : NULL);
+    if (!cg) return;
+    khos_graph_push(cpu_graph, cg->history_index);
+    khos_graph_push(mem_graph, cg->history_index);
+}
+
+/* Update rows in place so expansion, selection and scroll position survive */
+static gboolean update_cgroup_view(gpointer user_data) {
+    CgroupUpdateData *upd = (CgroupUpdateData*)user_data;
+    cgroup_data_update();
+
+    gint count = cgroup_get_count();
+    for (gint i = 0; i < count; i++) {
+        const CgroupInfo *cg = cgroup_get_info(i);
+        GtkTreeIter iter;
+        GtkTreeRowReference *ref = g_hash_table_lookup(upd->rows, cg->path);
+        GtkTreePath *path = ref ? gtk_tree_row_reference_get_path(ref) : NULL;
+
+        if (path) {
+            gtk_tree_model_get_iter(GTK_TREE_MODEL(upd->store), &iter, path);
+        } else {
+            // Parents are visited first, so the parent row already exists
+            GtkTreeIter parent_iter;
+            GtkTreeIter *parent = NULL;
+            const gchar *slash = strrchr(cg->path, '/');
+            gchar *parent_path = cg->depth == 0 ? NULL
+                               : slash ? g_strndup(cg->path, slash - cg->path) : g_strdup("");
+            GtkTreeRowReference *parent_ref = parent_path ? g_hash_table_lookup(upd->rows, parent_path) : NULL;
+            GtkTreePath *pp = parent_ref ? gtk_tree_row_reference_get_path(parent_ref) : NULL;
+            if (pp && gtk_tree_model_get_iter(GTK_TREE_MODEL(upd->store), &parent_iter, pp)) {
+                parent = &parent_iter;
+            }
+            gtk_tree_path_free(pp);
+            g_free(parent_path);
+
+            gtk_tree_store_append(upd->store, &iter, parent);
+            gtk_tree_store_set(upd->store, &iter,
+                               CG_COL_NAME, cg->name,
+                               CG_COL_PATH, cg->path,
+                               -1);
+            path = gtk_tree_model_get_path(GTK_TREE_MODEL(upd->store), &iter);
+            g_hash_table_replace(upd->rows, g_strdup(cg->path),
+                                 gtk_tree_row_reference_new(GTK_TREE_MODEL(upd->store), path));
+            if (cg->depth == 0) gtk_tree_view_expand_row(upd->tree_view, path, FALSE);
+        }
+        set_row_values(upd->store, &iter, cg);
+        gtk_tree_path_free(path);
+    }
+
+    // Remove rows of cgroups that disappeared (children go with their parent)
+    GHashTableIter it; gpointer key, value;
+    g_hash_table_iter_init(&it, upd->rows);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        if (cgroup_lookup(key)) continue;
+        GtkTreePath *path = gtk_tree_row_reference_get_path(value);
+        GtkTreeIter iter;
+        if (path && gtk_tree_model_get_iter(GTK_TREE_MODEL(upd->store), &iter, path)) {
+            gtk_tree_store_remove(upd->store, &iter);
+        }
+        gtk_tree_path_free(path);
+        g_hash_table_iter_remove(&it);
+    }
+
+    update_stall_list(upd);
+    update_selected_graphs(upd);
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_cgroup_selection_changed(GtkTreeSelection *selection, gpointer user_data) {
+    CgroupUpdateData *upd = (CgroupUpdateData*)user_data;
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    g_free(upd->selected_path);
+    upd->selected_path = NULL;
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        gtk_tree_model_get(model, &iter, CG_COL_PATH, &upd->selected_path, -1);
+    }
+    gchar *title = g_strdup_printf("/%s", upd->selected_path ? upd->selected_path : "");
+    gtk_label_set_text(GTK_LABEL(upd->selected_label), title);
+    g_free(title);
+    update_selected_graphs(upd);
+}
+
+// Jump to an offender in the cgroup tree
+static void on_stall_row_activated(GtkTreeView *view, GtkTreePath *path, GtkTreeViewColumn *column, gpointer user_data) {
+    (void)column;
+    CgroupUpdateData *upd = (CgroupUpdateData*)user_data;
+    GtkTreeModel *model = gtk_tree_view_get_model(view);
+    GtkTreeIter iter;
+    if (!gtk_tree_model_get_iter(model, &iter, path)) return;
+
+    gchar *cg_path = NULL;
+    gtk_tree_model_get(model, &iter, STALL_COL_PATH, &cg_path, -1);
+    GtkTreeRowReference *ref = cg_path ? g_hash_table_lookup(upd->rows, cg_path) : NULL;
+    GtkTreePath *tree_path = ref ? gtk_tree_row_reference_get_path(ref) : NULL;
+    if (tree_path) {
+        gtk_tree_view_expand_to_path(upd->tree_view, tree_path);
+        gtk_tree_selection_select_path(gtk_tree_view_get_selection(upd->tree_view), tree_path);
+        gtk_tree_view_scroll_to_cell(upd->tree_view, tree_path, NULL, FALSE, 0, 0);
+        gtk_tree_path_free(tree_path);
+    }
+    g_free(cg_path);
+}
+
+static void draw_cgroup_legend(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer user_data) {
+    CgroupUpdateData *upd = (CgroupUpdateData*)user_data;
+    const CgroupInfo *cg = cgroup_lookup(upd->selected_path ? upd->selected_path : "");
+    if (!cg) return;
+
+    GdkRGBA bg, fg;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg, &fg, NULL, NULL);
+    char label[48];
+    if (GTK_WIDGET(graph) == upd->cpu_area) {
+        snprintf(label, sizeof(label), "CPU %.1f%%", cg->cpu_percent);
+    } else {
+        gdouble mem_max;
+        khos_graph_get_range(graph, NULL, &mem_max);
+        snprintf(label, sizeof(label), "Memory %.1f MB (max %.0f)", cg->memory_current / (1024.0 * 1024.0), mem_max);
+    }
+    cairo_set_source_rgba(cr, fg.red, fg.green, fg.blue, 0.9);
+    cairo_move_to(cr, 5, 15);
+    cairo_show_text(cr, label);
+}
+
+static GtkTreeViewColumn* add_text_column(GtkTreeView *view, const gchar *title, gint text_col, gint sort_col) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", text_col, NULL);
+    gtk_tree_view_column_set_sort_column_id(column, sort_col);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(view, column);
+    return column;
+}
+
+GtkWidget* create_cgroup_tab(void) {
+    cgroup_data_init();
+
+    GtkTreeStore *store = gtk_tree_store_new(N_CG_COLUMNS,
+                                             G_TYPE_STRING, G_TYPE_STRING,
+                                             G_TYPE_STRING, G_TYPE_DOUBLE,
+                                             G_TYPE_STRING, G_TYPE_DOUBLE,
+                                             G_TYPE_STRING, G_TYPE_STRING, G_TYPE_DOUBLE,
+                                             G_TYPE_UINT);
+    GtkWidget *tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    g_object_unref(store);
+
+    GtkTreeViewColumn *name_col = add_text_column(GTK_TREE_VIEW(tree_view), "Cgroup", CG_COL_NAME, CG_COL_NAME);
+    gtk_tree_view_column_set_expand(name_col, TRUE);
+    add_text_column(GTK_TREE_VIEW(tree_view), "CPU %", CG_COL_CPU_STR, CG_COL_CPU_VAL);
+    add_text_column(GTK_TREE_VIEW(tree_view), "Memory", CG_COL_MEM_STR, CG_COL_MEM_VAL);
+    add_text_column(GTK_TREE_VIEW(tree_view), "Read", CG_COL_IO_READ_STR, CG_COL_IO_VAL);
+    add_text_column(GTK_TREE_VIEW(tree_view), "Write", CG_COL_IO_WRITE_STR, CG_COL_IO_VAL);
+    add_text_column(GTK_TREE_VIEW(tree_view), "Tasks", CG_COL_PIDS, CG_COL_PIDS);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_container_add(GTK_CONTAINER(scrolled), tree_view);
+
+    // Worst offenders over the sliding window
+    GtkListStore *stall_store = gtk_list_store_new(N_STALL_COLUMNS,
+                                                   G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                                   G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget *stall_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(stall_store));
+    g_object_unref(stall_store);
+    GtkTreeViewColumn *stall_name_col = add_text_column(GTK_TREE_VIEW(stall_view), "Cgroup", STALL_COL_NAME, -1);
+    gtk_tree_view_column_set_expand(stall_name_col, TRUE);
+    add_text_column(GTK_TREE_VIEW(stall_view), "CPU throttled", STALL_COL_THROTTLED, -1);
+    add_text_column(GTK_TREE_VIEW(stall_view), "CPU pressure", STALL_COL_CPU_PSI, -1);
+    add_text_column(GTK_TREE_VIEW(stall_view), "Memory pressure", STALL_COL_MEM_PSI, -1);
+    add_text_column(GTK_TREE_VIEW(stall_view), "Memory events", STALL_COL_EVENTS, -1);
+
+    GtkWidget *stall_scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(stall_scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(stall_scrolled, -1, 140);
+    gtk_container_add(GTK_CONTAINER(stall_scrolled), stall_view);
+
+    gchar *stall_title = g_strdup_printf("Throttling and pressure (last %d s)", CGROUP_STALL_WINDOW * 2);
+    GtkWidget *stall_frame = gtk_frame_new(stall_title);
+    g_free(stall_title);
+    gtk_container_add(GTK_CONTAINER(stall_frame), stall_scrolled);
+
+    GtkWidget *paned = gtk_paned_new(GTK_ORIENTATION_VERTICAL);
+    gtk_paned_pack1(GTK_PANED(paned), scrolled, TRUE, FALSE);
+    gtk_paned_pack2(GTK_PANED(paned), stall_frame, FALSE, FALSE);
+    gtk_widget_set_vexpand(paned, TRUE);
+
+    GtkWidget *selected_label = gtk_label_new("/");
+    gtk_widget_set_halign(selected_label, GTK_ALIGN_START);
+    gtk_label_set_ellipsize(GTK_LABEL(selected_label), PANGO_ELLIPSIZE_START);
+
+    GtkWidget *cpu_area = khos_graph_new(MAX_POINTS);
+    GtkWidget *mem_area = khos_graph_new(MAX_POINTS);
+    gtk_widget_set_size_request(cpu_area, -1, 120);
+    gtk_widget_set_size_request(mem_area, -1, 120);
+    gtk_widget_set_hexpand(cpu_area, TRUE);
+    gtk_widget_set_hexpand(mem_area, TRUE);
+    khos_graph_add_series(KHOS_GRAPH(cpu_area), NULL, KHOS_GRAPH_GRADIENT, 2.0);
+    khos_graph_add_series(KHOS_GRAPH(mem_area), &cgroup_memory_color, KHOS_GRAPH_GRADIENT, 2.0);
+    // Memory (MB) is autoscaled to the window's peak plus 10%
+    khos_graph_set_autoscale(KHOS_GRAPH(mem_area), 1.0, 1.1);
+
+    GtkWidget *graphs = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    GtkWidget *cpu_frame = gtk_frame_new(NULL);
+    GtkWidget *mem_frame = gtk_frame_new(NULL);
+    gtk_frame_set_shadow_type(GTK_FRAME(cpu_frame), GTK_SHADOW_ETCHED_IN);
+    gtk_frame_set_shadow_type(GTK_FRAME(mem_frame), GTK_SHADOW_ETCHED_IN);
+    gtk_container_add(GTK_CONTAINER(cpu_frame), cpu_area);
+    gtk_container_add(GTK_CONTAINER(mem_frame), mem_area);
+    gtk_box_pack_start(GTK_BOX(graphs), cpu_frame, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(graphs), mem_frame, TRUE, TRUE, 0);
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_widget_set_margin_start(vbox, 10);
+    gtk_widget_set_margin_end(vbox, 10);
+    gtk_widget_set_margin_top(vbox, 10);
+    gtk_widget_set_margin_bottom(vbox, 10);
+    gtk_box_pack_start(GTK_BOX(vbox), paned, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), selected_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), graphs, FALSE, FALSE, 0);
+
+    CgroupUpdateData *upd = g_new0(CgroupUpdateData, 1);
+    upd->tree_view = GTK_TREE_VIEW(tree_view);
+    upd->store = store;
+    upd->rows = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gtk_tree_row_reference_free);
+    upd->stall_store = stall_store;
+    upd->cpu_area = cpu_area;
+    upd->mem_area = mem_area;
+    upd->selected_label = selected_label;
+
+    // The labels carry the current values; only their band is redrawn between scrolls
+    khos_graph_set_overlay_func(KHOS_GRAPH(cpu_area), draw_cgroup_legend, upd, 20);
+    khos_graph_set_overlay_func(KHOS_GRAPH(mem_area), draw_cgroup_legend, upd, 20);
+    g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(tree_view)), "changed",
+                     G_CALLBACK(on_cgroup_selection_changed), upd);
+    g_signal_connect(stall_view, "row-activated", G_CALLBACK(on_stall_row_activated), upd);
+
+    upd->timeout_id = g_timeout_add_seconds(2, update_cgroup_view, upd);
+    g_object_set_data_full(G_OBJECT(vbox), "cgroup_update_data", upd, cleanup_cgroup_update_data);
+
+    update_cgroup_view(upd); // initial population
+    return vbox;
+}
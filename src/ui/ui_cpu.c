@@ -1,16 +1,53 @@
 #include "ui/ui_cpu.h"
 #include "cpu/cpu_data.h"
+#include "cpu/cpu_topology.h"
+#include "cpu/cpu_freq.h"
+#include "cpu/cpu_irq.h"
+#include "cpu/cpu_idle.h"
+#include "cpu/cpu_perf.h"
+#include "cpu/cpu_rapl.h"
+#include "ui/khos_graph.h"
 #include <cairo.h>
 #include <math.h>
 
+static const GdkRGBA alert_color = { 224 / 255.0, 27 / 255.0, 36 / 255.0, 1.0 };      // Red for blocked tasks
+static const GdkRGBA runqueue_color = { 230 / 255.0, 97 / 255.0, 0.0, 1.0 };          // Orange for run-queue wait
+
 static gboolean draw_cpu_graph(GtkWidget *widget, cairo_t *cr, gpointer data);
+static void plot_cpu_states(cairo_t *cr, int width, int height, gpointer data);
+static void draw_cpu_graph_legend(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer data);
 static gboolean update_cpu_widgets(gpointer user_data);
 static gboolean on_cpu_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
+static gboolean draw_runqueue_graph(GtkWidget *widget, cairo_t *cr, gpointer data);
+static GtkWidget* create_node_graphs(void);
+static gboolean draw_freq_graphs(GtkWidget *widget, cairo_t *cr, gpointer data);
+static gboolean draw_irq_heatmap(GtkWidget *widget, cairo_t *cr, gpointer data);
+static GtkWidget* create_sched_graphs(void);
+static gboolean draw_idle_states(GtkWidget *widget, cairo_t *cr, gpointer data);
+static gboolean draw_perf_graphs(GtkWidget *widget, cairo_t *cr, gpointer data);
+static GtkWidget* create_power_graph(void);
+static void draw_idle_bar(cairo_t *cr, double x, double y, double w, double h, gint cpu, gboolean vertical);
+static gboolean on_cpu_graph_query_tooltip(GtkWidget *widget, gint x, gint y, gboolean keyboard_mode,
+                                           GtkTooltip *tooltip, gpointer user_data);
 
 typedef struct {
     GtkWidget *drawing_area;
     GtkWidget *cpu_label_value;
     GtkWidget *cpu_freq_value;
+    GtkWidget *governor_value;
+    GtkWidget *epp_value;
+    GtkWidget *throttle_value;
+    GtkWidget *details_notebook;
+    GtkWidget *runqueue_area;
+    GtkWidget *nodes_area;
+    GtkWidget *freq_area;
+    GtkWidget *irq_area;
+    GtkWidget *sched_area;
+    GtkWidget *idle_area;
+    GtkWidget *perf_area;
+    GtkWidget *power_area;
+    GtkWidget *load_value;
+    GtkWidget *power_value;
     guint update_interval;
     guint timeout_id;
 } CpuUpdateData;
@@ -20,6 +57,7 @@ static void show_processors_dialog(GtkWidget *parent) {
                                                   GTK_WINDOW(gtk_widget_get_toplevel(parent)),
                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
                                                   "Show Individual Graphs", GTK_RESPONSE_YES,
+                                                  "Show Heatmap", GTK_RESPONSE_ACCEPT,
                                                   "Show Combined Graph", GTK_RESPONSE_NO,
                                                   "Close", GTK_RESPONSE_CLOSE,
                                                   NULL);
@@ -64,12 +102,14 @@ static void show_processors_dialog(GtkWidget *parent) {
     gtk_widget_show_all(dialog);
     gint result = gtk_dialog_run(GTK_DIALOG(dialog));
     
-    if (result == GTK_RESPONSE_YES) {
+    if (result == GTK_RESPONSE_YES || result == GTK_RESPONSE_ACCEPT) {
         set_show_per_cpu_graphs(TRUE);
+        graph_per_core_set_heatmap(parent, result == GTK_RESPONSE_ACCEPT);
         gtk_widget_queue_draw(parent);
     } else if (result == GTK_RESPONSE_NO) {
         set_show_per_cpu_graphs(FALSE);
-        gtk_widget_queue_draw(parent);
+        // The combined plot was not kept up to date meanwhile
+        graph_invalidate_scrolling(parent);
     }
     
     gtk_widget_destroy(dialog);
@@ -124,6 +164,35 @@ static void on_processors_activate(GtkMenuItem *item, gpointer user_data) {
     show_processors_dialog(drawing_area);
 }
 
+static void on_perf_counters_toggled(GtkCheckMenuItem *item, gpointer user_data) {
+    GtkWidget *drawing_area = GTK_WIDGET(user_data);
+    if (!gtk_check_menu_item_get_active(item)) {
+        cpu_perf_disable();
+        gtk_widget_queue_draw(drawing_area);
+        return;
+    }
+
+    GError *err = NULL;
+    if (!cpu_perf_enable(get_cpu_threads(), &err)) {
+        g_printerr("%s\n", err->message);
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(gtk_widget_get_toplevel(drawing_area)),
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
+                                                   "Could not open performance counters");
+        gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog), "%s%s", err->message,
+            err->code == CPU_PERF_ERROR_PERMISSION
+                ? "\n\nSystem-wide counters need CAP_PERFMON or kernel.perf_event_paranoid set to 0 or lower." : "");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        g_error_free(err);
+
+        g_signal_handlers_block_by_func(item, on_perf_counters_toggled, user_data);
+        gtk_check_menu_item_set_active(item, FALSE);
+        g_signal_handlers_unblock_by_func(item, on_perf_counters_toggled, user_data);
+    }
+    gtk_widget_queue_draw(drawing_area);
+}
+
 static void on_refresh_activate(GtkMenuItem *item, gpointer user_data) {
     GtkWidget *drawing_area = GTK_WIDGET(user_data);
     GtkWidget *parent = gtk_widget_get_parent(gtk_widget_get_parent(drawing_area)); // graph_frame -> main_grid
@@ -144,10 +213,15 @@ GtkWidget* create_cpu_tab(void) {
     gtk_grid_set_column_spacing(GTK_GRID(main_grid), 20);
     gtk_grid_set_row_spacing(GTK_GRID(main_grid), 10);
 
-    GtkWidget *drawing_area = gtk_drawing_area_new();
+    GtkWidget *drawing_area = khos_graph_new(MAX_POINTS);
     gtk_widget_set_size_request(drawing_area, -1, 250);
     gtk_widget_set_hexpand(drawing_area, TRUE);
     gtk_widget_set_vexpand(drawing_area, TRUE);
+    khos_graph_add_series(KHOS_GRAPH(drawing_area), NULL, KHOS_GRAPH_LINE, 2.5);
+    khos_graph_set_series_history(KHOS_GRAPH(drawing_area), 0, get_cpu_usage_history());
+    khos_graph_set_underlay_func(KHOS_GRAPH(drawing_area), plot_cpu_states, drawing_area);
+    // The legend percentages change every tick; only its strip is redrawn with the new samples
+    khos_graph_set_overlay_func(KHOS_GRAPH(drawing_area), draw_cpu_graph_legend, NULL, 22);
     g_signal_connect(G_OBJECT(drawing_area), "draw", G_CALLBACK(draw_cpu_graph), NULL);
 
     GtkWidget *menu = gtk_menu_new();
@@ -157,12 +231,19 @@ GtkWidget* create_cpu_tab(void) {
     g_signal_connect(refresh_item, "activate", G_CALLBACK(on_refresh_activate), drawing_area);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), processors_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), refresh_item);
+    GtkWidget *perf_item = gtk_check_menu_item_new_with_label("Performance Counters (IPC, Cache Misses)");
+    g_signal_connect(perf_item, "toggled", G_CALLBACK(on_perf_counters_toggled), drawing_area);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), perf_item);
     gtk_widget_show_all(menu);
     
     // Connect the right-click event to the drawing area
     gtk_widget_add_events(drawing_area, GDK_BUTTON_PRESS_MASK);
     g_signal_connect(drawing_area, "button-press-event", G_CALLBACK(on_cpu_tab_button_press), menu);
 
+    // Hovering a core in per-core mode lists the processes running on it
+    gtk_widget_set_has_tooltip(drawing_area, TRUE);
+    g_signal_connect(drawing_area, "query-tooltip", G_CALLBACK(on_cpu_graph_query_tooltip), NULL);
+
     GtkWidget *graph_frame = gtk_frame_new(NULL);
     gtk_frame_set_shadow_type(GTK_FRAME(graph_frame), GTK_SHADOW_ETCHED_IN);
     gtk_container_add(GTK_CONTAINER(graph_frame), drawing_area);
@@ -192,9 +273,13 @@ GtkWidget* create_cpu_tab(void) {
     ADD_CPU_SPEC("Vendor:", get_cpu_vendor_id());
     ADD_CPU_SPEC("Model:", get_cpu_model());
     ADD_CPU_SPEC("Architecture:", get_cpu_architecture());
-    char cores_str[32];
-    snprintf(cores_str, sizeof(cores_str), "%d Cores, %d Threads", get_cpu_cores(), get_cpu_threads());
+    char cores_str[64];
+    snprintf(cores_str, sizeof(cores_str), "%d Sockets, %d Cores, %d Threads",
+             cpu_topology_get_packages(), get_cpu_cores(), get_cpu_threads());
     ADD_CPU_SPEC("Processors:", cores_str);
+    char nodes_str[16];
+    snprintf(nodes_str, sizeof(nodes_str), "%d", cpu_topology_get_nodes());
+    ADD_CPU_SPEC("NUMA Nodes:", nodes_str);
     char family_str[32];
     snprintf(family_str, sizeof(family_str), "Family %s, Stepping %s", get_cpu_family(), get_cpu_stepping());
     ADD_CPU_SPEC("Family/Stepping:", family_str);
@@ -210,6 +295,20 @@ GtkWidget* create_cpu_tab(void) {
     gtk_widget_set_halign(cpu_freq_value, GTK_ALIGN_START);
     gtk_grid_attach(GTK_GRID(info_grid), cpu_freq_label, 0, row, 1, 1);
     gtk_grid_attach(GTK_GRID(info_grid), cpu_freq_value, 1, row, 1, 1);
+    row++;
+
+    // Frequency policy rows, refreshed every tick
+    static const gchar *const policy_titles[] = { "Governor:", "EPP:", "Throttle Events:", "Load Average:", "Package Power:" };
+    GtkWidget *policy_values[G_N_ELEMENTS(policy_titles)];
+    for (gsize i = 0; i < G_N_ELEMENTS(policy_titles); i++) {
+        GtkWidget *label = gtk_label_new(policy_titles[i]);
+        gtk_widget_set_halign(label, GTK_ALIGN_START);
+        policy_values[i] = gtk_label_new("N/A");
+        gtk_widget_set_halign(policy_values[i], GTK_ALIGN_START);
+        gtk_grid_attach(GTK_GRID(info_grid), label, 0, row, 1, 1);
+        gtk_grid_attach(GTK_GRID(info_grid), policy_values[i], 1, row, 1, 1);
+        row++;
+    }
 
     GtkWidget *usage_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
     GtkWidget *cpu_label_title = gtk_label_new("Usage:");
@@ -228,11 +327,75 @@ GtkWidget* create_cpu_tab(void) {
     gtk_grid_attach(GTK_GRID(main_grid), usage_box, 0, 0, 1, 1);
     gtk_grid_attach(GTK_GRID(main_grid), graph_frame, 0, 1, 1, 1);
     gtk_grid_attach(GTK_GRID(main_grid), info_frame, 1, 0, 1, 2);
+
+    // Detail pages below the usage graph
+    GtkWidget *details_notebook = gtk_notebook_new();
+    GtkWidget *runqueue_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(runqueue_area, -1, 160);
+    gtk_widget_set_hexpand(runqueue_area, TRUE);
+    g_signal_connect(G_OBJECT(runqueue_area), "draw", G_CALLBACK(draw_runqueue_graph), NULL);
+    gtk_widget_set_tooltip_text(runqueue_area, "Time tasks spent runnable but waiting on each CPU (/proc/schedstat run_delay)");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), runqueue_area, gtk_label_new("Run queue"));
+    GtkWidget *nodes_area = create_node_graphs();
+    gtk_widget_set_size_request(nodes_area, -1, 160);
+    gtk_widget_set_hexpand(nodes_area, TRUE);
+    gtk_widget_set_tooltip_text(nodes_area, "Average usage of the CPUs in each NUMA node (each package without NUMA)");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), nodes_area,
+                             gtk_label_new(cpu_topology_get_nodes() > 1 ? "NUMA nodes" : "Packages"));
+    GtkWidget *freq_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(freq_area, -1, 160);
+    gtk_widget_set_hexpand(freq_area, TRUE);
+    g_signal_connect(G_OBJECT(freq_area), "draw", G_CALLBACK(draw_freq_graphs), NULL);
+    gtk_widget_set_tooltip_text(freq_area, "Current frequency of each CPU as a share of its maximum (cpufreq scaling_cur_freq)");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), freq_area, gtk_label_new("Frequency"));
+    GtkWidget *irq_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(irq_area, -1, 160);
+    gtk_widget_set_hexpand(irq_area, TRUE);
+    g_signal_connect(G_OBJECT(irq_area), "draw", G_CALLBACK(draw_irq_heatmap), NULL);
+    gtk_widget_set_tooltip_text(irq_area, "Interrupts and softirqs per second on each CPU (/proc/interrupts, /proc/softirqs)");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), irq_area, gtk_label_new("Interrupts"));
+    GtkWidget *sched_area = create_sched_graphs();
+    gtk_widget_set_size_request(sched_area, -1, 160);
+    gtk_widget_set_hexpand(sched_area, TRUE);
+    gtk_widget_set_tooltip_text(sched_area, "Context switch, interrupt and fork rates, runnable and blocked tasks (/proc/stat) and load average");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), sched_area, gtk_label_new("Scheduler"));
+    GtkWidget *idle_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(idle_area, -1, 160);
+    gtk_widget_set_hexpand(idle_area, TRUE);
+    g_signal_connect(G_OBJECT(idle_area), "draw", G_CALLBACK(draw_idle_states), NULL);
+    gtk_widget_set_tooltip_text(idle_area, "Share of the last interval each CPU spent in each idle state (cpuidle), deepest on the right");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), idle_area, gtk_label_new("Idle states"));
+    GtkWidget *perf_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(perf_area, -1, 160);
+    gtk_widget_set_hexpand(perf_area, TRUE);
+    g_signal_connect(G_OBJECT(perf_area), "draw", G_CALLBACK(draw_perf_graphs), NULL);
+    gtk_widget_set_tooltip_text(perf_area, "Instructions per cycle and cache/branch misses per 1000 instructions (perf_event_open); enable from the graph's right-click menu");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), perf_area, gtk_label_new("Counters"));
+    GtkWidget *power_area = create_power_graph();
+    gtk_widget_set_size_request(power_area, -1, 160);
+    gtk_widget_set_hexpand(power_area, TRUE);
+    gtk_widget_set_tooltip_text(power_area, "Package, core and DRAM power in watts from the RAPL energy counters (powercap)");
+    gtk_notebook_append_page(GTK_NOTEBOOK(details_notebook), power_area, gtk_label_new("Power"));
+    gtk_grid_attach(GTK_GRID(main_grid), details_notebook, 0, 2, 2, 1);
     
     CpuUpdateData *update_data = g_new(CpuUpdateData, 1);
     update_data->drawing_area = drawing_area;
     update_data->cpu_label_value = cpu_label_value;
     update_data->cpu_freq_value = cpu_freq_value;
+    update_data->governor_value = policy_values[0];
+    update_data->epp_value = policy_values[1];
+    update_data->throttle_value = policy_values[2];
+    update_data->load_value = policy_values[3];
+    update_data->power_value = policy_values[4];
+    update_data->details_notebook = details_notebook;
+    update_data->runqueue_area = runqueue_area;
+    update_data->nodes_area = nodes_area;
+    update_data->freq_area = freq_area;
+    update_data->irq_area = irq_area;
+    update_data->sched_area = sched_area;
+    update_data->idle_area = idle_area;
+    update_data->perf_area = perf_area;
+    update_data->power_area = power_area;
     update_data->update_interval = 1000; // Default to 1 second
     
     g_object_set_data(G_OBJECT(main_grid), "update_data", update_data);
@@ -252,6 +415,11 @@ static gboolean on_cpu_tab_button_press(GtkWidget *widget, GdkEventButton *event
     return FALSE;
 }
 
+// The node and scheduler rows all plot rings that advance with the CPU usage history
+static void push_cpu_history_graph(GtkWidget *graph, gpointer user_data) {
+    khos_graph_push(KHOS_GRAPH(graph), get_cpu_usage_history_index());
+}
+
 static gboolean update_cpu_widgets(gpointer user_data) {
     CpuUpdateData *data = (CpuUpdateData*)user_data;
     cpu_data_update();
@@ -266,90 +434,686 @@ static gboolean update_cpu_widgets(gpointer user_data) {
     else snprintf(freq_str, sizeof(freq_str), "%.0f MHz", freq_mhz);
     gtk_label_set_text(GTK_LABEL(data->cpu_freq_value), freq_str);
 
-    gtk_widget_queue_draw(data->drawing_area);
+    const gchar *governor = cpu_freq_get_governor(-1);
+    const gchar *epp = cpu_freq_get_epp(-1);
+    gtk_label_set_text(GTK_LABEL(data->governor_value), governor ? governor : "N/A");
+    gtk_label_set_text(GTK_LABEL(data->epp_value), epp ? epp : "N/A");
+    char throttle_str[32];
+    if (cpu_freq_get_throttle_counts(0, NULL, NULL)) {
+        snprintf(throttle_str, sizeof(throttle_str), "%" G_GUINT64_FORMAT, cpu_freq_get_throttle_events());
+    } else {
+        snprintf(throttle_str, sizeof(throttle_str), "N/A");
+    }
+    gtk_label_set_text(GTK_LABEL(data->throttle_value), throttle_str);
+
+    gdouble load1, load5, load15;
+    get_cpu_load_average(&load1, &load5, &load15);
+    char load_str[48];
+    snprintf(load_str, sizeof(load_str), "%.2f, %.2f, %.2f", load1, load5, load15);
+    gtk_label_set_text(GTK_LABEL(data->load_value), load_str);
+
+    // Sum of the packages; psys would count them twice
+    gdouble package_watts = 0.0;
+    gboolean have_package = FALSE;
+    for (gint d = 0; d < cpu_rapl_get_domain_count(); d++) {
+        if (!cpu_rapl_is_package(d) || !g_str_has_prefix(cpu_rapl_get_domain_name(d), "package")) continue;
+        package_watts += cpu_rapl_get_watts(d);
+        have_package = TRUE;
+    }
+    char power_str[32];
+    if (have_package) snprintf(power_str, sizeof(power_str), "%.1f W", package_watts);
+    else g_strlcpy(power_str, cpu_rapl_permission_denied() ? "N/A (root only)" : "N/A", sizeof(power_str));
+    gtk_label_set_text(GTK_LABEL(data->power_value), power_str);
+
+    khos_graph_push(KHOS_GRAPH(data->drawing_area), get_cpu_usage_history_index());
+    if (get_show_per_cpu_graphs()) gtk_widget_queue_draw(data->drawing_area);
+    gtk_widget_queue_draw(data->runqueue_area);
+    gtk_widget_queue_draw(data->freq_area);
+    gtk_container_foreach(GTK_CONTAINER(data->nodes_area), push_cpu_history_graph, NULL);
+    gtk_container_foreach(GTK_CONTAINER(data->sched_area), push_cpu_history_graph, NULL);
+    khos_graph_push(KHOS_GRAPH(data->power_area), cpu_rapl_get_history_index());
+    if (cpu_perf_get_mode() != CPU_PERF_OFF) {
+        cpu_perf_update();
+        gtk_widget_queue_draw(data->perf_area);
+    }
+    // The interrupt files are large on many-core hosts; only read them while the page is shown
+    GtkNotebook *details = GTK_NOTEBOOK(data->details_notebook);
+    GtkWidget *details_page = gtk_notebook_get_nth_page(details, gtk_notebook_get_current_page(details));
+    if (details_page == data->irq_area) {
+        cpu_irq_update();
+        gtk_widget_queue_draw(data->irq_area);
+    }
+    // Idle residency feeds the per-core cells and its own page
+    if (details_page == data->idle_area || get_show_per_cpu_graphs()) {
+        cpu_idle_update();
+        gtk_widget_queue_draw(data->idle_area);
+    }
     return G_SOURCE_CONTINUE;
 }
 
+static gboolean on_cpu_graph_query_tooltip(GtkWidget *widget, gint x, gint y, gboolean keyboard_mode,
+                                           GtkTooltip *tooltip, gpointer user_data) {
+    if (!get_show_per_cpu_graphs() || keyboard_mode) return FALSE;
+    gint core = graph_per_core_index_at(widget, get_cpu_threads(), x, y);
+    if (core < 0) return FALSE;
+
+    const CpuCoreProcess *top = NULL;
+    gint count = get_cpu_core_top_processes(core, &top);
+    GString *text = g_string_new(NULL);
+    g_string_append_printf(text, "<b>CPU %d</b>  %.1f%%\n", core, get_cpu_usage_by_core(core));
+    const CpuTopoEntry *topo = cpu_topology_get_cpu(core);
+    if (topo) {
+        g_string_append_printf(text, "Package %d, core %d, node %d\n", topo->package, topo->core, topo->node);
+    }
+    if (cpu_freq_get_mhz(core) > 0) {
+        g_string_append_printf(text, "%.0f of %.0f MHz", cpu_freq_get_mhz(core), cpu_freq_get_max_mhz(core));
+        const gchar *governor = cpu_freq_get_governor(core);
+        const gchar *epp = cpu_freq_get_epp(core);
+        if (governor) g_string_append_printf(text, ", %s", governor);
+        if (epp) g_string_append_printf(text, " (%s)", epp);
+        guint64 core_throttles, package_throttles;
+        if (cpu_freq_get_throttle_counts(core, &core_throttles, &package_throttles)) {
+            g_string_append_printf(text, "\nThrottled %" G_GUINT64_FORMAT " times (package %" G_GUINT64_FORMAT ")%s",
+                                   core_throttles, package_throttles,
+                                   cpu_freq_is_throttling(core) ? ", <b>throttling now</b>" : "");
+        }
+        g_string_append_c(text, '\n');
+    }
+    for (gint s = 0; s < CPU_N_STATES; s++) {
+        g_string_append_printf(text, "%s%s %.1f%%", s > 0 ? "  " : "",
+                               get_cpu_state_name(s), get_cpu_state_percent(core, s));
+    }
+    const CpuPerfSample *perf = cpu_perf_get_sample(core);
+    if (perf && cpu_perf_get_mode() == CPU_PERF_HARDWARE) {
+        g_string_append_printf(text, "\nIPC %.2f, LLC misses %.2f/k, branch misses %.2f/k, %.2f GHz unhalted%s",
+                               perf->ipc, perf->llc_mpki, perf->branch_mpki, perf->cycles_ghz,
+                               perf->multiplexed ? " (multiplexed)" : "");
+    } else if (perf) {
+        g_string_append_printf(text, "\nTask clock %.1f%%, %.0f context switches/s, %.0f page faults/s",
+                               perf->busy_percent, perf->ctx_switches, perf->page_faults);
+    }
+    if (cpu_idle_available()) {
+        g_string_append(text, "\nIdle:");
+        for (gint s = 0; s < cpu_idle_get_state_count(); s++) {
+            gchar *name = g_markup_escape_text(cpu_idle_get_state_name(s), -1);
+            g_string_append_printf(text, " %s %.0f%% (%.0f/s)", name,
+                                   cpu_idle_get_residency(core, s), cpu_idle_get_usage_rate(core, s));
+            g_free(name);
+        }
+    }
+    if (count == 0) g_string_append(text, "\nNo busy processes last ran here");
+    for (gint i = 0; i < count; i++) {
+        gchar *name = g_markup_escape_text(top[i].name, -1);
+        g_string_append_printf(text, "\n%s (%u)  %.1f%%", name, top[i].pid, top[i].core_percent);
+        g_free(name);
+    }
+    gtk_tooltip_set_markup(tooltip, text->str);
+    g_string_free(text, TRUE);
+
+    // Limit the tooltip to this core's cell so moving to another core re-queries it
+    GdkRectangle area;
+    if (graph_per_core_cell(widget, get_cpu_threads(), core, &area)) gtk_tooltip_set_tip_area(tooltip, &area);
+    return TRUE;
+}
+
+static void get_group_header_label(gint group, gchar *buf, gsize buf_size) {
+    gchar name[32];
+    cpu_topology_get_group_label(group, name, sizeof(name));
+    snprintf(buf, buf_size, "%s: %.1f%%", name, get_cpu_group_usage(group));
+}
+
+static void draw_node_label(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer data) {
+    GdkRGBA bg_color, fg_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, NULL, NULL);
+    gchar label[64];
+    get_group_header_label(GPOINTER_TO_INT(data), label, sizeof(label));
+    cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 12);
+    cairo_move_to(cr, 5, 15);
+    cairo_show_text(cr, label);
+}
+
+/* One graph per NUMA node (or package), stacked vertically, to spot imbalance */
+static GtkWidget* create_node_graphs(void) {
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_box_set_homogeneous(GTK_BOX(box), TRUE);
+    for (gint g = 0; g < cpu_topology_get_group_count(); g++) {
+        GtkWidget *graph = khos_graph_new(MAX_POINTS);
+        khos_graph_add_series(KHOS_GRAPH(graph), NULL, KHOS_GRAPH_GRADIENT, 2.0);
+        khos_graph_set_series_history(KHOS_GRAPH(graph), 0, get_cpu_group_usage_history(g));
+        khos_graph_set_overlay_func(KHOS_GRAPH(graph), draw_node_label, GINT_TO_POINTER(g), 20);
+        gtk_box_pack_start(GTK_BOX(box), graph, TRUE, TRUE, 0);
+    }
+    return box;
+}
+
+static void get_freq_label(gint index, gchar *buf, gsize buf_size) {
+    snprintf(buf, buf_size, "CPU %d: %.2f GHz%s", index, cpu_freq_get_mhz(index) / 1000.0,
+             cpu_freq_is_throttling(index) ? " (throttled)" : "");
+}
+
+static gboolean draw_freq_graphs(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(widget, &bg_color, &fg_color, &accent_color, NULL);
+    graph_draw_background(cr, gtk_widget_get_allocated_width(widget), gtk_widget_get_allocated_height(widget), &bg_color);
+
+    if (cpu_freq_get_average_mhz() <= 0) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, "CPU frequency is not exposed by this system (no cpufreq driver)");
+        return FALSE;
+    }
+
+    // 100% of the graph height is the core's cpuinfo_max_freq
+    graph_draw_per_core_graphs(cr, widget, get_cpu_threads(),
+                               cpu_freq_get_history,
+                               cpu_freq_get_history_index,
+                               cpu_freq_get_sample_count,
+                               get_freq_label,
+                               &bg_color, &fg_color, &accent_color, MAX_POINTS);
+    return FALSE;
+}
+
+#define IRQ_HEATMAP_ROWS 16
+#define IRQ_RANKING_ROWS 5
+#define IRQ_LABEL_WIDTH 120
+#define IRQ_ROW_HEIGHT 14
+
+// "44 virtio4-tx" for a hard IRQ (number and action), the name for everything else
+static void format_irq_name(const CpuIrqSource *src, gchar *buf, gsize buf_size) {
+    const gchar *action = src->kind == CPU_IRQ_HARD ? strrchr(src->desc, ' ') : NULL;
+    if (action && g_ascii_isdigit(src->name[0])) snprintf(buf, buf_size, "%s%s", src->name, action);
+    else if (src->kind == CPU_IRQ_HARD && src->desc[0] && !g_ascii_isdigit(src->name[0]))
+        snprintf(buf, buf_size, "%s %s", src->name, src->desc);
+    else g_strlcpy(buf, src->name, buf_size);
+}
+
+static void draw_irq_ranking(cairo_t *cr, double x, double y, const gchar *title, CpuIrqKind kind, GdkRGBA *fg_color) {
+    const CpuIrqSource *top[IRQ_RANKING_ROWS];
+    gint count = cpu_irq_get_top(kind, top, IRQ_RANKING_ROWS);
+    cairo_set_source_rgba(cr, fg_color->red, fg_color->green, fg_color->blue, 0.9);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_move_to(cr, x, y);
+    cairo_show_text(cr, title);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    for (gint i = 0; i < count; i++) {
+        gchar name[48], line[96];
+        format_irq_name(top[i], name, sizeof(name));
+        gint cpu = top[i]->busiest_cpu;
+        snprintf(line, sizeof(line), "%s  %.0f/s, %.0f%% on CPU %d", name, top[i]->total_rate,
+                 100.0 * top[i]->rate[cpu] / top[i]->total_rate, cpu);
+        cairo_move_to(cr, x, y + (i + 1) * IRQ_ROW_HEIGHT);
+        cairo_show_text(cr, line);
+    }
+}
+
+/* Busiest IRQ and softirq sources × CPUs; a single bright column is one
+ * core soaking up a device's interrupts */
+static gboolean draw_irq_heatmap(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(widget, &bg_color, &fg_color, &accent_color, NULL);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    graph_draw_background(cr, width, height, &bg_color);
+    cairo_set_font_size(cr, 10);
+
+    if (!cpu_irq_available()) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, "/proc/interrupts is not readable");
+        return FALSE;
+    }
+
+    // Heatmap on the left two thirds, rankings on the right
+    int map_width = width * 2 / 3;
+    int ranking_x = map_width + 10;
+    const CpuIrqSource *rows[IRQ_HEATMAP_ROWS];
+    gint max_rows = CLAMP((height - IRQ_ROW_HEIGHT) / IRQ_ROW_HEIGHT, 0, IRQ_HEATMAP_ROWS);
+    gint n_rows = cpu_irq_get_top(-1, rows, max_rows);
+    gint n_cpus = MIN(get_cpu_threads(), MAX_CPU_CORES);
+    gdouble max_rate = cpu_irq_get_max_rate();
+    double cell_w = (double)(map_width - IRQ_LABEL_WIDTH) / MAX(1, n_cpus);
+
+    if (n_rows == 0) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, "Collecting interrupt counts...");
+        return FALSE;
+    }
+
+    // CPU numbers along the top when they fit
+    cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+    for (gint cpu = 0; cpu < n_cpus && cell_w >= 14; cpu++) {
+        char num[8];
+        snprintf(num, sizeof(num), "%d", cpu);
+        cairo_move_to(cr, IRQ_LABEL_WIDTH + cpu * cell_w + 2, 10);
+        cairo_show_text(cr, num);
+    }
+
+    for (gint r = 0; r < n_rows; r++) {
+        double y = IRQ_ROW_HEIGHT + r * IRQ_ROW_HEIGHT;
+        gchar name[48];
+        format_irq_name(rows[r], name, sizeof(name));
+        cairo_save(cr);
+        cairo_rectangle(cr, 0, y, IRQ_LABEL_WIDTH - 4, IRQ_ROW_HEIGHT);
+        cairo_clip(cr);
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+        cairo_move_to(cr, 4, y + IRQ_ROW_HEIGHT - 3);
+        cairo_show_text(cr, name);
+        cairo_restore(cr);
+
+        for (gint cpu = 0; cpu < n_cpus; cpu++) {
+            if (rows[r]->rate[cpu] <= 0.0 || max_rate <= 0.0) continue;
+            // Square root so a lone hot vector does not wash out the rest
+            double alpha = 0.1 + 0.9 * sqrt(rows[r]->rate[cpu] / max_rate);
+            cairo_set_source_rgba(cr, accent_color.red, accent_color.green, accent_color.blue, alpha);
+            cairo_rectangle(cr, IRQ_LABEL_WIDTH + cpu * cell_w, y, MAX(1.0, cell_w - 1), IRQ_ROW_HEIGHT - 1);
+            cairo_fill(cr);
+        }
+    }
+
+    draw_irq_ranking(cr, ranking_x, 14, "Top IRQs", CPU_IRQ_HARD, &fg_color);
+    draw_irq_ranking(cr, ranking_x, 14 + (IRQ_RANKING_ROWS + 2) * IRQ_ROW_HEIGHT, "Top softirqs", CPU_IRQ_SOFT, &fg_color);
+    return FALSE;
+}
+
+static void draw_sched_label(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer data) {
+    CpuSchedCounter counter = GPOINTER_TO_INT(data);
+    GdkRGBA bg_color, fg_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, NULL, NULL);
+    gdouble peak;
+    khos_graph_get_range(graph, NULL, &peak);
+
+    char label[96];
+    if (counter == CPU_SCHED_RUNNING) {
+        snprintf(label, sizeof(label), "Running %.0f, blocked (D) %.0f  (peak %.0f)",
+                 get_cpu_sched_counter(CPU_SCHED_RUNNING), get_cpu_sched_counter(CPU_SCHED_BLOCKED), peak);
+    } else if (counter == CPU_SCHED_LOAD1) {
+        gdouble load1, load5, load15;
+        get_cpu_load_average(&load1, &load5, &load15);
+        snprintf(label, sizeof(label), "Load %.2f, %.2f, %.2f  (%d CPUs)", load1, load5, load15, get_cpu_threads());
+    } else {
+        snprintf(label, sizeof(label), "%s: %.0f  (peak %.0f)",
+                 get_cpu_sched_counter_name(counter), get_cpu_sched_counter(counter), peak);
+    }
+    if (counter == CPU_SCHED_RUNNING && get_cpu_sched_counter(CPU_SCHED_BLOCKED) > get_cpu_threads()) {
+        gdk_cairo_set_source_rgba(cr, &alert_color);
+    } else {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+    }
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 11);
+    cairo_move_to(cr, 5, 13);
+    cairo_show_text(cr, label);
+}
+
+/* One autoscaled row per counter: a fork storm or a pile of D-state tasks
+ * stands out even when CPU usage looks normal */
+static GtkWidget* create_sched_graphs(void) {
+    static const CpuSchedCounter rows[] = { CPU_SCHED_CTXT, CPU_SCHED_INTR, CPU_SCHED_FORKS,
+                                            CPU_SCHED_RUNNING, CPU_SCHED_LOAD1 };
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_box_set_homogeneous(GTK_BOX(box), TRUE);
+    for (gsize r = 0; r < G_N_ELEMENTS(rows); r++) {
+        CpuSchedCounter counter = rows[r];
+        KhosGraph *graph = KHOS_GRAPH(khos_graph_new(MAX_POINTS));
+        khos_graph_add_series(graph, NULL, KHOS_GRAPH_GRADIENT, 1.5);
+        khos_graph_set_series_history(graph, 0, get_cpu_sched_counter_history(counter));
+        if (counter == CPU_SCHED_RUNNING) {
+            // Runnable and blocked tasks share a scale
+            khos_graph_add_series(graph, &alert_color, KHOS_GRAPH_LINE, 1.5);
+            khos_graph_set_series_history(graph, 1, get_cpu_sched_counter_history(CPU_SCHED_BLOCKED));
+        }
+        // At least 10 events or tasks (1 for the load) so a quiet row is not all noise
+        khos_graph_set_autoscale(graph, counter == CPU_SCHED_LOAD1 ? 1.0 : 10.0, 1.0);
+        khos_graph_set_overlay_func(graph, draw_sched_label, GINT_TO_POINTER(counter), 18);
+        gtk_box_pack_start(GTK_BOX(box), GTK_WIDGET(graph), TRUE, TRUE, 0);
+    }
+    return box;
+}
+
+/* Shallow idle states light, deep ones dark */
+static void get_idle_state_color(gint state, GdkRGBA *color) {
+    static const GdkRGBA ramp[] = {
+        { 153 / 255.0, 193 / 255.0, 241 / 255.0, 1.0 },
+        { 98 / 255.0, 160 / 255.0, 234 / 255.0, 1.0 },
+        { 53 / 255.0, 132 / 255.0, 228 / 255.0, 1.0 },
+        { 28 / 255.0, 113 / 255.0, 216 / 255.0, 1.0 },
+        { 26 / 255.0, 95 / 255.0, 180 / 255.0, 1.0 },
+        { 21 / 255.0, 73 / 255.0, 140 / 255.0, 1.0 },
+    };
+    *color = ramp[MIN(state, (gint)G_N_ELEMENTS(ramp) - 1)];
+}
+
+// Residency of each idle state of @cpu as stacked segments; the rest is time awake
+static void draw_idle_bar(cairo_t *cr, double x, double y, double w, double h, gint cpu, gboolean vertical) {
+    double offset = 0.0;
+    for (gint s = cpu_idle_get_state_count() - 1; s >= 0; s--) {
+        double share = cpu_idle_get_residency(cpu, s) / 100.0;
+        if (share <= 0.0) continue;
+        GdkRGBA color;
+        get_idle_state_color(s, &color);
+        gdk_cairo_set_source_rgba(cr, &color);
+        // Deepest state at the bottom (vertical) or right (horizontal)
+        if (vertical) cairo_rectangle(cr, x, y + h - (offset + share) * h, w, share * h);
+        else cairo_rectangle(cr, x + w - (offset + share) * w, y, share * w, h);
+        cairo_fill(cr);
+        offset += share;
+    }
+}
+
+static gboolean draw_idle_states(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(widget, &bg_color, &fg_color, &accent_color, NULL);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    graph_draw_background(cr, width, height, &bg_color);
+    cairo_set_font_size(cr, 10);
+
+    if (!cpu_idle_available()) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, "cpuidle is not available (no idle driver, or running in a VM)");
+        return FALSE;
+    }
+
+    // Legend
+    double x = 5;
+    for (gint s = 0; s < cpu_idle_get_state_count(); s++) {
+        GdkRGBA color;
+        get_idle_state_color(s, &color);
+        gdk_cairo_set_source_rgba(cr, &color);
+        cairo_rectangle(cr, x, 4, 10, 10);
+        cairo_fill(cr);
+        cairo_text_extents_t ext;
+        cairo_text_extents(cr, cpu_idle_get_state_name(s), &ext);
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+        cairo_move_to(cr, x + 14, 13);
+        cairo_show_text(cr, cpu_idle_get_state_name(s));
+        x += 14 + ext.x_advance + 12;
+    }
+
+    // One bar per CPU, deepest state on the right; the empty part is time awake
+    gint num_cores = get_cpu_threads();
+    double top = 20;
+    double row_h = MAX(2.0, MIN(16.0, (height - top) / MAX(1, num_cores)));
+    for (gint cpu = 0; cpu < num_cores && top + (cpu + 1) * row_h <= height; cpu++) {
+        double y = top + cpu * row_h;
+        if (row_h >= 10) {
+            char label[16];
+            snprintf(label, sizeof(label), "CPU %d", cpu);
+            cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+            cairo_move_to(cr, 5, y + row_h - 3);
+            cairo_show_text(cr, label);
+        }
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.1);
+        cairo_rectangle(cr, 60, y, width - 65, row_h - 1);
+        cairo_fill(cr);
+        draw_idle_bar(cr, 60, y, width - 65, row_h - 1, cpu, FALSE);
+    }
+    return FALSE;
+}
+
+static void get_perf_label(gint index, gchar *buf, gsize buf_size) {
+    const CpuPerfSample *perf = cpu_perf_get_sample(index);
+    if (!perf) snprintf(buf, buf_size, "CPU %d: N/A", index);
+    else if (cpu_perf_get_mode() == CPU_PERF_HARDWARE)
+        snprintf(buf, buf_size, "CPU %d: IPC %.2f, LLC %.1f/k, br %.1f/k", index, perf->ipc, perf->llc_mpki, perf->branch_mpki);
+    else
+        snprintf(buf, buf_size, "CPU %d: %.0f%%, %.0f cs/s, %.0f pf/s", index, perf->busy_percent, perf->ctx_switches, perf->page_faults);
+}
+
+static gboolean draw_perf_graphs(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(widget, &bg_color, &fg_color, &accent_color, NULL);
+    graph_draw_background(cr, gtk_widget_get_allocated_width(widget), gtk_widget_get_allocated_height(widget), &bg_color);
+
+    if (cpu_perf_get_mode() == CPU_PERF_OFF) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, "Performance counters are off; enable them from the usage graph's right-click menu");
+        return FALSE;
+    }
+
+    // Hardware: 100% is an IPC of CPU_PERF_IPC_SCALE; software: task-clock busy share
+    graph_draw_per_core_graphs(cr, widget, get_cpu_threads(),
+                               cpu_perf_get_history,
+                               cpu_perf_get_history_index,
+                               cpu_perf_get_sample_count,
+                               get_perf_label,
+                               &bg_color, &fg_color, &accent_color, MAX_POINTS);
+    return FALSE;
+}
+
+/* Packages keep the theme accent; their subzones cycle through these */
+static const GdkRGBA *get_power_domain_color(gint domain, const GdkRGBA *accent) {
+    static const GdkRGBA subzone_colors[] = {
+        { 230 / 255.0, 97 / 255.0, 0.0, 1.0 },
+        { 51 / 255.0, 209 / 255.0, 122 / 255.0, 1.0 },
+        { 145 / 255.0, 65 / 255.0, 172 / 255.0, 1.0 },
+        { 246 / 255.0, 211 / 255.0, 45 / 255.0, 1.0 },
+    };
+    if (cpu_rapl_is_package(domain)) return accent;
+    gint subzone = 0;
+    for (gint d = 0; d < domain; d++) {
+        if (!cpu_rapl_is_package(d)) subzone++;
+    }
+    return &subzone_colors[subzone % G_N_ELEMENTS(subzone_colors)];
+}
+
+static void draw_power_legend(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, &accent_color, NULL);
+    cairo_set_font_size(cr, 10);
+
+    gint count = cpu_rapl_get_domain_count();
+    if (count == 0) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, cpu_rapl_permission_denied()
+                            ? "RAPL energy counters are only readable by root on this kernel"
+                            : "RAPL is not available (no intel-rapl powercap zones)");
+        return;
+    }
+
+    double x = 5;
+    for (gint d = 0; d < count; d++) {
+        char label[64];
+        snprintf(label, sizeof(label), "%s %.1f W", cpu_rapl_get_domain_name(d), cpu_rapl_get_watts(d));
+        cairo_text_extents_t ext;
+        cairo_text_extents(cr, label, &ext);
+        gdk_cairo_set_source_rgba(cr, get_power_domain_color(d, &accent_color));
+        cairo_rectangle(cr, x, 4, 10, 10);
+        cairo_fill(cr);
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+        cairo_move_to(cr, x + 14, 13);
+        cairo_show_text(cr, label);
+        x += 14 + ext.x_advance + 12;
+    }
+
+    char scale[32];
+    snprintf(scale, sizeof(scale), "%.0f W", khos_graph_get_axis_max(graph));
+    cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+    cairo_move_to(cr, 5, 27);
+    cairo_show_text(cr, scale);
+}
+
+/* Every RAPL zone on one watt scale: packages filled, their core/uncore/DRAM
+ * subzones as lines, so the split of package power is visible at a glance */
+static GtkWidget* create_power_graph(void) {
+    KhosGraph *graph = KHOS_GRAPH(khos_graph_new(MAX_POINTS));
+    for (gint d = 0; d < cpu_rapl_get_domain_count(); d++) {
+        gboolean is_package = cpu_rapl_is_package(d);
+        // NULL follows the theme accent
+        khos_graph_add_series(graph, get_power_domain_color(d, NULL),
+                              is_package ? KHOS_GRAPH_GRADIENT : KHOS_GRAPH_LINE, 1.5);
+        khos_graph_set_series_history(graph, d, cpu_rapl_get_history(d));
+    }
+    khos_graph_set_autoscale(graph, 1.0, 1.0);
+    // The legend's watts change every tick; the axis label only with the scale
+    khos_graph_set_overlay_func(graph, draw_power_legend, NULL, 18);
+    return GTK_WIDGET(graph);
+}
+
+static void get_runqueue_label(gint index, gchar *buf, gsize buf_size) {
+    snprintf(buf, buf_size, "CPU %d: %.1f ms/s", index, get_cpu_runqueue_wait_by_core(index));
+}
+
+static gboolean draw_runqueue_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    // Orange like the disk graph, whatever the theme accent
+    GdkRGBA bg_color, fg_color, accent_color = runqueue_color;
+    graph_get_theme_colors(widget, &bg_color, &fg_color, NULL, NULL);
+    graph_draw_background(cr, gtk_widget_get_allocated_width(widget), gtk_widget_get_allocated_height(widget), &bg_color);
+
+    if (!get_cpu_runqueue_available()) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, "/proc/schedstat is not available (kernel built without CONFIG_SCHEDSTATS)");
+        return FALSE;
+    }
+
+    // 100% of the graph height means one task waiting the whole time
+    graph_draw_per_core_graphs(cr, widget, get_cpu_threads(),
+                               get_cpu_runqueue_history_by_core,
+                               get_cpu_usage_history_index,
+                               get_cpu_sample_count,
+                               get_runqueue_label,
+                               &bg_color, &fg_color, &accent_color, MAX_POINTS);
+    return FALSE;
+}
+
+/* Band colors for the CPU states; user time keeps the theme accent */
+static void get_cpu_state_colors(const GdkRGBA *accent, GdkRGBA colors[CPU_N_STATES]) {
+    static const GdkRGBA fixed[CPU_N_STATES] = {
+        { 0 },                                          // user
+        { 224 / 255.0, 27 / 255.0, 36 / 255.0, 1.0 },   // system
+        { 246 / 255.0, 211 / 255.0, 45 / 255.0, 1.0 },  // iowait
+        { 145 / 255.0, 65 / 255.0, 172 / 255.0, 1.0 },  // irq
+        { 192 / 255.0, 97 / 255.0, 203 / 255.0, 1.0 },  // softirq
+        { 230 / 255.0, 97 / 255.0, 0.0, 1.0 },          // steal
+        { 51 / 255.0, 209 / 255.0, 122 / 255.0, 1.0 },  // guest
+    };
+    for (gint s = 0; s < CPU_N_STATES; s++) {
+        colors[s] = s == CPU_STATE_USER ? *accent : fixed[s];
+    }
+}
+
+// Stacked CPU states of one core, or of the whole system for @core_id -1
+static void draw_cpu_states(cairo_t *cr, int width, int height, gint core_id, const GdkRGBA *colors) {
+    const gdouble *series[CPU_N_STATES];
+    for (gint s = 0; s < CPU_N_STATES; s++) series[s] = get_cpu_state_history(core_id, s);
+    graph_draw_stacked(cr, width, height, series, colors, CPU_N_STATES,
+                       get_cpu_usage_history_index(), MAX_POINTS);
+}
+
+static void draw_cpu_state_legend(cairo_t *cr, int width, const GdkRGBA *colors, const GdkRGBA *fg_color) {
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 11);
+    double x = 8;
+    for (gint s = 0; s < CPU_N_STATES; s++) {
+        char label[32];
+        snprintf(label, sizeof(label), "%s %.1f%%", get_cpu_state_name(s), get_cpu_state_percent(-1, s));
+        cairo_text_extents_t ext;
+        cairo_text_extents(cr, label, &ext);
+        if (x + 14 + ext.x_advance > width) break;
+
+        gdk_cairo_set_source_rgba(cr, &colors[s]);
+        cairo_rectangle(cr, x, 7, 10, 10);
+        cairo_fill(cr);
+        cairo_set_source_rgba(cr, fg_color->red, fg_color->green, fg_color->blue, 0.9);
+        cairo_move_to(cr, x + 14, 16);
+        cairo_show_text(cr, label);
+        x += 14 + ext.x_advance + 12;
+    }
+}
+
+// Combined graph: stacked states under the KhosGraph's total usage line
+static void plot_cpu_states(cairo_t *cr, int width, int height, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(GTK_WIDGET(data), &bg_color, &fg_color, &accent_color, NULL);
+    GdkRGBA state_colors[CPU_N_STATES];
+    get_cpu_state_colors(&accent_color, state_colors);
+    draw_cpu_states(cr, width, height, -1, state_colors);
+}
+
+static void draw_cpu_graph_legend(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer data) {
+    GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, &accent_color, NULL);
+    GdkRGBA state_colors[CPU_N_STATES];
+    get_cpu_state_colors(&accent_color, state_colors);
+    draw_cpu_state_legend(cr, width, state_colors, &fg_color);
+}
+
+// Per-core view; the combined view is left to the KhosGraph class handler
 static gboolean draw_cpu_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    if (!get_show_per_cpu_graphs()) return FALSE;
+
     GtkAllocation allocation;
     gtk_widget_get_allocation(widget, &allocation);
     int width = allocation.width, height = allocation.height;
     
-    GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
     GdkRGBA bg_color, fg_color, accent_color;
+    graph_get_theme_colors(widget, &bg_color, &fg_color, &accent_color, NULL);
 
-    gdk_rgba_parse(&bg_color, "rgb(24, 25, 26)");
-    gdk_rgba_parse(&fg_color, "rgb(238, 238, 236)");
-    gdk_rgba_parse(&accent_color, "rgb(53, 132, 228)");
-
-    gtk_style_context_lookup_color(style_context, "theme_bg_color", &bg_color);
-    gtk_style_context_lookup_color(style_context, "theme_fg_color", &fg_color);
-    gtk_style_context_lookup_color(style_context, "theme_selected_bg_color", &accent_color);
-
-    gdk_cairo_set_source_rgba(cr, &bg_color);
-    cairo_paint(cr);
-
-    GdkRGBA grid_color = fg_color;
-    grid_color.alpha = 0.2;
+    GdkRGBA state_colors[CPU_N_STATES];
+    get_cpu_state_colors(&accent_color, state_colors);
     
-    if (get_show_per_cpu_graphs()) {
+    graph_draw_background(cr, width, height, &bg_color);
+
+    if (graph_per_core_use_heatmap(widget, get_cpu_threads())) {
+        // Many cores: one row per CPU; hover a row for the details
+        graph_draw_per_core_heatmap(cr, widget, get_cpu_threads(),
+                                    get_cpu_usage_history_by_core, get_cpu_usage_history_index,
+                                    get_cpu_sample_count,
+                                    &bg_color, &fg_color, &accent_color, MAX_POINTS);
+    } else {
         int num_cores = get_cpu_threads();
-        int rows = (num_cores + 1) / 2;  // Ceiling division
-        int cols = (num_cores > 1) ? 2 : 1;
-        
-        int graph_width = width / cols;
-        int graph_height = height / rows;
         
         for (int i = 0; i < num_cores; i++) {
-            int row = i / cols;
-            int col = i % cols;
+            // Cells follow the topology: grouped by node, SMT siblings side by side
+            GdkRectangle cell;
+            if (!graph_per_core_cell(widget, num_cores, i, &cell)) continue;
+            int graph_width = cell.width;
+            int graph_height = cell.height;
             
             // Save the current state
             cairo_save(cr);
             
             // Translate to the position of this CPU's graph
-            cairo_translate(cr, col * graph_width, row * graph_height);
+            cairo_translate(cr, cell.x, cell.y);
             
-            gdk_cairo_set_source_rgba(cr, &grid_color);
-            cairo_set_line_width(cr, 0.8);
-            for (int j = 1; j < 4; j++) {
-                double y = graph_height * j / 4.0;
-                cairo_move_to(cr, 0, y);
-                cairo_line_to(cr, graph_width, y);
-            }
-            cairo_stroke(cr);
+            graph_draw_grid(cr, graph_width, graph_height, &fg_color);
             
             const gdouble* history = get_cpu_usage_history_by_core(i);
             if (history) {
                 gint history_idx = get_cpu_usage_history_index();
-                
-                cairo_pattern_t *fill = cairo_pattern_create_linear(0, 0, 0, graph_height);
-                cairo_pattern_add_color_stop_rgba(fill, 0, accent_color.red, accent_color.green, accent_color.blue, 0.7);
-                cairo_pattern_add_color_stop_rgba(fill, 1, accent_color.red, accent_color.green, accent_color.blue, 0.1);
-                cairo_set_source(cr, fill);
-                
-                cairo_move_to(cr, 0, graph_height);
-                for (int j = 0; j < MAX_POINTS; j++) {
-                    int idx = (history_idx + j) % MAX_POINTS;
-                    double x = (double)j / (MAX_POINTS - 1) * graph_width;
-                    double y = graph_height - (history[idx] / 100.0 * graph_height);
-                    cairo_line_to(cr, x, y);
-                }
-                cairo_line_to(cr, graph_width, graph_height);
-                cairo_close_path(cr);
-                cairo_fill(cr);
-                cairo_pattern_destroy(fill);
-                
-                cairo_set_source_rgba(cr, accent_color.red, accent_color.green, accent_color.blue, 0.9);
-                cairo_set_line_width(cr, 2.0);
-                for (int j = 0; j < MAX_POINTS; j++) {
-                    int idx = (history_idx + j) % MAX_POINTS;
-                    double x = (double)j / (MAX_POINTS - 1) * graph_width;
-                    double y = graph_height - (history[idx] / 100.0 * graph_height);
-                    if (j == 0) cairo_move_to(cr, x, y);
-                    else cairo_line_to(cr, x, y);
+                draw_cpu_states(cr, graph_width, graph_height, i, state_colors);
+                graph_draw_line(cr, graph_width, graph_height, history, history_idx, MAX_POINTS, &accent_color, 2.0);
+
+                // Frequency as a share of the maximum, so "slow but idle" is visible next to usage
+                const gdouble *freq_history = cpu_freq_get_history(i);
+                if (freq_history && cpu_freq_get_mhz(i) > 0) {
+                    gint freq_idx = cpu_freq_get_history_index();
+                    static const double dash[] = { 4.0, 3.0 };
+                    cairo_set_dash(cr, dash, G_N_ELEMENTS(dash), 0);
+                    cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.6);
+                    cairo_set_line_width(cr, 1.0);
+                    for (int j = 0; j < MAX_POINTS; j++) {
+                        int idx = (freq_idx + j) % MAX_POINTS;
+                        double x = (double)j / (MAX_POINTS - 1) * graph_width;
+                        double y = graph_height - (freq_history[idx] / 100.0 * graph_height);
+                        if (j == 0) cairo_move_to(cr, x, y);
+                        else cairo_line_to(cr, x, y);
+                    }
+                    cairo_stroke(cr);
+                    cairo_set_dash(cr, NULL, 0, 0);
                 }
-                cairo_stroke(cr);
+            }
+
+            // Idle-state residency strip along the right edge
+            if (cpu_idle_available() && graph_width > 60) {
+                draw_idle_bar(cr, graph_width - 6, 0, 6, graph_height, i, TRUE);
             }
             
             // Draw CPU number label
@@ -357,56 +1121,42 @@ static gboolean draw_cpu_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
             cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
             cairo_set_font_size(cr, 12);
             
-            char cpu_label[32];
-            snprintf(cpu_label, sizeof(cpu_label), "CPU %d: %.1f%%", i, get_cpu_usage_by_core(i));
+            char cpu_label[64];
+            const CpuPerfSample *perf = cpu_perf_get_mode() == CPU_PERF_HARDWARE ? cpu_perf_get_sample(i) : NULL;
+            if (perf) {
+                // A busy core with a low IPC is stalled on memory rather than computing
+                snprintf(cpu_label, sizeof(cpu_label), "CPU %d: %.1f%% IPC %.2f", i,
+                         get_cpu_usage_by_core(i), perf->ipc);
+            } else if (cpu_freq_get_mhz(i) > 0) {
+                snprintf(cpu_label, sizeof(cpu_label), "CPU %d: %.1f%% @ %.2f GHz", i,
+                         get_cpu_usage_by_core(i), cpu_freq_get_mhz(i) / 1000.0);
+            } else {
+                snprintf(cpu_label, sizeof(cpu_label), "CPU %d: %.1f%%", i, get_cpu_usage_by_core(i));
+            }
             
             cairo_move_to(cr, 5, 15);
             cairo_show_text(cr, cpu_label);
+            if (cpu_freq_is_throttling(i)) {
+                cairo_set_source_rgba(cr, 0.88, 0.11, 0.14, 1.0);
+                cairo_show_text(cr, " throttled");
+            }
+
+            const CpuCoreProcess *top = NULL;
+            if (get_cpu_core_top_processes(i, &top) > 0 && graph_height > 40) {
+                char top_label[64];
+                snprintf(top_label, sizeof(top_label), "%s %.0f%%", top[0].name, top[0].core_percent);
+                cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+                cairo_set_font_size(cr, 10);
+                cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+                cairo_move_to(cr, 5, 29);
+                cairo_show_text(cr, top_label);
+            }
             
             // Restore the saved state
             cairo_restore(cr);
         }
-    } else {
-        gdk_cairo_set_source_rgba(cr, &grid_color);
-        cairo_set_line_width(cr, 0.8);
-        for (int i = 1; i < 4; i++) {
-            double y = height * i / 4.0;
-            cairo_move_to(cr, 0, y);
-            cairo_line_to(cr, width, y);
-        }
-        cairo_stroke(cr);
-        
-        const gdouble* history = get_cpu_usage_history();
-        gint history_idx = get_cpu_usage_history_index();
-        
-        cairo_pattern_t *fill = cairo_pattern_create_linear(0, 0, 0, height);
-        cairo_pattern_add_color_stop_rgba(fill, 0, accent_color.red, accent_color.green, accent_color.blue, 0.7);
-        cairo_pattern_add_color_stop_rgba(fill, 1, accent_color.red, accent_color.green, accent_color.blue, 0.1);
-        cairo_set_source(cr, fill);
-
-        cairo_move_to(cr, 0, height);
-        for (int i = 0; i < MAX_POINTS; i++) {
-            int idx = (history_idx + i) % MAX_POINTS;
-            double x = (double)i / (MAX_POINTS - 1) * width;
-            double y = height - (history[idx] / 100.0 * height);
-            cairo_line_to(cr, x, y);
-        }
-        cairo_line_to(cr, width, height);
-        cairo_close_path(cr);
-        cairo_fill(cr);
-        cairo_pattern_destroy(fill);
-
-        cairo_set_source_rgba(cr, accent_color.red, accent_color.green, accent_color.blue, 0.9);
-        cairo_set_line_width(cr, 2.5);
-        for (int i = 0; i < MAX_POINTS; i++) {
-            int idx = (history_idx + i) % MAX_POINTS;
-            double x = (double)i / (MAX_POINTS - 1) * width;
-            double y = height - (history[idx] / 100.0 * height);
-            if (i == 0) cairo_move_to(cr, x, y);
-            else cairo_line_to(cr, x, y);
-        }
-        cairo_stroke(cr);
+        graph_draw_per_core_headers(cr, widget, num_cores, get_group_header_label, &fg_color);
     }
 
-    return FALSE;
+    return TRUE;
 }
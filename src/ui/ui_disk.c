@@ -1,13 +1,15 @@
 #include "ui/ui_disk.h"
 #include "disk/disk_data.h"
+#include "ui/khos_graph.h"
 #include <cairo.h>
 #include <math.h>
 
-static gboolean draw_disk_graph(GtkWidget *widget, cairo_t *cr, gpointer data);
 static gboolean update_disk_widgets(gpointer user_data);
 static gboolean on_disk_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 static void on_disk_combo_changed(GtkComboBox *widget, gpointer user_data);
 
+static const GdkRGBA disk_color = { 230 / 255.0, 97 / 255.0, 0.0, 1.0 };   // Orange for disk
+
 typedef struct {
     GtkWidget *drawing_area;
     GtkWidget *disk_activity_label;
@@ -115,96 +117,15 @@ static gboolean update_disk_widgets(gpointer user_data) {
     }
     }
     
-    g_print("Queueing redraw of drawing area\n");
-    gtk_widget_queue_draw(data->drawing_area);
+    // Selecting another disk swaps the plotted history, which rebuilds the graph
+    KhosGraph *graph = KHOS_GRAPH(data->drawing_area);
+    gboolean valid = data->selected_disk_index >= 0 && data->selected_disk_index < get_disk_count();
+    khos_graph_set_series_history(graph, 0, valid ? get_disk_activity_history(data->selected_disk_index) : NULL);
+    if (valid) khos_graph_push(graph, get_disk_activity_history_index(data->selected_disk_index));
     g_print("update_disk_widgets complete\n");
     return G_SOURCE_CONTINUE;
 }
 
-static gboolean draw_disk_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
-    g_print("draw_disk_graph called\n");
-    DiskUpdateData *update_data = (DiskUpdateData*)data;
-    if (!update_data) {
-        g_print("ERROR: update_data is NULL\n");
-        return FALSE;
-    }
-    
-    GtkAllocation allocation;
-    gtk_widget_get_allocation(widget, &allocation);
-    int width = allocation.width, height = allocation.height;
-    g_print("Graph dimensions: %d x %d\n", width, height);
-    
-    GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
-    GdkRGBA bg_color, fg_color, accent_color;
-
-    gdk_rgba_parse(&bg_color, "rgb(24, 25, 26)");
-    gdk_rgba_parse(&fg_color, "rgb(238, 238, 236)");
-    gdk_rgba_parse(&accent_color, "rgb(230, 97, 0)"); // Orange for disk
-
-    gtk_style_context_lookup_color(style_context, "theme_bg_color", &bg_color);
-    gtk_style_context_lookup_color(style_context, "theme_fg_color", &fg_color);
-
-    g_print("Drawing background\n");
-    gdk_cairo_set_source_rgba(cr, &bg_color);
-    cairo_paint(cr);
-
-    g_print("Drawing grid lines\n");
-    GdkRGBA grid_color = fg_color;
-    grid_color.alpha = 0.2;
-    gdk_cairo_set_source_rgba(cr, &grid_color);
-    cairo_set_line_width(cr, 0.8);
-
-    for (int i = 1; i < 4; i++) {
-        double y = height * i / 4.0;
-        cairo_move_to(cr, 0, y);
-        cairo_line_to(cr, width, y);
-    }
-    cairo_stroke(cr);
-    
-    gint disk_count = get_disk_count();
-    if (update_data->selected_disk_index >= 0 && update_data->selected_disk_index < disk_count) {
-        g_print("Getting disk activity history\n");
-        const gdouble* history = get_disk_activity_history(update_data->selected_disk_index);
-        gint history_idx = get_disk_activity_history_index(update_data->selected_disk_index);
-        
-        if (history) {
-            g_print("Creating gradient fill\n");
-            cairo_pattern_t *fill = cairo_pattern_create_linear(0, 0, 0, height);
-            cairo_pattern_add_color_stop_rgba(fill, 0, accent_color.red, accent_color.green, accent_color.blue, 0.7);
-            cairo_pattern_add_color_stop_rgba(fill, 1, accent_color.red, accent_color.green, accent_color.blue, 0.1);
-            cairo_set_source(cr, fill);
-
-            g_print("Drawing graph fill\n");
-            cairo_move_to(cr, 0, height);
-            for (int i = 0; i < MAX_POINTS; i++) {
-                int idx = (history_idx + i) % MAX_POINTS;
-                double x = (double)i / (MAX_POINTS - 1) * width;
-                double y = height - (history[idx] / 100.0 * height);
-                cairo_line_to(cr, x, y);
-            }
-            cairo_line_to(cr, width, height);
-            cairo_close_path(cr);
-            cairo_fill(cr);
-            cairo_pattern_destroy(fill);
-
-            g_print("Drawing graph line\n");
-            cairo_set_source_rgba(cr, accent_color.red, accent_color.green, accent_color.blue, 0.9);
-            cairo_set_line_width(cr, 2.5);
-            for (int i = 0; i < MAX_POINTS; i++) {
-                int idx = (history_idx + i) % MAX_POINTS;
-                double x = (double)i / (MAX_POINTS - 1) * width;
-                double y = height - (history[idx] / 100.0 * height);
-                if (i == 0) cairo_move_to(cr, x, y);
-                else cairo_line_to(cr, x, y);
-            }
-            cairo_stroke(cr);
-        }
-    }
-
-    g_print("draw_disk_graph complete\n");
-    return FALSE;
-}
-
 static gboolean on_disk_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
     if (event->button == 3) { // Right mouse button
         GtkWidget *menu = GTK_WIDGET(user_data);
@@ -256,10 +177,11 @@ GtkWidget* create_disk_tab(void) {
     gtk_box_pack_start(GTK_BOX(combo_box), combo_label, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(combo_box), combo, TRUE, TRUE, 0);
     
-    GtkWidget *drawing_area = gtk_drawing_area_new();
+    GtkWidget *drawing_area = khos_graph_new(MAX_POINTS);
     gtk_widget_set_size_request(drawing_area, -1, 250);
     gtk_widget_set_hexpand(drawing_area, TRUE);
     gtk_widget_set_vexpand(drawing_area, TRUE);
+    khos_graph_add_series(KHOS_GRAPH(drawing_area), &disk_color, KHOS_GRAPH_GRADIENT, 2.5);
 
     GtkWidget *graph_frame = gtk_frame_new(NULL);
     gtk_frame_set_shadow_type(GTK_FRAME(graph_frame), GTK_SHADOW_ETCHED_IN);
@@ -349,7 +271,6 @@ GtkWidget* create_disk_tab(void) {
     data->selected_disk_index = 0;
     data->update_interval = 2000;  // 2 seconds
     
-    g_signal_connect(G_OBJECT(drawing_area), "draw", G_CALLBACK(draw_disk_graph), data);
     g_signal_connect(G_OBJECT(combo), "changed", G_CALLBACK(on_disk_combo_changed), data);
     g_signal_connect(G_OBJECT(drawing_area), "button-press-event", G_CALLBACK(on_disk_tab_button_press), data);
     
@@ -1,9 +1,10 @@
 #include "ui/ui_gpu.h"
 #include "gpu/gpu_data.h"
+#include "gpu/gpu_fdinfo.h"
+#include "ui/khos_graph.h"
 #include <cairo.h>
 #include <math.h>
 
-static gboolean draw_filled_graph(GtkWidget *widget, cairo_t *cr, gpointer user_data);
 static gboolean update_gpu_widgets(gpointer user_data);
 static gboolean on_gpu_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 
@@ -19,8 +20,20 @@ typedef struct {
     guint update_interval;
     guint timeout_id;
     gint gpu_index;  // Index of the GPU this data belongs to
+    GtkListStore *top_store;  // Heaviest processes on this GPU (from DRM fdinfo)
 } GpuUpdateData;
 
+#define GPU_TOP_CONSUMERS 8
+
+enum {
+    TOP_COL_NAME,
+    TOP_COL_PID,
+    TOP_COL_BUSY,
+    TOP_COL_ENGINE,
+    TOP_COL_VRAM,
+    N_TOP_COLUMNS
+};
+
 static void cleanup_gpu_update_data(gpointer data) {
     if (!data) return;
     
@@ -31,77 +44,39 @@ static void cleanup_gpu_update_data(gpointer data) {
         update_data->timeout_id = 0;
     }
     
+    g_clear_object(&update_data->top_store);
     g_free(update_data);
 }
 
 //---------------------------------------------------------------------------
-static gboolean draw_filled_graph(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+static const GdkRGBA usage_color = { 52 / 255.0, 101 / 255.0, 164 / 255.0, 1.0 };
+static const GdkRGBA vram_color = { 233 / 255.0, 185 / 255.0, 110 / 255.0, 1.0 };
+
+static void draw_gpu_legend(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer user_data) {
     GpuUpdateData *data = (GpuUpdateData*)user_data;
-    if (!data) return FALSE;
-    GtkAllocation allocation; gtk_widget_get_allocation(widget, &allocation);
-    int width = allocation.width, height = allocation.height;
-
-    // Colors similar to CPU graph
-    GdkRGBA bg_color; gdk_rgba_parse(&bg_color, "rgb(24,25,26)");
-    GdkRGBA fg_color; gdk_rgba_parse(&fg_color, "rgb(238,238,236)");
-    GdkRGBA usage_color; gdk_rgba_parse(&usage_color, "rgb(52,101,164)");
-    GdkRGBA vram_color; gdk_rgba_parse(&vram_color, "rgb(233,185,110)");
-
-    GtkStyleContext *context = gtk_widget_get_style_context(widget);
-    gtk_style_context_lookup_color(context, "theme_bg_color", &bg_color);
-    gtk_style_context_lookup_color(context, "theme_fg_color", &fg_color);
-
-    gdk_cairo_set_source_rgba(cr, &bg_color);
-    cairo_paint(cr);
-
-    // grid lines (like CPU)
-    GdkRGBA grid_color = fg_color; grid_color.alpha = 0.2;
-    gdk_cairo_set_source_rgba(cr, &grid_color);
-    cairo_set_line_width(cr, 0.8);
-    for (int i=1;i<4;i++) { double y = height * i / 4.0; cairo_move_to(cr,0,y); cairo_line_to(cr,width,y);} cairo_stroke(cr);
-
-    gboolean is_gpu_graph = (widget == data->gpu_area);
-    
-    // Get GPU info for this specific GPU
-    const GPUInfo *gpu_info = gpu_get_info(data->gpu_index);
-    if (!gpu_info) return FALSE;
-    
-    const gdouble *hist = is_gpu_graph ? gpu_info->usage_history : gpu_info->vram_history;
-    gint idx = gpu_info->history_index;
-
-    // find max for scaling
-    gdouble max_val = 100.0; // percentages
-
-    // Choose color
-    GdkRGBA col = is_gpu_graph ? usage_color : vram_color;
-    // Build filled area path
-    cairo_set_source_rgba(cr, col.red, col.green, col.blue, 0.3);
-    cairo_move_to(cr, 0, height);
-    for (int i=0;i<GPU_MAX_POINTS;i++) {
-        int h=(idx+i)%GPU_MAX_POINTS;
-        double x=(double)i/(GPU_MAX_POINTS-1)*width;
-        double y=height-(hist[h]/max_val*height);
-        cairo_line_to(cr,x,y);
-    }
-    cairo_line_to(cr,width,height);
-    cairo_close_path(cr);
-    cairo_fill(cr);
+    gboolean is_gpu_graph = (GTK_WIDGET(graph) == data->gpu_area);
+    const GdkRGBA *col = is_gpu_graph ? &usage_color : &vram_color;
 
-    // Draw edge line darker
-    cairo_set_source_rgba(cr, col.red, col.green, col.blue, 0.9);
-    cairo_set_line_width(cr,2.0);
-    for(int i=0;i<GPU_MAX_POINTS;i++){
-        int h=(idx+i)%GPU_MAX_POINTS; double x=(double)i/(GPU_MAX_POINTS-1)*width; double y=height-(hist[h]/max_val*height); if(i==0) cairo_move_to(cr,x,y); else cairo_line_to(cr,x,y);} cairo_stroke(cr);
+    GdkRGBA bg_color, fg_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, NULL, NULL);
 
     // Legend title
     cairo_set_line_width(cr,1.0);
-    cairo_set_source_rgba(cr, col.red, col.green, col.blue,0.9);
+    cairo_set_source_rgba(cr, col->red, col->green, col->blue,0.9);
     cairo_rectangle(cr,width-90,10,10,10); cairo_fill(cr);
     cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue,0.9);
     cairo_move_to(cr,width-75,20);
     cairo_show_text(cr, is_gpu_graph?"GPU %":"VRAM %");
+}
 
-    return FALSE;
+static GtkWidget* create_gpu_graph(const GdkRGBA *color, const gdouble *history) {
+    GtkWidget *graph = khos_graph_new(GPU_MAX_POINTS);
+    gtk_widget_set_size_request(graph, -1, 180);
+    gtk_widget_set_hexpand(graph, TRUE);
+    gtk_widget_set_vexpand(graph, TRUE);
+    khos_graph_add_series(KHOS_GRAPH(graph), color, KHOS_GRAPH_AREA, 2.0);
+    khos_graph_set_series_history(KHOS_GRAPH(graph), 0, history);
+    return graph;
 }
 
 static gboolean update_gpu_widgets(gpointer user_data) {
@@ -138,8 +113,28 @@ static gboolean update_gpu_widgets(gpointer user_data) {
     snprintf(buf, sizeof(buf), "%.1f%%", gpu_info->usage_percent);
     gtk_label_set_text(GTK_LABEL(data->usage_value_label), buf);
 
-    gtk_widget_queue_draw(data->gpu_area);
-    gtk_widget_queue_draw(data->vram_area);
+    // Top consumers; with a single GPU we also accept clients we could not match by PCI slot
+    const GpuProcessUsage *top[GPU_TOP_CONSUMERS];
+    const gchar *pdev = (gpu_get_count() > 1) ? gpu_info->pci_slot : NULL;
+    guint n_top = gpu_fdinfo_get_top(pdev, top, GPU_TOP_CONSUMERS);
+    gtk_list_store_clear(data->top_store);
+    for (guint i = 0; i < n_top; i++) {
+        char busy_str[16], vram_str[32];
+        snprintf(busy_str, sizeof(busy_str), "%.1f%%", top[i]->busy_percent);
+        snprintf(vram_str, sizeof(vram_str), "%.1f MB", top[i]->vram_bytes / (1024.0 * 1024.0));
+        GtkTreeIter iter;
+        gtk_list_store_append(data->top_store, &iter);
+        gtk_list_store_set(data->top_store, &iter,
+                           TOP_COL_NAME, top[i]->comm,
+                           TOP_COL_PID, top[i]->pid,
+                           TOP_COL_BUSY, busy_str,
+                           TOP_COL_ENGINE, top[i]->busy_engine,
+                           TOP_COL_VRAM, vram_str,
+                           -1);
+    }
+
+    khos_graph_push(KHOS_GRAPH(data->gpu_area), gpu_info->history_index);
+    khos_graph_push(KHOS_GRAPH(data->vram_area), gpu_info->history_index);
     return G_SOURCE_CONTINUE;
 }
 
@@ -196,18 +191,12 @@ static GtkWidget* create_single_gpu_tab(gint gpu_index) {
     gtk_grid_set_column_spacing(GTK_GRID(main_grid), 20);
     gtk_grid_set_row_spacing(GTK_GRID(main_grid), 10);
 
-    GtkWidget *usage_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(usage_area, -1, 180);
-    gtk_widget_set_hexpand(usage_area, TRUE);
-    gtk_widget_set_vexpand(usage_area, TRUE);
+    GtkWidget *usage_area = create_gpu_graph(&usage_color, gpu_info->usage_history);
     GtkWidget *usage_frame = gtk_frame_new("GPU Usage %");
     gtk_frame_set_shadow_type(GTK_FRAME(usage_frame), GTK_SHADOW_ETCHED_IN);
     gtk_container_add(GTK_CONTAINER(usage_frame), usage_area);
 
-    GtkWidget *vram_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(vram_area, -1, 180);
-    gtk_widget_set_hexpand(vram_area, TRUE);
-    gtk_widget_set_vexpand(vram_area, TRUE);
+    GtkWidget *vram_area = create_gpu_graph(&vram_color, gpu_info->vram_history);
     GtkWidget *vram_frame = gtk_frame_new("VRAM %");
     gtk_frame_set_shadow_type(GTK_FRAME(vram_frame), GTK_SHADOW_ETCHED_IN);
     gtk_container_add(GTK_CONTAINER(vram_frame), vram_area);
@@ -270,6 +259,25 @@ static GtkWidget* create_single_gpu_tab(gint gpu_index) {
     gtk_frame_set_shadow_type(GTK_FRAME(spec_frame), GTK_SHADOW_ETCHED_IN);
     gtk_container_add(GTK_CONTAINER(spec_frame), spec_grid);
 
+    // Per-process consumers of this GPU
+    GtkListStore *top_store = gtk_list_store_new(N_TOP_COLUMNS, G_TYPE_STRING, G_TYPE_UINT,
+                                                 G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget *top_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(top_store));
+    const gchar *top_titles[N_TOP_COLUMNS] = { "Process", "PID", "Busy", "Engine", "VRAM" };
+    for (int c = 0; c < N_TOP_COLUMNS; c++) {
+        GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(top_titles[c], renderer, "text", c, NULL);
+        gtk_tree_view_column_set_expand(column, c == TOP_COL_NAME);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(top_view), column);
+    }
+    GtkWidget *top_scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(top_scrolled), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(top_scrolled, -1, 140);
+    gtk_container_add(GTK_CONTAINER(top_scrolled), top_view);
+    GtkWidget *top_frame = gtk_frame_new("Top Consumers");
+    gtk_frame_set_shadow_type(GTK_FRAME(top_frame), GTK_SHADOW_ETCHED_IN);
+    gtk_container_add(GTK_CONTAINER(top_frame), top_scrolled);
+
     GtkWidget *menu = gtk_menu_new();
     GtkWidget *refresh_item = gtk_menu_item_new_with_label("Refresh Period");
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), refresh_item);
@@ -280,6 +288,7 @@ static GtkWidget* create_single_gpu_tab(gint gpu_index) {
     gtk_grid_attach(GTK_GRID(main_grid), usage_frame, 0, 0, 1, 1);
     gtk_grid_attach(GTK_GRID(main_grid), vram_frame, 0, 1, 1, 1);
     gtk_grid_attach(GTK_GRID(main_grid), spec_frame, 1, 0, 1, 2);
+    gtk_grid_attach(GTK_GRID(main_grid), top_frame, 0, 2, 2, 1);
 
     // Update data struct
     GpuUpdateData *data = g_new0(GpuUpdateData, 1);
@@ -293,10 +302,11 @@ static GtkWidget* create_single_gpu_tab(gint gpu_index) {
     data->driver_value = drv_value;
     data->update_interval = 2000;
     data->gpu_index = gpu_index;
+    data->top_store = top_store;
 
-    // Connect the draw signals
-    g_signal_connect(usage_area, "draw", G_CALLBACK(draw_filled_graph), data);
-    g_signal_connect(vram_area, "draw", G_CALLBACK(draw_filled_graph), data);
+    // Legends; the graphs draw themselves
+    khos_graph_set_overlay_func(KHOS_GRAPH(usage_area), draw_gpu_legend, data, 0);
+    khos_graph_set_overlay_func(KHOS_GRAPH(vram_area), draw_gpu_legend, data, 0);
     
     gtk_widget_add_events(vram_area, GDK_BUTTON_PRESS_MASK);
     g_signal_connect(vram_area, "button-press-event", G_CALLBACK(on_gpu_tab_button_press), menu);
@@ -1,13 +1,15 @@
 #include "ui/ui_memory.h"
 #include "memory/memory_data.h"
+#include "ui/khos_graph.h"
 #include <cairo.h>
 #include <math.h>
 
-static gboolean draw_memory_graph(GtkWidget *widget, cairo_t *cr, gpointer data);
-static gboolean draw_swap_graph(GtkWidget *widget, cairo_t *cr, gpointer data);
 static gboolean update_memory_widgets(gpointer user_data);
 static gboolean on_memory_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 
+static const GdkRGBA memory_color = { 76 / 255.0, 175 / 255.0, 80 / 255.0, 1.0 };   // Green for memory
+static const GdkRGBA swap_color = { 66 / 255.0, 135 / 255.0, 245 / 255.0, 1.0 };    // Blue for swap
+
 typedef struct {
     GtkWidget *drawing_area;
     GtkWidget *swap_drawing_area;
@@ -96,158 +98,12 @@ static gboolean update_memory_widgets(gpointer user_data) {
     }
 
     g_print("Queueing redraw of drawing areas\n");
-    gtk_widget_queue_draw(data->drawing_area);
-    gtk_widget_queue_draw(data->swap_drawing_area);
+    khos_graph_push(KHOS_GRAPH(data->drawing_area), get_memory_usage_history_index());
+    khos_graph_push(KHOS_GRAPH(data->swap_drawing_area), get_swap_usage_history_index());
     g_print("update_memory_widgets complete\n");
     return G_SOURCE_CONTINUE;
 }
 
-static gboolean draw_memory_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
-    g_print("draw_memory_graph called\n");
-    GtkAllocation allocation;
-    gtk_widget_get_allocation(widget, &allocation);
-    int width = allocation.width, height = allocation.height;
-    g_print("Graph dimensions: %d x %d\n", width, height);
-    
-    GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
-    GdkRGBA bg_color, fg_color, accent_color;
-
-    gdk_rgba_parse(&bg_color, "rgb(24, 25, 26)");
-    gdk_rgba_parse(&fg_color, "rgb(238, 238, 236)");
-    gdk_rgba_parse(&accent_color, "rgb(76, 175, 80)"); // Green for memory
-
-    gtk_style_context_lookup_color(style_context, "theme_bg_color", &bg_color);
-    gtk_style_context_lookup_color(style_context, "theme_fg_color", &fg_color);
-
-    g_print("Drawing background\n");
-    gdk_cairo_set_source_rgba(cr, &bg_color);
-    cairo_paint(cr);
-
-    g_print("Drawing grid lines\n");
-    GdkRGBA grid_color = fg_color;
-    grid_color.alpha = 0.2;
-    gdk_cairo_set_source_rgba(cr, &grid_color);
-    cairo_set_line_width(cr, 0.8);
-
-    for (int i = 1; i < 4; i++) {
-        double y = height * i / 4.0;
-        cairo_move_to(cr, 0, y);
-        cairo_line_to(cr, width, y);
-    }
-    cairo_stroke(cr);
-    
-    g_print("Getting memory usage history\n");
-    const gdouble* history = get_memory_usage_history();
-    gint history_idx = get_memory_usage_history_index();
-    
-    g_print("Creating gradient fill\n");
-    cairo_pattern_t *fill = cairo_pattern_create_linear(0, 0, 0, height);
-    cairo_pattern_add_color_stop_rgba(fill, 0, accent_color.red, accent_color.green, accent_color.blue, 0.7);
-    cairo_pattern_add_color_stop_rgba(fill, 1, accent_color.red, accent_color.green, accent_color.blue, 0.1);
-    cairo_set_source(cr, fill);
-
-    g_print("Drawing graph fill\n");
-    cairo_move_to(cr, 0, height);
-    for (int i = 0; i < MAX_POINTS; i++) {
-        int idx = (history_idx + i) % MAX_POINTS;
-        double x = (double)i / (MAX_POINTS - 1) * width;
-        double y = height - (history[idx] / 100.0 * height);
-        cairo_line_to(cr, x, y);
-    }
-    cairo_line_to(cr, width, height);
-    cairo_close_path(cr);
-    cairo_fill(cr);
-    cairo_pattern_destroy(fill);
-
-    g_print("Drawing graph line\n");
-    cairo_set_source_rgba(cr, accent_color.red, accent_color.green, accent_color.blue, 0.9);
-    cairo_set_line_width(cr, 2.5);
-    for (int i = 0; i < MAX_POINTS; i++) {
-        int idx = (history_idx + i) % MAX_POINTS;
-        double x = (double)i / (MAX_POINTS - 1) * width;
-        double y = height - (history[idx] / 100.0 * height);
-        if (i == 0) cairo_move_to(cr, x, y);
-        else cairo_line_to(cr, x, y);
-    }
-    cairo_stroke(cr);
-
-    g_print("draw_memory_graph complete\n");
-    return FALSE;
-}
-
-static gboolean draw_swap_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
-    g_print("draw_swap_graph called\n");
-    GtkAllocation allocation;
-    gtk_widget_get_allocation(widget, &allocation);
-    int width = allocation.width, height = allocation.height;
-    g_print("Graph dimensions: %d x %d\n", width, height);
-    
-    GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
-    GdkRGBA bg_color, fg_color, accent_color;
-
-    gdk_rgba_parse(&bg_color, "rgb(24, 25, 26)");
-    gdk_rgba_parse(&fg_color, "rgb(238, 238, 236)");
-    gdk_rgba_parse(&accent_color, "rgb(66, 135, 245)"); // Blue for swap
-
-    gtk_style_context_lookup_color(style_context, "theme_bg_color", &bg_color);
-    gtk_style_context_lookup_color(style_context, "theme_fg_color", &fg_color);
-
-    g_print("Drawing background\n");
-    gdk_cairo_set_source_rgba(cr, &bg_color);
-    cairo_paint(cr);
-
-    g_print("Drawing grid lines\n");
-    GdkRGBA grid_color = fg_color;
-    grid_color.alpha = 0.2;
-    gdk_cairo_set_source_rgba(cr, &grid_color);
-    cairo_set_line_width(cr, 0.8);
-
-    for (int i = 1; i < 4; i++) {
-        double y = height * i / 4.0;
-        cairo_move_to(cr, 0, y);
-        cairo_line_to(cr, width, y);
-    }
-    cairo_stroke(cr);
-    
-    g_print("Getting swap usage history\n");
-    const gdouble* swap_history = get_swap_usage_history();
-    gint swap_history_idx = get_swap_usage_history_index();
-    
-    g_print("Creating gradient fill\n");
-    cairo_pattern_t *fill = cairo_pattern_create_linear(0, 0, 0, height);
-    cairo_pattern_add_color_stop_rgba(fill, 0, accent_color.red, accent_color.green, accent_color.blue, 0.7);
-    cairo_pattern_add_color_stop_rgba(fill, 1, accent_color.red, accent_color.green, accent_color.blue, 0.1);
-    cairo_set_source(cr, fill);
-
-    g_print("Drawing graph fill\n");
-    cairo_move_to(cr, 0, height);
-    for (int i = 0; i < MAX_POINTS; i++) {
-        int idx = (swap_history_idx + i) % MAX_POINTS;
-        double x = (double)i / (MAX_POINTS - 1) * width;
-        double y = height - (swap_history[idx] / 100.0 * height);
-        cairo_line_to(cr, x, y);
-    }
-    cairo_line_to(cr, width, height);
-    cairo_close_path(cr);
-    cairo_fill(cr);
-    cairo_pattern_destroy(fill);
-
-    g_print("Drawing graph line\n");
-    cairo_set_source_rgba(cr, accent_color.red, accent_color.green, accent_color.blue, 0.9);
-    cairo_set_line_width(cr, 2.5);
-    for (int i = 0; i < MAX_POINTS; i++) {
-        int idx = (swap_history_idx + i) % MAX_POINTS;
-        double x = (double)i / (MAX_POINTS - 1) * width;
-        double y = height - (swap_history[idx] / 100.0 * height);
-        if (i == 0) cairo_move_to(cr, x, y);
-        else cairo_line_to(cr, x, y);
-    }
-    cairo_stroke(cr);
-
-    g_print("draw_swap_graph complete\n");
-    return FALSE;
-}
-
 // Handle right-click on memory tab
 static gboolean on_memory_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
     if (event->button == 3) { // Right click
@@ -321,18 +177,20 @@ GtkWidget* create_memory_tab(void) {
     gtk_grid_set_row_spacing(GTK_GRID(main_grid), 10);
 
     g_print("Creating RAM drawing area\n");
-    GtkWidget *drawing_area = gtk_drawing_area_new();
+    GtkWidget *drawing_area = khos_graph_new(MAX_POINTS);
     gtk_widget_set_size_request(drawing_area, -1, 150);
     gtk_widget_set_hexpand(drawing_area, TRUE);
     gtk_widget_set_vexpand(drawing_area, TRUE);
-    g_signal_connect(G_OBJECT(drawing_area), "draw", G_CALLBACK(draw_memory_graph), NULL);
+    khos_graph_add_series(KHOS_GRAPH(drawing_area), &memory_color, KHOS_GRAPH_GRADIENT, 2.5);
+    khos_graph_set_series_history(KHOS_GRAPH(drawing_area), 0, get_memory_usage_history());
 
     g_print("Creating swap drawing area\n");
-    GtkWidget *swap_drawing_area = gtk_drawing_area_new();
+    GtkWidget *swap_drawing_area = khos_graph_new(MAX_POINTS);
     gtk_widget_set_size_request(swap_drawing_area, -1, 100);
     gtk_widget_set_hexpand(swap_drawing_area, TRUE);
     gtk_widget_set_vexpand(swap_drawing_area, TRUE);
-    g_signal_connect(G_OBJECT(swap_drawing_area), "draw", G_CALLBACK(draw_swap_graph), NULL);
+    khos_graph_add_series(KHOS_GRAPH(swap_drawing_area), &swap_color, KHOS_GRAPH_GRADIENT, 2.5);
+    khos_graph_set_series_history(KHOS_GRAPH(swap_drawing_area), 0, get_swap_usage_history());
 
     g_print("Creating right-click menu\n");
     GtkWidget *menu = gtk_menu_new();
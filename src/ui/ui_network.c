@@ -1,9 +1,9 @@
 #include "ui/ui_network.h"
 #include "network/network_data.h"
+#include "ui/khos_graph.h"
 #include <cairo.h>
 #include <math.h>
 
-static gboolean draw_network_graph(GtkWidget *widget, cairo_t *cr, gpointer data);
 static gboolean update_network_widgets(gpointer user_data);
 static gboolean on_network_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 static void on_interface_combo_changed(GtkComboBox *widget, gpointer user_data);
@@ -147,130 +147,44 @@ static gboolean update_network_widgets(gpointer user_data) {
         }
     }
     
-    g_print("Queueing redraw of drawing area\n");
-    gtk_widget_queue_draw(data->drawing_area);
+    // Selecting another interface swaps the plotted histories, which rebuilds the graph
+    KhosGraph *graph = KHOS_GRAPH(data->drawing_area);
+    gboolean valid = data->selected_interface_index >= 0 && data->selected_interface_index < interface_count;
+    khos_graph_set_series_history(graph, 0, valid ? get_rx_history(data->selected_interface_index) : NULL);
+    khos_graph_set_series_history(graph, 1, valid ? get_tx_history(data->selected_interface_index) : NULL);
+    if (valid) khos_graph_push(graph, get_history_index(data->selected_interface_index));
     g_print("update_network_widgets complete\n");
     return G_SOURCE_CONTINUE;
 }
 
-static gboolean draw_network_graph(GtkWidget *widget, cairo_t *cr, gpointer data) {
-    g_print("draw_network_graph called\n");
-    NetworkUpdateData *update_data = (NetworkUpdateData*)data;
-    if (!update_data) {
-        g_print("ERROR: update_data is NULL\n");
-        return FALSE;
-    }
-    
-    GtkAllocation allocation;
-    gtk_widget_get_allocation(widget, &allocation);
-    int width = allocation.width, height = allocation.height;
-    g_print("Graph dimensions: %d x %d\n", width, height);
-    
-    GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
-    GdkRGBA bg_color, fg_color, download_color, upload_color;
+static const GdkRGBA download_color = { 52 / 255.0, 101 / 255.0, 164 / 255.0, 1.0 };  // Blue for download
+static const GdkRGBA upload_color = { 78 / 255.0, 154 / 255.0, 6 / 255.0, 1.0 };      // Green for upload
 
-    gdk_rgba_parse(&bg_color, "rgb(24, 25, 26)");
-    gdk_rgba_parse(&fg_color, "rgb(238, 238, 236)");
-    gdk_rgba_parse(&download_color, "rgb(52, 101, 164)");  // Blue for download
-    gdk_rgba_parse(&upload_color, "rgb(78, 154, 6)");      // Green for upload
+static void draw_network_legend(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer data) {
+    NetworkUpdateData *update_data = (NetworkUpdateData*)data;
+    if (update_data->selected_interface_index < 0 || update_data->selected_interface_index >= get_interface_count()) return;
 
-    gtk_style_context_lookup_color(style_context, "theme_bg_color", &bg_color);
-    gtk_style_context_lookup_color(style_context, "theme_fg_color", &fg_color);
+    GdkRGBA bg_color, fg_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, NULL, NULL);
+    cairo_set_line_width(cr, 1.0);
 
-    g_print("Drawing background\n");
-    gdk_cairo_set_source_rgba(cr, &bg_color);
-    cairo_paint(cr);
+    // Download legend
+    cairo_set_source_rgba(cr, download_color.red, download_color.green, download_color.blue, 0.9);
+    cairo_rectangle(cr, width - 100, 10, 10, 10);
+    cairo_fill(cr);
 
-    g_print("Drawing grid lines\n");
-    GdkRGBA grid_color = fg_color;
-    grid_color.alpha = 0.2;
-    gdk_cairo_set_source_rgba(cr, &grid_color);
-    cairo_set_line_width(cr, 0.8);
+    cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+    cairo_move_to(cr, width - 85, 20);
+    cairo_show_text(cr, "Download (Mbps)");
 
-    for (int i = 1; i < 4; i++) {
-        double y = height * i / 4.0;
-        cairo_move_to(cr, 0, y);
-        cairo_line_to(cr, width, y);
-    }
-    cairo_stroke(cr);
-    
-    // Draw network traffic graph if we have a valid selection
-    gint interface_count = get_interface_count();
-    if (update_data->selected_interface_index >= 0 && update_data->selected_interface_index < interface_count) {
-        g_print("Getting network traffic history\n");
-        const gdouble* rx_history_raw = get_rx_history(update_data->selected_interface_index);
-        const gdouble* tx_history_raw = get_tx_history(update_data->selected_interface_index);
-        gint history_idx = get_history_index(update_data->selected_interface_index);
-        
-        // Convert history to Mbps on the fly
-        const gdouble* rx_history = rx_history_raw; // alias to keep code adjustments minimal
-        const gdouble* tx_history = tx_history_raw;
-        
-        // Find the maximum value for scaling
-        gdouble max_value = 1.0;  // Minimum to avoid division by zero
-        for (int i = 0; i < MAX_POINTS; i++) {
-            int idx = (history_idx + i) % MAX_POINTS;
-            double rx_mbps = rx_history_raw[idx] * 8.0 / 1024.0;
-            double tx_mbps = tx_history_raw[idx] * 8.0 / 1024.0;
-            if (rx_mbps > max_value) max_value = rx_mbps;
-            if (tx_mbps > max_value) max_value = tx_mbps;
-        }
-        
-        // Add 20% headroom
-        max_value *= 1.2;
-        
-        if (rx_history && tx_history) {
-            // Draw download graph
-            g_print("Drawing download graph\n");
-            cairo_set_source_rgba(cr, download_color.red, download_color.green, download_color.blue, 0.9);
-            cairo_set_line_width(cr, 2.5);
-            for (int i = 0; i < MAX_POINTS; i++) {
-                int idx = (history_idx + i) % MAX_POINTS;
-                double x = (double)i / (MAX_POINTS - 1) * width;
-                double y = height - ((rx_history_raw[idx] * 8.0 / 1024.0) / max_value * height);
-                if (i == 0) cairo_move_to(cr, x, y);
-                else cairo_line_to(cr, x, y);
-            }
-            cairo_stroke(cr);
-            
-            // Draw upload graph
-            g_print("Drawing upload graph\n");
-            cairo_set_source_rgba(cr, upload_color.red, upload_color.green, upload_color.blue, 0.9);
-            cairo_set_line_width(cr, 2.5);
-            for (int i = 0; i < MAX_POINTS; i++) {
-                int idx = (history_idx + i) % MAX_POINTS;
-                double x = (double)i / (MAX_POINTS - 1) * width;
-                double y = height - ((tx_history_raw[idx] * 8.0 / 1024.0) / max_value * height);
-                if (i == 0) cairo_move_to(cr, x, y);
-                else cairo_line_to(cr, x, y);
-            }
-            cairo_stroke(cr);
-            
-            // Draw legend
-            cairo_set_line_width(cr, 1.0);
-            
-            // Download legend
-            cairo_set_source_rgba(cr, download_color.red, download_color.green, download_color.blue, 0.9);
-            cairo_rectangle(cr, width - 100, 10, 10, 10);
-            cairo_fill(cr);
-            
-            cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
-            cairo_move_to(cr, width - 85, 20);
-            cairo_show_text(cr, "Download (Mbps)");
-            
-            // Upload legend
-            cairo_set_source_rgba(cr, upload_color.red, upload_color.green, upload_color.blue, 0.9);
-            cairo_rectangle(cr, width - 100, 30, 10, 10);
-            cairo_fill(cr);
-            
-            cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
-            cairo_move_to(cr, width - 85, 40);
-            cairo_show_text(cr, "Upload (Mbps)");
-        }
-    }
+    // Upload legend
+    cairo_set_source_rgba(cr, upload_color.red, upload_color.green, upload_color.blue, 0.9);
+    cairo_rectangle(cr, width - 100, 30, 10, 10);
+    cairo_fill(cr);
 
-    g_print("draw_network_graph complete\n");
-    return FALSE;
+    cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+    cairo_move_to(cr, width - 85, 40);
+    cairo_show_text(cr, "Upload (Mbps)");
 }
 
 static gboolean on_network_tab_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
@@ -376,10 +290,15 @@ GtkWidget* create_network_tab(void) {
     gtk_box_pack_start(GTK_BOX(combo_box), combo_label, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(combo_box), combo, TRUE, TRUE, 0);
     
-    GtkWidget *drawing_area = gtk_drawing_area_new();
+    GtkWidget *drawing_area = khos_graph_new(MAX_POINTS);
     gtk_widget_set_size_request(drawing_area, -1, 250);
     gtk_widget_set_hexpand(drawing_area, TRUE);
     gtk_widget_set_vexpand(drawing_area, TRUE);
+    // Rates are KB/s; plot Mbps on an axis that follows the busiest sample in view
+    khos_graph_add_series(KHOS_GRAPH(drawing_area), &download_color, KHOS_GRAPH_LINE, 2.5);
+    khos_graph_add_series(KHOS_GRAPH(drawing_area), &upload_color, KHOS_GRAPH_LINE, 2.5);
+    khos_graph_set_value_scale(KHOS_GRAPH(drawing_area), 8.0 / 1024.0);
+    khos_graph_set_autoscale(KHOS_GRAPH(drawing_area), 1.0, 1.2);
 
     GtkWidget *graph_frame = gtk_frame_new(NULL);
     gtk_frame_set_shadow_type(GTK_FRAME(graph_frame), GTK_SHADOW_ETCHED_IN);
@@ -494,7 +413,7 @@ GtkWidget* create_network_tab(void) {
     data->selected_interface_index = 0;
     data->update_interval = 2000;  // 2 seconds
     
-    g_signal_connect(G_OBJECT(drawing_area), "draw", G_CALLBACK(draw_network_graph), data);
+    khos_graph_set_overlay_func(KHOS_GRAPH(drawing_area), draw_network_legend, data, 0);
     g_signal_connect(G_OBJECT(combo), "changed", G_CALLBACK(on_interface_combo_changed), data);
     g_signal_connect(G_OBJECT(drawing_area), "button-press-event", G_CALLBACK(on_network_tab_button_press), popup_menu);
     
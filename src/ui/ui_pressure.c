@@ -0,0 +1,251 @@
+#include "ui/ui_pressure.h"
+#include "pressure/psi_data.h"
+#include "ui/graph_utils.h"
+#include "ui/khos_graph.h"
+#include <cairo.h>
+
+/* Stall share above which the graph title turns red */
+#define PSI_WARN_PERCENT 10.0
+
+static const GdkRGBA full_stall_color = { 224 / 255.0, 27 / 255.0, 36 / 255.0, 1.0 };  // Red for "full" stalls
+
+static gboolean update_pressure_widgets(gpointer user_data);
+
+typedef struct {
+    GtkWidget *graph_areas[PSI_N_RESOURCES];
+    GtkWidget *avg_values[PSI_N_RESOURCES];
+    GtkWidget *event_values[PSI_N_RESOURCES];
+    guint update_interval;
+    guint timeout_id;
+} PressureUpdateData;
+
+static void cleanup_pressure_update_data(gpointer data) {
+    PressureUpdateData *update_data = data;
+    if (update_data->timeout_id > 0) g_source_remove(update_data->timeout_id);
+    psi_triggers_disable();
+    g_free(update_data);
+}
+
+static void update_pressure_labels(PressureUpdateData *data) {
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        const PsiStats *st = psi_get_stats(r);
+        char text[96];
+        if (!st->available) {
+            snprintf(text, sizeof(text), "N/A");
+        } else if (st->has_full) {
+            snprintf(text, sizeof(text), "some %.2f / %.2f, full %.2f / %.2f",
+                     st->some.avg10, st->some.avg60, st->full.avg10, st->full.avg60);
+        } else {
+            snprintf(text, sizeof(text), "some %.2f / %.2f", st->some.avg10, st->some.avg60);
+        }
+        gtk_label_set_text(GTK_LABEL(data->avg_values[r]), text);
+
+        if (psi_triggers_enabled()) snprintf(text, sizeof(text), "%" G_GUINT64_FORMAT, st->trigger_events);
+        else snprintf(text, sizeof(text), "Off");
+        gtk_label_set_text(GTK_LABEL(data->event_values[r]), text);
+    }
+}
+
+static void update_pressure_graphs(PressureUpdateData *data) {
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        // "full" is only plotted while the kernel reports it
+        const PsiStats *st = psi_get_stats(r);
+        KhosGraph *graph = KHOS_GRAPH(data->graph_areas[r]);
+        khos_graph_set_series_history(graph, 0, st->available ? psi_get_some_history(r) : NULL);
+        khos_graph_set_series_history(graph, 1, st->available && st->has_full ? psi_get_full_history(r) : NULL);
+        khos_graph_push(graph, psi_get_history_index());
+    }
+}
+
+static gboolean update_pressure_widgets(gpointer user_data) {
+    PressureUpdateData *data = user_data;
+    psi_data_update();
+    update_pressure_labels(data);
+    update_pressure_graphs(data);
+    return G_SOURCE_CONTINUE;
+}
+
+// A trigger fired: show the fresh averages now rather than at the next tick
+static void on_psi_trigger(PsiResource resource, gpointer user_data) {
+    PressureUpdateData *data = user_data;
+    update_pressure_labels(data);
+    // No new samples; this only repaints the title band
+    khos_graph_push(KHOS_GRAPH(data->graph_areas[resource]), psi_get_history_index());
+}
+
+static void draw_pressure_title(KhosGraph *graph, cairo_t *cr, int width, int height, gpointer user_data) {
+    PsiResource r = GPOINTER_TO_INT(user_data);
+    GdkRGBA bg_color, fg_color, full_color = full_stall_color;
+    graph_get_theme_colors(GTK_WIDGET(graph), &bg_color, &fg_color, NULL, NULL);
+
+    const PsiStats *st = psi_get_stats(r);
+    if (!st->available) {
+        cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.7);
+        cairo_move_to(cr, 10, 20);
+        cairo_show_text(cr, PSI_ROOT " is not available (kernel without CONFIG_PSI or booted with psi=0)");
+        return;
+    }
+
+    char label[64];
+    if (st->has_full) {
+        snprintf(label, sizeof(label), "%s: some %.1f%%, full %.1f%%",
+                 psi_get_resource_name(r), st->some_percent, st->full_percent);
+    } else {
+        snprintf(label, sizeof(label), "%s: some %.1f%%", psi_get_resource_name(r), st->some_percent);
+    }
+    if (st->some_percent >= PSI_WARN_PERCENT) gdk_cairo_set_source_rgba(cr, &full_color);
+    else cairo_set_source_rgba(cr, fg_color.red, fg_color.green, fg_color.blue, 0.9);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 12);
+    cairo_move_to(cr, 5, 15);
+    cairo_show_text(cr, label);
+}
+
+static void on_trigger_toggled(GtkCheckMenuItem *item, gpointer user_data) {
+    PressureUpdateData *data = user_data;
+    if (!gtk_check_menu_item_get_active(item)) {
+        psi_triggers_disable();
+        update_pressure_labels(data);
+        return;
+    }
+
+    GError *err = NULL;
+    if (!psi_triggers_enable(PSI_TRIGGER_STALL_US, PSI_TRIGGER_WINDOW_US, on_psi_trigger, data, &err)) {
+        g_printerr("%s\n", err->message);
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(gtk_widget_get_toplevel(data->graph_areas[0])),
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
+                                                   "Could not enable stall triggers");
+        gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog), "%s%s", err->message,
+            err->code == PSI_ERROR_PERMISSION ? "\n\nThis kernel only allows PSI triggers for root." : "");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        g_error_free(err);
+
+        g_signal_handlers_block_by_func(item, on_trigger_toggled, data);
+        gtk_check_menu_item_set_active(item, FALSE);
+        g_signal_handlers_unblock_by_func(item, on_trigger_toggled, data);
+    }
+    update_pressure_labels(data);
+}
+
+static void on_refresh_activate(GtkMenuItem *item, gpointer user_data) {
+    PressureUpdateData *data = user_data;
+    GtkWidget *dialog = gtk_dialog_new_with_buttons("Refresh Period",
+                                                  GTK_WINDOW(gtk_widget_get_toplevel(data->graph_areas[0])),
+                                                  GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                  "Apply", GTK_RESPONSE_APPLY,
+                                                  "Cancel", GTK_RESPONSE_CANCEL,
+                                                  NULL);
+    GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget *spin = gtk_spin_button_new_with_range(100, 5000, 100);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(spin), data->update_interval);
+    gtk_box_pack_start(GTK_BOX(hbox), gtk_label_new("Update interval (ms):"), FALSE, FALSE, 5);
+    gtk_box_pack_start(GTK_BOX(hbox), spin, FALSE, FALSE, 5);
+    gtk_container_add(GTK_CONTAINER(content_area), hbox);
+    gtk_widget_show_all(dialog);
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_APPLY) {
+        data->update_interval = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(spin));
+        g_print("Setting pressure refresh interval to %d ms\n", data->update_interval);
+        if (data->timeout_id > 0) g_source_remove(data->timeout_id);
+        data->timeout_id = g_timeout_add(data->update_interval, update_pressure_widgets, data);
+    }
+    gtk_widget_destroy(dialog);
+}
+
+static gboolean on_pressure_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
+    if (event->type == GDK_BUTTON_PRESS && event->button == 3) {
+        gtk_menu_popup_at_pointer(GTK_MENU(user_data), (GdkEvent*)event);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+GtkWidget* create_pressure_tab(void) {
+    GtkWidget *main_grid = gtk_grid_new();
+    gtk_widget_set_hexpand(main_grid, TRUE);
+    gtk_widget_set_vexpand(main_grid, TRUE);
+    gtk_widget_set_margin_start(main_grid, 10);
+    gtk_widget_set_margin_end(main_grid, 10);
+    gtk_widget_set_margin_top(main_grid, 10);
+    gtk_widget_set_margin_bottom(main_grid, 10);
+    gtk_grid_set_column_spacing(GTK_GRID(main_grid), 20);
+    gtk_grid_set_row_spacing(GTK_GRID(main_grid), 10);
+
+    PressureUpdateData *update_data = g_new0(PressureUpdateData, 1);
+    update_data->update_interval = 1000; // Default to 1 second
+
+    GtkWidget *menu = gtk_menu_new();
+    GtkWidget *refresh_item = gtk_menu_item_new_with_label("Refresh Period");
+    GtkWidget *trigger_item = gtk_check_menu_item_new_with_label("Wake on Stall Events");
+    g_signal_connect(refresh_item, "activate", G_CALLBACK(on_refresh_activate), update_data);
+    g_signal_connect(trigger_item, "toggled", G_CALLBACK(on_trigger_toggled), update_data);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), refresh_item);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), trigger_item);
+    gtk_widget_show_all(menu);
+
+    GtkWidget *info_frame = gtk_frame_new("Pressure Averages (avg10 / avg60 %)");
+    gtk_frame_set_shadow_type(GTK_FRAME(info_frame), GTK_SHADOW_ETCHED_IN);
+    gtk_widget_set_valign(info_frame, GTK_ALIGN_START);
+    GtkWidget *info_grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(info_grid), 15);
+    gtk_grid_set_row_spacing(GTK_GRID(info_grid), 8);
+    gtk_widget_set_margin_start(info_grid, 10);
+    gtk_widget_set_margin_end(info_grid, 10);
+    gtk_widget_set_margin_top(info_grid, 10);
+    gtk_widget_set_margin_bottom(info_grid, 10);
+    gtk_container_add(GTK_CONTAINER(info_frame), info_grid);
+
+    for (gint r = 0; r < PSI_N_RESOURCES; r++) {
+        GtkWidget *area = khos_graph_new(MAX_POINTS);
+        gtk_widget_set_size_request(area, -1, 100);
+        gtk_widget_set_hexpand(area, TRUE);
+        gtk_widget_set_vexpand(area, TRUE);
+        khos_graph_add_series(KHOS_GRAPH(area), NULL, KHOS_GRAPH_GRADIENT, 2.0);
+        khos_graph_add_series(KHOS_GRAPH(area), &full_stall_color, KHOS_GRAPH_LINE, 1.5);
+        khos_graph_set_overlay_func(KHOS_GRAPH(area), draw_pressure_title, GINT_TO_POINTER(r), 20);
+        gtk_widget_add_events(area, GDK_BUTTON_PRESS_MASK);
+        g_signal_connect(area, "button-press-event", G_CALLBACK(on_pressure_button_press), menu);
+        gtk_widget_set_tooltip_text(area, r == PSI_CPU
+            ? "Share of time some runnable task was waiting for a CPU"
+            : "Share of time some task (filled) or all non-idle tasks (red line) were stalled");
+
+        gchar *title = g_strdup_printf("%s Pressure", psi_get_resource_name(r));
+        GtkWidget *frame = gtk_frame_new(title);
+        g_free(title);
+        gtk_frame_set_shadow_type(GTK_FRAME(frame), GTK_SHADOW_ETCHED_IN);
+        gtk_container_add(GTK_CONTAINER(frame), area);
+        gtk_grid_attach(GTK_GRID(main_grid), frame, 0, r, 1, 1);
+        update_data->graph_areas[r] = area;
+
+        gchar *name = g_strdup_printf("%s:", psi_get_resource_name(r));
+        GtkWidget *label = gtk_label_new(name);
+        g_free(name);
+        gtk_widget_set_halign(label, GTK_ALIGN_START);
+        GtkWidget *value = gtk_label_new("N/A");
+        gtk_widget_set_halign(value, GTK_ALIGN_START);
+        gtk_grid_attach(GTK_GRID(info_grid), label, 0, r, 1, 1);
+        gtk_grid_attach(GTK_GRID(info_grid), value, 1, r, 1, 1);
+        update_data->avg_values[r] = value;
+
+        name = g_strdup_printf("%s stall events:", psi_get_resource_name(r));
+        label = gtk_label_new(name);
+        g_free(name);
+        gtk_widget_set_halign(label, GTK_ALIGN_START);
+        value = gtk_label_new("Off");
+        gtk_widget_set_halign(value, GTK_ALIGN_START);
+        gtk_grid_attach(GTK_GRID(info_grid), label, 0, PSI_N_RESOURCES + r, 1, 1);
+        gtk_grid_attach(GTK_GRID(info_grid), value, 1, PSI_N_RESOURCES + r, 1, 1);
+        update_data->event_values[r] = value;
+    }
+    gtk_grid_attach(GTK_GRID(main_grid), info_frame, 1, 0, 1, PSI_N_RESOURCES);
+
+    g_object_set_data_full(G_OBJECT(main_grid), "update_data", update_data, cleanup_pressure_update_data);
+    update_pressure_labels(update_data);
+    update_pressure_graphs(update_data);
+    update_data->timeout_id = g_timeout_add(update_data->update_interval, update_pressure_widgets, update_data);
+
+    return main_grid;
+}
@@ -0,0 +1,274 @@
+#include "utils/app_identity.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef struct {
+    guint64 starttime;
+    const AppIdentity *app;
+    gchar *cgroup;
+    gboolean system_service;
+    gboolean seen_this_cycle;
+} AppProcEntry;
+
+/* An interned identity and the number of AppProcEntry that point at it.
+ * Identities nobody points at are freed at the end of the cycle; fallback
+ * ids include per-instance scopes, so they would otherwise pile up. */
+typedef struct {
+    AppIdentity app;
+    guint refs;
+} InternedApp;
+
+static GHashTable *identities = NULL;     // id -> InternedApp* (owned)
+static GHashTable *desktop_cache = NULL;  // desktop id -> AppIdentity*, or NULL for a miss
+static GHashTable *proc_entries = NULL;   // pid -> AppProcEntry*
+
+static void free_identity(gpointer data) {
+    InternedApp *interned = (InternedApp*)data;
+    g_free(interned->app.id);
+    g_free(interned->app.name);
+    g_free(interned->app.icon);
+    g_free(interned);
+}
+
+static void set_entry_app(AppProcEntry *entry, const AppIdentity *app) {
+    if (app) ((InternedApp*)app)->refs++;
+    if (entry->app) ((InternedApp*)entry->app)->refs--;
+    entry->app = app;
+}
+
+static void free_proc_entry(gpointer data) {
+    AppProcEntry *entry = (AppProcEntry*)data;
+    set_entry_app(entry, NULL);
+    g_free(entry->cgroup);
+    g_free(entry);
+}
+
+static void ensure_tables(void) {
+    if (identities) return;
+    identities = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_identity);
+    desktop_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    proc_entries = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_proc_entry);
+}
+
+static const AppIdentity* intern_identity(const gchar *id, const gchar *name, const gchar *icon, gboolean from_unit) {
+    InternedApp *interned = g_hash_table_lookup(identities, id);
+    if (interned) return &interned->app;
+    interned = g_new0(InternedApp, 1);
+    interned->app.id = g_strdup(id);
+    interned->app.name = g_strdup(name);
+    interned->app.icon = g_strdup(icon);
+    interned->app.from_unit = from_unit;
+    g_hash_table_insert(identities, interned->app.id, interned);
+    return &interned->app;
+}
+
+/* Look for <desktop_id>.desktop in the XDG data dirs */
+static const AppIdentity* lookup_desktop_file(const gchar *desktop_id) {
+    gpointer cached;
+    if (g_hash_table_lookup_extended(desktop_cache, desktop_id, NULL, &cached)) return cached;
+
+    const AppIdentity *app = NULL;
+    gchar *basename = g_strconcat(desktop_id, ".desktop", NULL);
+    GPtrArray *dirs = g_ptr_array_new();
+    g_ptr_array_add(dirs, (gpointer)g_get_user_data_dir());
+    for (const gchar *const *d = g_get_system_data_dirs(); *d; d++) g_ptr_array_add(dirs, (gpointer)*d);
+
+    for (guint i = 0; i < dirs->len && !app; i++) {
+        gchar *path = g_build_filename(g_ptr_array_index(dirs, i), "applications", basename, NULL);
+        GKeyFile *kf = g_key_file_new();
+        if (g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL)) {
+            gchar *name = g_key_file_get_locale_string(kf, G_KEY_FILE_DESKTOP_GROUP, G_KEY_FILE_DESKTOP_KEY_NAME, NULL, NULL);
+            gchar *icon = g_key_file_get_string(kf, G_KEY_FILE_DESKTOP_GROUP, G_KEY_FILE_DESKTOP_KEY_ICON, NULL);
+            app = intern_identity(desktop_id, name ? name : desktop_id, icon ? icon : desktop_id, TRUE);
+            g_free(name);
+            g_free(icon);
+        }
+        g_key_file_free(kf);
+        g_free(path);
+    }
+    g_ptr_array_free(dirs, TRUE);
+    g_free(basename);
+
+    g_hash_table_insert(desktop_cache, g_strdup(desktop_id), (gpointer)app);
+    return app;
+}
+
+/* Undo systemd unit name escaping ("google\x2dchrome" -> "google-chrome") */
+static gchar* unescape_unit(const gchar *s, gsize len) {
+    GString *out = g_string_sized_new(len);
+    for (gsize i = 0; i < len; i++) {
+        if (s[i] == '\\' && i + 3 < len && s[i + 1] == 'x' && isxdigit((unsigned char)s[i + 2]) && isxdigit((unsigned char)s[i + 3])) {
+            g_string_append_c(out, (gchar)(g_ascii_xdigit_value(s[i + 2]) * 16 + g_ascii_xdigit_value(s[i + 3])));
+            i += 3;
+        } else {
+            g_string_append_c(out, s[i]);
+        }
+    }
+    return g_string_free(out, FALSE);
+}
+
+/* Application id from the leaf unit of a cgroup path, following the XDG
+ * naming scheme: app-[<launcher>-]<app id>-<random>.scope and
+ * app-[<launcher>-]<app id>[@<random>].service. Other services give their
+ * unit name. Returns NULL for sessions, init.scope and the like. */
+static const AppIdentity* identity_from_cgroup(const gchar *cgroup) {
+    const gchar *leaf = strrchr(cgroup, '/');
+    leaf = leaf ? leaf + 1 : cgroup;
+
+    gboolean is_scope = g_str_has_suffix(leaf, ".scope");
+    gboolean is_service = g_str_has_suffix(leaf, ".service");
+    if (!is_scope && !is_service) return NULL;
+
+    gsize len = strlen(leaf) - (is_scope ? 6 : 8);
+    gboolean is_app = g_str_has_prefix(leaf, "app-");
+    if (!is_app) {
+        // Plain user/system services group by unit; scopes here are sessions
+        if (!is_service || g_str_has_prefix(leaf, "user@")) return NULL;
+        const gchar *at = memchr(leaf, '@', len);
+        gchar *unit = unescape_unit(leaf, at ? (gsize)(at - leaf) : len);
+        gchar *id = g_strconcat("unit:", unit, NULL);
+        const AppIdentity *app = intern_identity(id, unit, unit, TRUE);
+        g_free(id);
+        g_free(unit);
+        return app;
+    }
+
+    const gchar *start = leaf + 4;
+    len -= 4;
+    if (is_scope) {
+        const gchar *dash = g_strrstr_len(start, len, "-");
+        if (dash) len = dash - start;    // drop the random suffix
+    } else {
+        const gchar *at = memchr(start, '@', len);
+        if (at) len = at - start;
+    }
+    if (len == 0) return NULL;
+
+    gchar *app_part = unescape_unit(start, len);
+
+    // Peel off launcher prefixes ("gnome-", "flatpak-", "dbus-:1.2-") until a .desktop matches
+    const AppIdentity *app = NULL;
+    const gchar *candidate = app_part;
+    while (candidate && *candidate && !app) {
+        app = lookup_desktop_file(candidate);
+        const gchar *dash = strchr(candidate, '-');
+        candidate = dash ? dash + 1 : NULL;
+    }
+
+    if (!app) {
+        // No .desktop file: a launcher segment has no dots, reverse-DNS ids do
+        const gchar *id = app_part;
+        const gchar *dash = strchr(app_part, '-');
+        if (dash && dash[1] && !memchr(app_part, '.', dash - app_part)) id = dash + 1;
+        const gchar *dot = strrchr(id, '.');
+        app = intern_identity(id, dot && dot[1] ? dot + 1 : id, id, TRUE);
+    }
+    g_free(app_part);
+    return app;
+}
+
+static gchar* read_cgroup_path(guint pid, gboolean *system_service) {
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%u/cgroup", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return NULL;
+    gchar *cgroup = NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strstr(line, "system.slice")) *system_service = TRUE;
+        if (strncmp(line, "0::", 3) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            // Keep it relative to the hierarchy root, like cgroup_data does
+            const gchar *rel = line + 3;
+            while (*rel == '/') rel++;
+            cgroup = g_strdup(rel);
+        }
+    }
+    fclose(fp);
+    return cgroup;
+}
+
+/* Processes the cgroup names no application for. Same-named processes only
+ * group within one scope or unit: two python3 in different terminal tabs
+ * (vte-spawn-<uuid>.scope) are unrelated. Outside a unit (kernel threads)
+ * the comm alone is the key. */
+static const AppIdentity* identity_from_comm(const gchar *cgroup, const gchar *comm) {
+    const gchar *leaf = cgroup ? strrchr(cgroup, '/') : NULL;
+    leaf = leaf ? leaf + 1 : cgroup;
+    gboolean in_unit = leaf && (g_str_has_suffix(leaf, ".scope") || g_str_has_suffix(leaf, ".service"));
+    gchar *id = in_unit ? g_strconcat("comm:", comm, "@", leaf, NULL) : g_strconcat("comm:", comm, NULL);
+    const AppIdentity *app = intern_identity(id, comm, comm, FALSE);
+    g_free(id);
+    return app;
+}
+
+const AppIdentity* app_identity_for_pid(guint pid, guint64 starttime, const gchar *comm,
+                                        gboolean *is_system_service) {
+    ensure_tables();
+    if (!comm) comm = "";
+
+    AppProcEntry *entry = g_hash_table_lookup(proc_entries, GUINT_TO_POINTER(pid));
+    if (entry && entry->starttime != starttime) {
+        g_hash_table_remove(proc_entries, GUINT_TO_POINTER(pid));   // pid was reused
+        entry = NULL;
+    }
+
+    if (!entry) {
+        entry = g_new0(AppProcEntry, 1);
+        entry->starttime = starttime;
+        entry->cgroup = read_cgroup_path(pid, &entry->system_service);
+        const AppIdentity *app = entry->cgroup ? identity_from_cgroup(entry->cgroup) : NULL;
+        set_entry_app(entry, app ? app : identity_from_comm(entry->cgroup, comm));
+        g_hash_table_insert(proc_entries, GUINT_TO_POINTER(pid), entry);
+    } else if (!entry->app->from_unit && strcmp(entry->app->name, comm) != 0) {
+        set_entry_app(entry, identity_from_comm(entry->cgroup, comm));   // exec() changed the comm
+    }
+
+    entry->seen_this_cycle = TRUE;
+    if (is_system_service) *is_system_service = entry->system_service;
+    return entry->app;
+}
+
+const gchar* app_identity_get_cgroup(guint pid) {
+    AppProcEntry *entry = proc_entries ? g_hash_table_lookup(proc_entries, GUINT_TO_POINTER(pid)) : NULL;
+    return entry ? entry->cgroup : NULL;
+}
+
+void app_identity_begin_cycle(void) {
+    ensure_tables();
+    GHashTableIter it; gpointer value;
+    g_hash_table_iter_init(&it, proc_entries);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        ((AppProcEntry*)value)->seen_this_cycle = FALSE;
+    }
+}
+
+void app_identity_end_cycle(void) {
+    if (!proc_entries) return;
+    GHashTableIter it; gpointer value;
+    g_hash_table_iter_init(&it, proc_entries);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        if (!((AppProcEntry*)value)->seen_this_cycle) g_hash_table_iter_remove(&it);
+    }
+
+    // Identities no process maps to any more; a .desktop hit is looked up again if it returns
+    g_hash_table_iter_init(&it, identities);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        InternedApp *interned = value;
+        if (interned->refs > 0) continue;
+        if (g_hash_table_lookup(desktop_cache, interned->app.id) == &interned->app) {
+            g_hash_table_remove(desktop_cache, interned->app.id);
+        }
+        g_hash_table_iter_remove(&it);
+    }
+}
+
+void app_identity_cleanup(void) {
+    if (!identities) return;
+    g_hash_table_destroy(proc_entries);
+    g_hash_table_destroy(desktop_cache);
+    g_hash_table_destroy(identities);
+    proc_entries = NULL;
+    desktop_cache = NULL;
+    identities = NULL;
+}
@@ -0,0 +1,68 @@
+#include "utils/fd_budget.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define FD_BUDGET_FALLBACK 512      // when the limit cannot be read
+#define FD_BUDGET_MAX 16384         // an unlimited soft limit still gets a ceiling
+
+static gint budget = -1;
+static gint in_use = 0;
+
+static gint get_budget(void) {
+    if (budget >= 0) return budget;
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+        budget = FD_BUDGET_FALLBACK;
+    } else if (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur / 2 > FD_BUDGET_MAX) {
+        budget = FD_BUDGET_MAX;
+    } else {
+        budget = (gint)(rl.rlim_cur / 2);
+    }
+    return budget;
+}
+
+gboolean fd_budget_reserve(gint count) {
+    if (count <= 0) return TRUE;
+    if (in_use + count > get_budget()) return FALSE;
+    in_use += count;
+    return TRUE;
+}
+
+void fd_budget_release(gint count) {
+    in_use = MAX(0, in_use - count);
+}
+
+int fd_budget_open(const gchar *path) {
+    if (!fd_budget_reserve(1)) {
+        return access(path, R_OK) == 0 ? FD_BUDGET_PER_READ : -1;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) fd_budget_release(1);
+    return fd;
+}
+
+void fd_budget_close(int fd) {
+    if (fd < 0) return;
+    close(fd);
+    fd_budget_release(1);
+}
+
+gboolean fd_budget_read_u64(int fd, const gchar *path, guint64 *value) {
+    char buf[32];
+    ssize_t n;
+    if (fd >= 0) {
+        n = pread(fd, buf, sizeof(buf) - 1, 0);
+    } else if (fd == FD_BUDGET_PER_READ && path) {
+        int tmp = open(path, O_RDONLY | O_CLOEXEC);
+        if (tmp < 0) return FALSE;
+        n = read(tmp, buf, sizeof(buf) - 1);
+        close(tmp);
+    } else {
+        return FALSE;
+    }
+    if (n <= 0) return FALSE;
+    buf[n] = '\0';
+    *value = g_ascii_strtoull(buf, NULL, 10);
+    return TRUE;
+}
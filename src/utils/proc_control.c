@@ -0,0 +1,375 @@
+#define _GNU_SOURCE
+#include "utils/proc_control.h"
+#include "cgroup/cgroup_data.h"
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+
+G_DEFINE_QUARK(proc-control-error-quark, proc_control_error)
+
+static void set_errno_error(GError **error, int err, const gchar *what, guint pid) {
+    if (!error || *error) return;   // keep the first failure
+    g_set_error(error, PROC_CONTROL_ERROR,
+                (err == EPERM || err == EACCES) ? PROC_CONTROL_ERROR_PERMISSION : PROC_CONTROL_ERROR_FAILED,
+                "%s failed for pid %u: %s", what, pid, g_strerror(err));
+}
+
+/* ----------------------------------------------------------------------------------
+ *  Per-thread settings
+ * --------------------------------------------------------------------------------*/
+
+typedef int (*ThreadFunc)(pid_t tid, gconstpointer data);
+
+// Run @func for every thread of @pid; returns 0 or the first errno
+static int for_each_thread(guint pid, ThreadFunc func, gconstpointer data) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/task", pid);
+    DIR *dir = opendir(path);
+    if (!dir) return errno;
+
+    int first_err = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        int err = func((pid_t)atoi(entry->d_name), data);
+        if (err && err != ESRCH && !first_err) first_err = err;   // threads may exit meanwhile
+    }
+    closedir(dir);
+    return first_err;
+}
+
+static int renice_thread(pid_t tid, gconstpointer data) {
+    return setpriority(PRIO_PROCESS, tid, *(const gint*)data) == 0 ? 0 : errno;
+}
+
+static int ionice_thread(pid_t tid, gconstpointer data) {
+    return syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, *(const gint*)data) == 0 ? 0 : errno;
+}
+
+static int affinity_thread(pid_t tid, gconstpointer data) {
+    return sched_setaffinity(tid, sizeof(cpu_set_t), (const cpu_set_t*)data) == 0 ? 0 : errno;
+}
+
+static gboolean apply_to_threads(GArray *pids, ThreadFunc func, gconstpointer data, const gchar *what, GError **error) {
+    for (guint i = 0; i < pids->len; i++) {
+        guint pid = g_array_index(pids, guint, i);
+        int err = for_each_thread(pid, func, data);
+        if (err) set_errno_error(error, err, what, pid);
+    }
+    return !(error && *error);
+}
+
+gboolean proc_control_renice(GArray *pids, gint nice_value, GError **error) {
+    nice_value = CLAMP(nice_value, -20, 19);
+    return apply_to_threads(pids, renice_thread, &nice_value, "Changing priority", error);
+}
+
+gboolean proc_control_ionice(GArray *pids, ProcControlIoClass io_class, gint level, GError **error) {
+    gint ioprio = ((gint)io_class << IOPRIO_CLASS_SHIFT) | (io_class == PROC_CONTROL_IOPRIO_IDLE ? 0 : CLAMP(level, 0, 7));
+    return apply_to_threads(pids, ionice_thread, &ioprio, "Changing I/O priority", error);
+}
+
+gboolean proc_control_set_affinity(GArray *pids, const guint8 *cpus, gint n_cpus, GError **error) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (gint i = 0; i < n_cpus && i < CPU_SETSIZE; i++) {
+        if (cpus[i]) CPU_SET(i, &set);
+    }
+    if (CPU_COUNT(&set) == 0) {
+        g_set_error(error, PROC_CONTROL_ERROR, PROC_CONTROL_ERROR_FAILED, "No CPU selected");
+        return FALSE;
+    }
+    return apply_to_threads(pids, affinity_thread, &set, "Setting CPU affinity", error);
+}
+
+/* ----------------------------------------------------------------------------------
+ *  cgroup actions
+ * --------------------------------------------------------------------------------*/
+
+// cgroup v2 path of @pid relative to CGROUP_ROOT, read fresh
+static gchar* read_pid_cgroup(guint pid) {
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%u/cgroup", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return NULL;
+    gchar *cgroup = NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "0::", 3) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            const gchar *rel = line + 3;
+            while (*rel == '/') rel++;
+            cgroup = g_strdup(rel);
+            break;
+        }
+    }
+    fclose(fp);
+    return cgroup;
+}
+
+// Whether the leaf cgroup belongs to this process's own unit rather than a login session
+static gboolean is_own_unit(const gchar *cgroup) {
+    const gchar *leaf = strrchr(cgroup, '/');
+    leaf = leaf ? leaf + 1 : cgroup;
+    if (g_str_has_prefix(leaf, "app-") || g_str_has_prefix(leaf, "khos-")) return TRUE;
+    return g_str_has_suffix(leaf, ".service") && !g_str_has_prefix(leaf, "user@");
+}
+
+// Whether @pids or one of @cgroups covers this monitor, which must never be frozen
+static gboolean contains_self(GArray *pids, GPtrArray *cgroups) {
+    guint self = (guint)getpid();
+    for (guint i = 0; i < pids->len; i++) {
+        if (g_array_index(pids, guint, i) == self) return TRUE;
+    }
+    gchar *own = read_pid_cgroup(self);
+    gboolean found = FALSE;
+    for (guint i = 0; own && !found && i < cgroups->len; i++) {
+        const gchar *cgroup = g_ptr_array_index(cgroups, i);
+        gsize len = strlen(cgroup);
+        found = strncmp(own, cgroup, len) == 0 && (own[len] == '\0' || own[len] == '/');
+    }
+    g_free(own);
+    return found;
+}
+
+// cgroupfs needs a single write() to the existing file, so no g_file_set_contents()
+static gboolean write_cgroup_file(const gchar *cgroup, const gchar *file, const gchar *value, GError **error) {
+    gchar *path = g_build_filename(CGROUP_ROOT, cgroup, file, NULL);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    gboolean ok = fd >= 0 && write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    int err = errno;
+    if (fd >= 0) close(fd);
+    if (!ok && error && !*error) {
+        g_set_error(error, PROC_CONTROL_ERROR,
+                    err == ENOENT ? PROC_CONTROL_ERROR_UNSUPPORTED :
+                    (err == EPERM || err == EACCES) ? PROC_CONTROL_ERROR_PERMISSION : PROC_CONTROL_ERROR_FAILED,
+                    "Cannot write %s: %s", path, g_strerror(err));
+    }
+    g_free(path);
+    return ok;
+}
+
+/* A cgroup action in flight. Processes that only sit in a session scope are
+ * first moved into a transient scope; systemd starts it as a job, so the
+ * write waits for that job's JobRemoved signal instead of polling. */
+typedef struct {
+    GPtrArray *cgroups;     // relative to CGROUP_ROOT
+    gchar *file;
+    gchar *value;
+    gchar *unit;            // transient scope being started, or NULL
+    guint first_pid;        // a pid that should end up in @unit
+    GDBusConnection *bus;
+    guint job_signal;
+    guint timeout_source;
+    gboolean finished;
+} CgroupAction;
+
+#define SCOPE_START_TIMEOUT_MS 5000
+
+static void cgroup_action_free(gpointer data) {
+    CgroupAction *action = data;
+    g_ptr_array_free(action->cgroups, TRUE);
+    g_free(action->file);
+    g_free(action->value);
+    g_free(action->unit);
+    g_clear_object(&action->bus);
+    g_free(action);
+}
+
+// Writes to every cgroup found and completes @task, taking @error (may be NULL)
+static void cgroup_action_finish(GTask *task, GError *error) {
+    CgroupAction *action = g_task_get_task_data(task);
+    if (action->finished) {
+        if (error) g_error_free(error);
+        return;
+    }
+    action->finished = TRUE;
+    if (action->job_signal) {
+        g_dbus_connection_signal_unsubscribe(action->bus, action->job_signal);
+        action->job_signal = 0;
+    }
+    if (action->timeout_source) {
+        g_source_remove(action->timeout_source);
+        action->timeout_source = 0;
+    }
+
+    // Units that resolved still get the value when the transient scope failed
+    for (guint i = 0; i < action->cgroups->len; i++) {
+        write_cgroup_file(g_ptr_array_index(action->cgroups, i), action->file, action->value, &error);
+    }
+    if (error) g_task_return_error(task, error);
+    else g_task_return_boolean(task, TRUE);
+    g_object_unref(task);   // the reference held while the action ran
+}
+
+static void on_job_removed(GDBusConnection *bus, const gchar *sender, const gchar *object_path,
+                           const gchar *interface_name, const gchar *signal_name,
+                           GVariant *parameters, gpointer user_data) {
+    GTask *task = user_data;
+    CgroupAction *action = g_task_get_task_data(task);
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE("(uoss)"))) return;
+    const gchar *unit = NULL, *result = NULL;
+    g_variant_get(parameters, "(u&o&s&s)", NULL, NULL, &unit, &result);
+    if (g_strcmp0(unit, action->unit) != 0) return;
+
+    GError *error = NULL;
+    gchar *cgroup = read_pid_cgroup(action->first_pid);
+    if (g_strcmp0(result, "done") == 0 && cgroup && g_str_has_suffix(cgroup, action->unit)) {
+        g_ptr_array_add(action->cgroups, cgroup);
+    } else {
+        g_set_error(&error, PROC_CONTROL_ERROR, PROC_CONTROL_ERROR_FAILED,
+                    "Processes did not move into %s (%s)", action->unit, result);
+        g_free(cgroup);
+    }
+    cgroup_action_finish(task, error);
+}
+
+static gboolean on_scope_timeout(gpointer user_data) {
+    GTask *task = user_data;
+    CgroupAction *action = g_task_get_task_data(task);
+    action->timeout_source = 0;
+    GError *error = NULL;
+    g_set_error(&error, PROC_CONTROL_ERROR, PROC_CONTROL_ERROR_FAILED,
+                "Processes did not move into %s", action->unit);
+    cgroup_action_finish(task, error);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_start_transient_unit(GObject *source, GAsyncResult *result, gpointer user_data) {
+    GTask *task = user_data;
+    GError *error = NULL;
+    GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (reply) g_variant_unref(reply);
+    else cgroup_action_finish(task, error);
+    g_object_unref(task);
+}
+
+/* Ask the user's systemd instance to move @pids into a new transient scope;
+ * the action completes from on_job_removed() */
+static gboolean start_transient_scope(GTask *task, GArray *pids, GError **error) {
+    CgroupAction *action = g_task_get_task_data(task);
+    action->bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, error);
+    if (!action->bus) return FALSE;
+
+    // The manager only emits job signals to subscribed clients; repeats are harmless
+    static gboolean subscribed = FALSE;
+    if (!subscribed) {
+        g_dbus_connection_call(action->bus, "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
+                               "org.freedesktop.systemd1.Manager", "Subscribe", NULL, NULL,
+                               G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+        subscribed = TRUE;
+    }
+
+    static guint scope_serial = 0;
+    action->first_pid = g_array_index(pids, guint, 0);
+    action->unit = g_strdup_printf("khos-limit-%u-%u.scope", action->first_pid, ++scope_serial);
+
+    GVariantBuilder pid_builder;
+    g_variant_builder_init(&pid_builder, G_VARIANT_TYPE("au"));
+    for (guint i = 0; i < pids->len; i++) g_variant_builder_add(&pid_builder, "u", g_array_index(pids, guint, i));
+
+    GVariantBuilder props;
+    g_variant_builder_init(&props, G_VARIANT_TYPE("a(sv)"));
+    g_variant_builder_add(&props, "(sv)", "PIDs", g_variant_builder_end(&pid_builder));
+    g_variant_builder_add(&props, "(sv)", "Description", g_variant_new_string("Limited from KhazarOS System Monitor"));
+    // Let us write cpu.max / memory.high in the new scope
+    g_variant_builder_add(&props, "(sv)", "Delegate", g_variant_new_boolean(TRUE));
+
+    GVariantBuilder aux;
+    g_variant_builder_init(&aux, G_VARIANT_TYPE("a(sa(sv))"));
+
+    // Subscribed before the call, so the signal cannot be missed; matched on the unit name
+    action->job_signal = g_dbus_connection_signal_subscribe(action->bus, "org.freedesktop.systemd1",
+                                                            "org.freedesktop.systemd1.Manager", "JobRemoved",
+                                                            "/org/freedesktop/systemd1", NULL,
+                                                            G_DBUS_SIGNAL_FLAGS_NONE, on_job_removed, task, NULL);
+    action->timeout_source = g_timeout_add(SCOPE_START_TIMEOUT_MS, on_scope_timeout, task);
+    g_dbus_connection_call(action->bus, "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
+                           "org.freedesktop.systemd1.Manager", "StartTransientUnit",
+                           g_variant_new("(ssa(sv)a(sa(sv)))", action->unit, "fail", &props, &aux),
+                           G_VARIANT_TYPE("(o)"), G_DBUS_CALL_FLAGS_NONE, SCOPE_START_TIMEOUT_MS, NULL,
+                           on_start_transient_unit, g_object_ref(task));
+    return TRUE;
+}
+
+/* Write @value to @file in the cgroups that control @pids. With @create_scope
+ * the processes that only sit in a session scope get a transient scope first;
+ * without it they are skipped, e.g. when thawing, since nothing here could
+ * have frozen or capped them. */
+static void write_to_cgroups_async(GArray *pids, const gchar *file, const gchar *value,
+                                   gboolean create_scope, gboolean refuse_self,
+                                   GAsyncReadyCallback callback, gpointer user_data) {
+    GTask *task = g_task_new(NULL, NULL, callback, user_data);
+    CgroupAction *action = g_new0(CgroupAction, 1);
+    action->cgroups = g_ptr_array_new_with_free_func(g_free);
+    action->file = g_strdup(file);
+    action->value = g_strdup(value);
+    g_task_set_task_data(task, action, cgroup_action_free);
+
+    GArray *loose = g_array_new(FALSE, FALSE, sizeof(guint));
+    for (guint i = 0; i < pids->len; i++) {
+        guint pid = g_array_index(pids, guint, i);
+        gchar *cgroup = read_pid_cgroup(pid);
+        if (!cgroup) continue;   // exited, or no cgroup v2
+        if (!is_own_unit(cgroup)) {
+            g_array_append_val(loose, pid);
+            g_free(cgroup);
+        } else if (!g_ptr_array_find_with_equal_func(action->cgroups, cgroup, g_str_equal, NULL)) {
+            g_ptr_array_add(action->cgroups, cgroup);
+        } else {
+            g_free(cgroup);
+        }
+    }
+
+    GError *error = NULL;
+    if (refuse_self && contains_self(pids, action->cgroups)) {
+        // Freezing our own unit would hang the window that has to thaw it
+        g_set_error(&error, PROC_CONTROL_ERROR, PROC_CONTROL_ERROR_FAILED,
+                    "The selection includes the system monitor itself");
+        g_ptr_array_set_size(action->cgroups, 0);
+    } else if (create_scope && loose->len > 0) {
+        gboolean started = start_transient_scope(task, loose, &error);
+        g_array_free(loose, TRUE);
+        if (started) return;
+        cgroup_action_finish(task, error);
+        return;
+    } else if (action->cgroups->len == 0 && loose->len == 0) {
+        g_set_error(&error, PROC_CONTROL_ERROR, PROC_CONTROL_ERROR_UNSUPPORTED,
+                    "No cgroup v2 hierarchy found for the selected processes");
+    }
+    g_array_free(loose, TRUE);
+    cgroup_action_finish(task, error);
+}
+
+void proc_control_freeze_async(GArray *pids, gboolean frozen, GAsyncReadyCallback callback, gpointer user_data) {
+    write_to_cgroups_async(pids, "cgroup.freeze", frozen ? "1" : "0", frozen, frozen, callback, user_data);
+}
+
+void proc_control_set_cpu_max_async(GArray *pids, gint percent_of_cpu, GAsyncReadyCallback callback, gpointer user_data) {
+    gchar value[48];
+    if (percent_of_cpu <= 0) g_strlcpy(value, "max 100000", sizeof(value));
+    else snprintf(value, sizeof(value), "%d 100000", percent_of_cpu * 1000);   // quota per 100 ms period
+    write_to_cgroups_async(pids, "cpu.max", value, percent_of_cpu > 0, FALSE, callback, user_data);
+}
+
+void proc_control_set_memory_high_async(GArray *pids, guint64 bytes, GAsyncReadyCallback callback, gpointer user_data) {
+    gchar value[32];
+    if (bytes == 0) g_strlcpy(value, "max", sizeof(value));
+    else snprintf(value, sizeof(value), "%" G_GUINT64_FORMAT, bytes);
+    write_to_cgroups_async(pids, "memory.high", value, bytes > 0, FALSE, callback, user_data);
+}
+
+gboolean proc_control_cgroup_finish(GAsyncResult *result, GError **error) {
+    g_return_val_if_fail(g_task_is_valid(result, NULL), FALSE);
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
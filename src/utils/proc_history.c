@@ -0,0 +1,96 @@
+#include "utils/proc_history.h"
+#include <string.h>
+
+/* Rings are carved out of fixed-size chunks so that a busy system with pids
+ * coming and going reuses the same memory instead of churning the allocator. */
+#define PROC_HISTORY_CHUNK 64
+
+static GPtrArray *ring_chunks = NULL;   // ProcHistoryRing[PROC_HISTORY_CHUNK] blocks
+static GPtrArray *free_rings = NULL;    // stack of unused rings
+static GHashTable *ring_by_pid = NULL;  // pid -> ProcHistoryRing*
+
+static void ensure_pool(void) {
+    if (ring_by_pid) return;
+    ring_chunks = g_ptr_array_new_with_free_func(g_free);
+    free_rings = g_ptr_array_new();
+    ring_by_pid = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+static ProcHistoryRing* take_free_ring(void) {
+    if (free_rings->len == 0) {
+        ProcHistoryRing *chunk = g_new(ProcHistoryRing, PROC_HISTORY_CHUNK);
+        g_ptr_array_add(ring_chunks, chunk);
+        // Push in reverse so the first ring of the chunk is handed out first
+        for (gint i = PROC_HISTORY_CHUNK - 1; i >= 0; i--) {
+            g_ptr_array_add(free_rings, &chunk[i]);
+        }
+    }
+    return g_ptr_array_remove_index_fast(free_rings, free_rings->len - 1);
+}
+
+ProcHistoryRing* proc_history_lookup(guint pid) {
+    if (!ring_by_pid) return NULL;
+    return g_hash_table_lookup(ring_by_pid, GUINT_TO_POINTER(pid));
+}
+
+ProcHistoryRing* proc_history_acquire(guint pid) {
+    ensure_pool();
+    ProcHistoryRing *ring = g_hash_table_lookup(ring_by_pid, GUINT_TO_POINTER(pid));
+    if (!ring) {
+        ring = take_free_ring();
+        memset(ring, 0, sizeof(*ring));
+        ring->pid = pid;
+        g_hash_table_insert(ring_by_pid, GUINT_TO_POINTER(pid), ring);
+    }
+    ring->idle_ticks = 0;
+    return ring;
+}
+
+void proc_history_push(ProcHistoryRing *ring, gfloat cpu, gfloat mem_mb) {
+    if (!ring) return;
+    ring->cpu[ring->head] = cpu;
+    ring->mem[ring->head] = mem_mb;
+    ring->head = (ring->head + 1) % PROC_HISTORY_POINTS;
+    if (ring->count < PROC_HISTORY_POINTS) ring->count++;
+    ring->seen_this_cycle = TRUE;
+}
+
+void proc_history_begin_cycle(void) {
+    if (!ring_by_pid) return;
+    GHashTableIter it; gpointer key, value;
+    g_hash_table_iter_init(&it, ring_by_pid);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        ProcHistoryRing *ring = value;
+        ring->seen_this_cycle = FALSE;
+        ring->idle_ticks++;
+    }
+}
+
+void proc_history_end_cycle(void) {
+    if (!ring_by_pid) return;
+    GHashTableIter it; gpointer key, value;
+    g_hash_table_iter_init(&it, ring_by_pid);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        ProcHistoryRing *ring = value;
+        // Keep a ring for one full window after it stops being wanted so
+        // scrolling back and forth does not wipe the history.
+        if (!ring->seen_this_cycle || ring->idle_ticks > PROC_HISTORY_POINTS) {
+            g_hash_table_iter_remove(&it);
+            g_ptr_array_add(free_rings, ring);
+        }
+    }
+}
+
+guint proc_history_active_count(void) {
+    return ring_by_pid ? g_hash_table_size(ring_by_pid) : 0;
+}
+
+void proc_history_cleanup(void) {
+    if (!ring_by_pid) return;
+    g_hash_table_destroy(ring_by_pid);
+    g_ptr_array_free(free_rings, TRUE);
+    g_ptr_array_free(ring_chunks, TRUE);
+    ring_by_pid = NULL;
+    free_rings = NULL;
+    ring_chunks = NULL;
+}
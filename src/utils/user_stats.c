@@ -0,0 +1,75 @@
+#include "utils/user_stats.h"
+#include <pwd.h>
+
+static GHashTable *users = NULL;   // uid -> UserStats*
+
+static void free_user(gpointer data) {
+    UserStats *user = (UserStats*)data;
+    g_free(user->name);
+    g_free(user);
+}
+
+static gchar* lookup_user_name(guint uid) {
+    struct passwd pwd, *result = NULL;
+    char buf[1024];
+    if (getpwuid_r((uid_t)uid, &pwd, buf, sizeof(buf), &result) == 0 && result) {
+        return g_strdup(result->pw_name);
+    }
+    return g_strdup_printf("%u", uid);
+}
+
+void user_stats_begin_cycle(void) {
+    if (!users) users = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_user);
+    GHashTableIter it; gpointer value;
+    g_hash_table_iter_init(&it, users);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        UserStats *user = value;
+        user->cpu = 0.0;
+        user->mem_kb = 0;
+        user->io_kbps = 0.0;
+        user->nprocs = 0;
+        user->seen_this_cycle = FALSE;
+    }
+}
+
+void user_stats_add(guint uid, gdouble cpu, gulong mem_kb, gdouble io_kbps) {
+    if (!users) return;
+    UserStats *user = g_hash_table_lookup(users, GUINT_TO_POINTER(uid));
+    if (!user) {
+        user = g_new0(UserStats, 1);
+        user->uid = uid;
+        user->name = lookup_user_name(uid);   // once per user, not per tick
+        user->history.pid = uid;
+        g_hash_table_insert(users, GUINT_TO_POINTER(uid), user);
+    }
+    user->cpu += cpu;
+    user->mem_kb += mem_kb;
+    user->io_kbps += io_kbps;
+    user->nprocs++;
+    user->seen_this_cycle = TRUE;
+}
+
+void user_stats_end_cycle(void) {
+    if (!users) return;
+    GHashTableIter it; gpointer value;
+    g_hash_table_iter_init(&it, users);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        UserStats *user = value;
+        if (!user->seen_this_cycle) {
+            g_hash_table_iter_remove(&it);
+            continue;
+        }
+        proc_history_push(&user->history, (gfloat)MIN(user->cpu, 100.0), (gfloat)(user->mem_kb / 1024.0));
+    }
+}
+
+const UserStats* user_stats_get(guint uid) {
+    return users ? g_hash_table_lookup(users, GUINT_TO_POINTER(uid)) : NULL;
+}
+
+void user_stats_cleanup(void) {
+    if (users) {
+        g_hash_table_destroy(users);
+        users = NULL;
+    }
+}
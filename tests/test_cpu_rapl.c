@@ -0,0 +1,77 @@
+#include "cpu/cpu_rapl.h"
+#include "test_fixture.h"
+
+/* Drives the RAPL collector from a synthetic powercap tree: a package zone
+ * about to wrap at max_energy_range_uj and a core subzone under it. */
+
+#define SECOND_US G_USEC_PER_SEC
+#define MAX_RANGE_UJ 262143328850ULL
+
+static gchar *root = NULL;
+
+static void write_zone_file(const gchar *zone, const gchar *file, const gchar *contents) {
+    gchar *rel = g_build_filename(zone, file, NULL);
+    test_fixture_write(root, rel, contents);
+    g_free(rel);
+}
+
+static void set_energy(const gchar *zone, guint64 uj) {
+    gchar *text = g_strdup_printf("%" G_GUINT64_FORMAT "\n", uj);
+    write_zone_file(zone, "energy_uj", text);
+    g_free(text);
+}
+
+static void add_zone(const gchar *zone, const gchar *name, guint64 max_range_uj, guint64 energy_uj) {
+    gchar *text = g_strdup_printf("%s\n", name);
+    write_zone_file(zone, "name", text);
+    g_free(text);
+    text = g_strdup_printf("%" G_GUINT64_FORMAT "\n", max_range_uj);
+    write_zone_file(zone, "max_energy_range_uj", text);
+    g_free(text);
+    set_energy(zone, energy_uj);
+}
+
+static void test_wraparound(void) {
+    root = test_fixture_make_root("khos-rapl-XXXXXX");
+    add_zone("intel-rapl:0", "package-0", MAX_RANGE_UJ, MAX_RANGE_UJ - 5000000);
+    add_zone("intel-rapl:0:0", "core", MAX_RANGE_UJ, 1000000);
+    write_zone_file("intel-rapl-mmio:0", "name", "package-0\n");
+
+    cpu_rapl_init(root);
+    g_assert_cmpint(cpu_rapl_get_domain_count(), ==, 2);
+    g_assert_cmpstr(cpu_rapl_get_domain_name(0), ==, "package-0");
+    g_assert_true(cpu_rapl_is_package(0));
+    g_assert_cmpstr(cpu_rapl_get_domain_name(1), ==, "package-0/core");
+    g_assert_false(cpu_rapl_is_package(1));
+
+    // Settle the timestamps from init on a clock the test controls
+    gint64 now_us = g_get_monotonic_time() + SECOND_US;
+    cpu_rapl_update_at(now_us);
+
+    // 5 J before the wrap plus 15 J after it, over 2 s
+    set_energy("intel-rapl:0", 15000000);
+    set_energy("intel-rapl:0:0", 9000000);
+    now_us += 2 * SECOND_US;
+    cpu_rapl_update_at(now_us);
+    g_assert_cmpfloat_with_epsilon(cpu_rapl_get_watts(0), 10.0, 1e-9);
+    g_assert_cmpfloat_with_epsilon(cpu_rapl_get_watts(1), 4.0, 1e-9);
+
+    gint newest = (cpu_rapl_get_history_index() + MAX_POINTS - 1) % MAX_POINTS;
+    g_assert_cmpfloat_with_epsilon(cpu_rapl_get_history(0)[newest], 10.0, 1e-9);
+
+    // Past the wrap the counter simply counts up again
+    set_energy("intel-rapl:0", 27000000);
+    now_us += SECOND_US;
+    cpu_rapl_update_at(now_us);
+    g_assert_cmpfloat_with_epsilon(cpu_rapl_get_watts(0), 12.0, 1e-9);
+
+    cpu_rapl_cleanup();
+    test_fixture_remove(root);
+    g_clear_pointer(&root, g_free);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/cpu-rapl/wraparound", test_wraparound);
+    return g_test_run();
+}
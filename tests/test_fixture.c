@@ -0,0 +1,41 @@
+#include "test_fixture.h"
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+gchar* test_fixture_make_root(const gchar *tmpl) {
+    GError *error = NULL;
+    gchar *root = g_dir_make_tmp(tmpl, &error);
+    g_assert_no_error(error);
+    return root;
+}
+
+void test_fixture_write(const gchar *root, const gchar *rel_path, const gchar *contents) {
+    gchar *path = g_build_filename(root, rel_path, NULL);
+    gchar *dir = g_path_get_dirname(path);
+    g_assert_cmpint(g_mkdir_with_parents(dir, 0755), ==, 0);
+    FILE *fp = fopen(path, "w");
+    g_assert_nonnull(fp);
+    fputs(contents, fp);
+    fclose(fp);
+    g_free(dir);
+    g_free(path);
+}
+
+void test_fixture_remove(const gchar *root) {
+    GDir *dir = g_dir_open(root, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir)) != NULL) {
+            gchar *child = g_build_filename(root, name, NULL);
+            // fd/<n> links point at real devices and directories; only the link goes
+            if (!g_file_test(child, G_FILE_TEST_IS_SYMLINK) && g_file_test(child, G_FILE_TEST_IS_DIR)) {
+                test_fixture_remove(child);
+            } else {
+                g_unlink(child);
+            }
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_rmdir(root);
+}
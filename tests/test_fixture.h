@@ -0,0 +1,19 @@
+#ifndef TEST_FIXTURE_H
+#define TEST_FIXTURE_H
+
+#include <glib.h>
+
+/* Scratch /proc and /sys trees for the collector tests. */
+
+// New empty directory under the system temp dir; @tmpl ends in XXXXXX
+gchar* test_fixture_make_root(const gchar *tmpl);
+
+/* Writes @contents to @root/@rel_path, creating parent directories. The file
+ * is rewritten in place, not replaced, so fds the collector keeps open see
+ * the new contents. */
+void test_fixture_write(const gchar *root, const gchar *rel_path, const gchar *contents);
+
+// Deletes @root and everything below it; symlinks are removed, never followed
+void test_fixture_remove(const gchar *root);
+
+#endif // TEST_FIXTURE_H
@@ -0,0 +1,238 @@
+#include "gpu/gpu_fdinfo.h"
+#include "test_fixture.h"
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Drives the DRM fdinfo collector from a synthetic procfs tree: one
+ * directory per pid with stat, comm, fd/<n> symlinks and fdinfo/<n>. */
+
+#define SECOND_US G_USEC_PER_SEC
+
+static gchar *root = NULL;
+static gint64 now_us = 0;
+
+static void write_file(guint pid, const gchar *file, const gchar *contents) {
+    gchar *rel = g_strdup_printf("%u/%s", pid, file);
+    test_fixture_write(root, rel, contents);
+    g_free(rel);
+}
+
+static void add_process(guint pid, const gchar *comm, guint64 starttime) {
+    gchar *fd_dir = g_strdup_printf("%s/%u/fd", root, pid);
+    g_assert_cmpint(g_mkdir_with_parents(fd_dir, 0755), ==, 0);
+    g_free(fd_dir);
+
+    gchar *text = g_strdup_printf("%s\n", comm);
+    write_file(pid, "comm", text);
+    g_free(text);
+
+    // Fields 3-21 do not matter here; field 22 is the start time
+    text = g_strdup_printf("%u (%s) S 1 1 1 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 %" G_GUINT64_FORMAT " 0 0\n",
+                           pid, comm, starttime);
+    write_file(pid, "stat", text);
+    g_free(text);
+}
+
+static void set_fd(guint pid, gint fd, const gchar *target, const gchar *fdinfo) {
+    gchar *link = g_strdup_printf("%s/%u/fd/%d", root, pid, fd);
+    gchar *info = g_strdup_printf("fdinfo/%d", fd);
+    g_unlink(link);
+    g_assert_cmpint(symlink(target, link), ==, 0);
+    write_file(pid, info, fdinfo);
+    g_free(info);
+    g_free(link);
+}
+
+static void remove_fd(guint pid, gint fd) {
+    gchar *link = g_strdup_printf("%s/%u/fd/%d", root, pid, fd);
+    gchar *info = g_strdup_printf("%s/%u/fdinfo/%d", root, pid, fd);
+    g_unlink(link);
+    g_unlink(info);
+    g_free(info);
+    g_free(link);
+}
+
+static gchar* render_fdinfo(guint64 client_id, guint64 busy_ns, const gchar *vram) {
+    return g_strdup_printf("pos:\t0\nflags:\t02100002\n"
+                           "drm-driver:\ti915\ndrm-pdev:\t0000:00:02.0\n"
+                           "drm-client-id:\t%" G_GUINT64_FORMAT "\n"
+                           "drm-engine-render:\t%" G_GUINT64_FORMAT " ns\n"
+                           "drm-engine-video:\t0 ns\n"
+                           "drm-resident-local0:\t%s\ndrm-resident-system0:\t4 MiB\n",
+                           client_id, busy_ns, vram);
+}
+
+static gchar* cycles_fdinfo(guint64 client_id, guint64 cycles, guint64 total_cycles) {
+    return g_strdup_printf("drm-driver:\txe\ndrm-pdev:\t0000:03:00.0\n"
+                           "drm-client-id:\t%" G_GUINT64_FORMAT "\n"
+                           "drm-cycles-rcs:\t%" G_GUINT64_FORMAT "\n"
+                           "drm-total-cycles-rcs:\t%" G_GUINT64_FORMAT "\n",
+                           client_id, cycles, total_cycles);
+}
+
+static void update(void) {
+    now_us += SECOND_US;
+    gpu_fdinfo_update_at(now_us);
+}
+
+static void fixture_setup(void) {
+    root = test_fixture_make_root("khos-fdinfo-XXXXXX");
+    gpu_fdinfo_set_proc_root(root);
+    now_us = 10 * SECOND_US;
+}
+
+static void fixture_teardown(void) {
+    gpu_fdinfo_cleanup();
+    test_fixture_remove(root);
+    g_clear_pointer(&root, g_free);
+}
+
+static void test_parse(void) {
+    DrmFdinfo info;
+    gchar *text = render_fdinfo(42, 1500, "256 MiB");
+    g_assert_true(gpu_fdinfo_parse(text, &info));
+    g_free(text);
+    g_assert_cmpstr(info.driver, ==, "i915");
+    g_assert_cmpstr(info.pdev, ==, "0000:00:02.0");
+    g_assert_true(info.has_client_id);
+    g_assert_cmpuint(info.client_id, ==, 42);
+    g_assert_cmpuint(info.n_engines, ==, 2);
+    g_assert_cmpstr(info.engines[0].name, ==, "render");
+    g_assert_cmpuint(info.engines[0].busy_ns, ==, 1500);
+    g_assert_cmpuint(info.engines[0].capacity, ==, 1);
+    g_assert_cmpuint(info.vram_bytes, ==, 256ULL * 1024 * 1024);
+    g_assert_cmpuint(info.system_bytes, ==, 4ULL * 1024 * 1024);
+
+    // Legacy drm-memory-* only counts when there is no drm-resident-*
+    g_assert_true(gpu_fdinfo_parse("drm-driver: amdgpu\ndrm-client-id: 1\n"
+                                   "drm-engine-capacity-gfx: 2\ndrm-engine-gfx: 10 ns\n"
+                                   "drm-memory-vram: 512 KiB\ndrm-memory-gtt: 1 GiB\n", &info));
+    g_assert_cmpuint(info.engines[0].capacity, ==, 2);
+    g_assert_cmpuint(info.vram_bytes, ==, 512ULL * 1024);
+    g_assert_cmpuint(info.system_bytes, ==, 1024ULL * 1024 * 1024);
+
+    g_assert_false(gpu_fdinfo_parse("pos: 0\nflags: 0100002\nmnt_id: 25\n", &info));
+}
+
+static void test_engine_deltas(void) {
+    fixture_setup();
+    add_process(100, "game", 5000);
+    gchar *text = render_fdinfo(7, 1000000000ULL, "64 MiB");
+    set_fd(100, 3, "/dev/dri/renderD128", text);
+    g_free(text);
+    set_fd(100, 4, "/dev/null", "pos:\t0\nflags:\t02\n");
+
+    // The first sample has nothing to compare with
+    update();
+    const GpuProcessUsage *u = gpu_fdinfo_get_process(100);
+    g_assert_nonnull(u);
+    g_assert_cmpstr(u->comm, ==, "game");
+    g_assert_cmpfloat(u->busy_percent, ==, 0.0);
+    g_assert_cmpuint(u->vram_bytes, ==, 64ULL * 1024 * 1024);
+
+    // 0.5 s of render time in a 1 s interval
+    text = render_fdinfo(7, 1500000000ULL, "64 MiB");
+    set_fd(100, 3, "/dev/dri/renderD128", text);
+    g_free(text);
+    update();
+    u = gpu_fdinfo_get_process(100);
+    g_assert_cmpfloat_with_epsilon(u->busy_percent, 50.0, 0.01);
+    g_assert_cmpstr(u->busy_engine, ==, "render");
+
+    // Cycle counters win over wall time when the driver has them
+    add_process(200, "encoder", 6000);
+    text = cycles_fdinfo(9, 100, 1000);
+    set_fd(200, 5, "/dev/dri/renderD129", text);
+    g_free(text);
+    update();
+    text = cycles_fdinfo(9, 400, 2000);
+    set_fd(200, 5, "/dev/dri/renderD129", text);
+    g_free(text);
+    update();
+    u = gpu_fdinfo_get_process(200);
+    g_assert_nonnull(u);
+    g_assert_cmpfloat_with_epsilon(u->busy_percent, 30.0, 0.01);
+
+    // A reset counter is a new baseline, not a huge delta
+    text = cycles_fdinfo(9, 50, 3000);
+    set_fd(200, 5, "/dev/dri/renderD129", text);
+    g_free(text);
+    update();
+    g_assert_cmpfloat(gpu_fdinfo_get_process(200)->busy_percent, ==, 0.0);
+    text = cycles_fdinfo(9, 350, 4000);
+    set_fd(200, 5, "/dev/dri/renderD129", text);
+    g_free(text);
+    update();
+    g_assert_cmpfloat_with_epsilon(gpu_fdinfo_get_process(200)->busy_percent, 30.0, 0.01);
+
+    const GpuProcessUsage *top[4];
+    g_assert_cmpuint(gpu_fdinfo_get_top("0000:03:00.0", top, G_N_ELEMENTS(top)), ==, 1);
+    g_assert_cmpuint(top[0]->pid, ==, 200);
+    g_assert_cmpuint(gpu_fdinfo_get_top(NULL, top, G_N_ELEMENTS(top)), ==, 2);
+    fixture_teardown();
+}
+
+static void test_shared_client_counted_once(void) {
+    fixture_setup();
+    add_process(100, "compositor", 5000);
+    gchar *text = render_fdinfo(7, 0, "100 MiB");
+    set_fd(100, 3, "/dev/dri/card0", text);
+    set_fd(100, 8, "/dev/dri/card0", text);   // dup() of the same client
+    g_free(text);
+    update();
+    const GpuProcessUsage *u = gpu_fdinfo_get_process(100);
+    g_assert_nonnull(u);
+    g_assert_cmpuint(u->vram_bytes, ==, 100ULL * 1024 * 1024);
+    fixture_teardown();
+}
+
+static void test_fd_cache(void) {
+    fixture_setup();
+    add_process(100, "game", 5000);
+    gchar *text = render_fdinfo(7, 0, "64 MiB");
+    set_fd(100, 3, "/dev/dri/renderD128", text);
+    g_free(text);
+    add_process(300, "idle", 5100);
+    update();
+    g_assert_nonnull(gpu_fdinfo_get_process(100));
+    g_assert_null(gpu_fdinfo_get_process(300));
+
+    // A DRM fd opened later is found when the fd table is walked again
+    text = render_fdinfo(11, 0, "32 MiB");
+    set_fd(300, 6, "/dev/dri/renderD128", text);
+    g_free(text);
+    gboolean found = FALSE;
+    for (gint i = 0; i < 20 && !found; i++) {
+        update();
+        found = gpu_fdinfo_get_process(300) != NULL;
+    }
+    g_assert_true(found);
+
+    // A closed fd drops out on the next scan
+    remove_fd(100, 3);
+    update();
+    g_assert_null(gpu_fdinfo_get_process(100));
+
+    // A reused pid is a new process: new fds, new name
+    add_process(100, "other", 9000);
+    text = render_fdinfo(12, 0, "16 MiB");
+    set_fd(100, 3, "/dev/dri/renderD128", text);
+    g_free(text);
+    update();
+    const GpuProcessUsage *u = gpu_fdinfo_get_process(100);
+    g_assert_nonnull(u);
+    g_assert_cmpstr(u->comm, ==, "other");
+    g_assert_cmpuint(u->vram_bytes, ==, 16ULL * 1024 * 1024);
+    fixture_teardown();
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/gpu-fdinfo/parse", test_parse);
+    g_test_add_func("/gpu-fdinfo/engine-deltas", test_engine_deltas);
+    g_test_add_func("/gpu-fdinfo/shared-client", test_shared_client_counted_once);
+    g_test_add_func("/gpu-fdinfo/fd-cache", test_fd_cache);
+    return g_test_run();
+}